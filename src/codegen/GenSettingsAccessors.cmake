@@ -0,0 +1,142 @@
+# Generates a header with typed cached accessors for the settings
+# declared in a settings XML file.
+#
+# Usage:
+#	cmake -DXML=<settings.xml> -DOUT=<header.h> -DNAMESPACE=<A::B> -P GenSettingsAccessors.cmake
+#
+# The resulting header declares the XmlSettingsAccessors class in the
+# given namespace. It subscribes to the settings manager passed to its
+# constructor via BaseSettingsManager::RegisterSetting() and keeps a
+# copy of each setting, so reading a setting is just a member access.
+#
+# Only items having a property that is a valid C++ identifier are
+# exported. The C++ type is deduced from the item type:
+#	checkbox, checkable groupbox	bool
+#	spinbox				int
+#	doublespinbox			double
+#	lineedit, path, combobox, radio	QString
+#	everything else			QVariant
+
+if (NOT XML OR NOT OUT OR NOT NAMESPACE)
+	message (FATAL_ERROR "XML, OUT and NAMESPACE should be set")
+endif ()
+
+file (READ "${XML}" _content)
+string (REPLACE ";" "" _content "${_content}")
+string (REGEX MATCHALL "<item[ \t\r\n][^>]*>" _items "${_content}")
+
+set (_props)
+set (_members)
+set (_registrations)
+set (_getters)
+
+foreach (_item ${_items})
+	set (_prop "")
+	if (_item MATCHES "[ \t\r\n]property=\"([A-Za-z_][A-Za-z0-9_]*)\"")
+		set (_prop "${CMAKE_MATCH_1}")
+		list (FIND _props "${_prop}" _propIdx)
+		if (NOT _propIdx EQUAL -1)
+			set (_prop "")
+		endif ()
+	endif ()
+
+	set (_type "")
+	if (_item MATCHES "[ \t\r\n]type=\"([a-z]+)\"")
+		set (_type "${CMAKE_MATCH_1}")
+	endif ()
+
+	set (_default "")
+	if (_item MATCHES "[ \t\r\n]default=\"([^\"]*)\"")
+		set (_default "${CMAKE_MATCH_1}")
+	endif ()
+
+	set (_cppType "QVariant")
+	set (_conv "")
+	set (_init "")
+	if (_type STREQUAL "checkbox" OR
+			(_type STREQUAL "groupbox" AND _item MATCHES "checkable=\"true\""))
+		set (_cppType "bool")
+		set (_conv "toBool ()")
+		if (_default STREQUAL "true")
+			set (_init " = true")
+		else ()
+			set (_init " = false")
+		endif ()
+	elseif (_type STREQUAL "spinbox")
+		set (_cppType "int")
+		set (_conv "toInt ()")
+		if (_default MATCHES "^-?[0-9]+$")
+			set (_init " = ${_default}")
+		else ()
+			set (_init " = 0")
+		endif ()
+	elseif (_type STREQUAL "doublespinbox")
+		set (_cppType "double")
+		set (_conv "toDouble ()")
+		if (_default MATCHES "^-?[0-9]+(\\.[0-9]+)?$")
+			set (_init " = ${_default}")
+		else ()
+			set (_init " = 0")
+		endif ()
+	elseif (_type STREQUAL "lineedit" OR _type STREQUAL "path" OR
+			_type STREQUAL "combobox" OR _type STREQUAL "radio")
+		set (_cppType "QString")
+		set (_conv "toString ()")
+	elseif (_type STREQUAL "groupbox" OR _type STREQUAL "pushbutton" OR
+			_type STREQUAL "customwidget" OR _type STREQUAL "dataview")
+		set (_prop "")
+	endif ()
+
+	if (_prop)
+		list (APPEND _props "${_prop}")
+
+		if (_conv)
+			set (_value "value.${_conv}")
+		else ()
+			set (_value "value")
+		endif ()
+
+		set (_members "${_members}\t\t${_cppType} ${_prop}_${_init};\n")
+		set (_registrations "${_registrations}\t\t\tmgr->RegisterSetting (\"${_prop}\",\n\t\t\t\t\t[this] (const QVariant& value) { ${_prop}_ = ${_value}; });\n")
+		set (_getters "${_getters}\n\t\t${_cppType} ${_prop} () const\n\t\t{\n\t\t\treturn ${_prop}_;\n\t\t}\n")
+	endif ()
+endforeach ()
+
+string (REPLACE "::" ";" _nsParts "${NAMESPACE}")
+set (_nsOpen "")
+set (_nsClose "")
+foreach (_ns ${_nsParts})
+	set (_nsOpen "${_nsOpen}namespace ${_ns}\n{\n")
+	set (_nsClose "${_nsClose}}\n")
+endforeach ()
+
+get_filename_component (_xmlName "${XML}" NAME)
+
+set (_result "// Generated from ${_xmlName} by GenSettingsAccessors.cmake, do not edit.
+
+#pragma once
+
+#include <QString>
+#include <QVariant>
+#include <xmlsettingsdialog/basesettingsmanager.h>
+
+${_nsOpen}	class XmlSettingsAccessors
+	{
+${_members}
+		XmlSettingsAccessors (const XmlSettingsAccessors&) = delete;
+		XmlSettingsAccessors& operator= (const XmlSettingsAccessors&) = delete;
+	public:
+		XmlSettingsAccessors (Util::BaseSettingsManager *mgr)
+		{
+${_registrations}		}
+${_getters}	};
+${_nsClose}")
+
+if (EXISTS "${OUT}")
+	file (READ "${OUT}" _old)
+	if (_old STREQUAL _result)
+		return ()
+	endif ()
+endif ()
+
+file (WRITE "${OUT}" "${_result}")
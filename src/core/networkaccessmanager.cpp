@@ -353,9 +353,21 @@ void LeechCraft::NetworkAccessManager::saveCookies () const
 		return;
 	}
 
+	const bool saveEnabled = !XmlSettingsManager::Instance ()->
+			property ("DeleteCookiesOnExit").toBool ();
+
 	QFile file (QDir::homePath () +
 			"/.leechcraft/core/cookies.txt");
-	if (!file.open (QIODevice::WriteOnly | QIODevice::Truncate))
+
+	// Append only the changed cookies unless the jar asks for a full
+	// rewrite or the file has been emptied.
+	const bool incremental = saveEnabled &&
+			!CookieJar_->NeedsFullSave () &&
+			file.size () > 0;
+	const auto mode = incremental ?
+			QIODevice::WriteOnly | QIODevice::Append :
+			QIODevice::WriteOnly | QIODevice::Truncate;
+	if (!file.open (mode))
 	{
 		emit error (tr ("Could not save cookies, error opening cookie file."));
 		qWarning () << Q_FUNC_INFO
@@ -363,9 +375,15 @@ void LeechCraft::NetworkAccessManager::saveCookies () const
 		return;
 	}
 
-	const bool saveEnabled = !XmlSettingsManager::Instance ()->
-			property ("DeleteCookiesOnExit").toBool ();
-	file.write (saveEnabled ? CookieJar_->Save () : QByteArray ());
+	if (incremental)
+	{
+		file.write (CookieJar_->SaveChanges ());
+		return;
+	}
+
+	const auto& data = saveEnabled ? CookieJar_->Save () : QByteArray ();
+	if (file.write (data) == data.size ())
+		CookieJar_->MarkSaved ();
 }
 
 void LeechCraft::NetworkAccessManager::handleFilterTrackingCookies ()
@@ -0,0 +1,154 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "coalescer.h"
+#include <algorithm>
+#include <QTimer>
+#include <interfaces/an/entityfields.h>
+#include "xmlsettingsmanager.h"
+
+namespace LeechCraft
+{
+namespace AdvancedNotifications
+{
+	Coalescer::Coalescer (QObject *parent)
+	: QObject (parent)
+	, FlushTimer_ (new QTimer (this))
+	{
+		Clock_.start ();
+
+		FlushTimer_->setSingleShot (true);
+		connect (FlushTimer_,
+				SIGNAL (timeout ()),
+				this,
+				SLOT (flush ()));
+
+		XmlSettingsManager::Instance ().RegisterObject ({ "CoalesceNotifications", "CoalesceBurst", "CoalesceWindow" },
+				this, "handleSettingsChanged");
+		handleSettingsChanged ();
+	}
+
+	bool Coalescer::Admit (const Entity& e, const QList<NotificationRule>& rules)
+	{
+		if (!Enabled_)
+			return true;
+
+		const auto& key = e.Additional_ ["org.LC.AdvNotifications.SenderID"].toString () +
+				'/' + e.Additional_ ["org.LC.AdvNotifications.EventCategory"].toString ();
+
+		auto& source = Sources_ [key];
+
+		const auto now = Clock_.elapsed ();
+		if (now - source.WindowStart_ >= Window_)
+		{
+			source.WindowStart_ = now;
+			source.Count_ = 0;
+		}
+
+		if (++source.Count_ <= Burst_)
+			return true;
+
+		++source.Suppressed_;
+		source.Last_ = e;
+		source.Rules_ = rules;
+
+		if (!FlushTimer_->isActive ())
+			FlushTimer_->start (static_cast<int> (Window_ - (now - source.WindowStart_)));
+
+		return false;
+	}
+
+	void Coalescer::flush ()
+	{
+		const auto now = Clock_.elapsed ();
+
+		QList<QPair<Entity, QList<NotificationRule>>> summaries;
+		qint64 nextFlush = -1;
+		for (auto i = Sources_.begin (); i != Sources_.end (); )
+		{
+			auto& source = *i;
+
+			const auto age = now - source.WindowStart_;
+			if (!source.Suppressed_)
+			{
+				if (age >= Window_)
+					i = Sources_.erase (i);
+				else
+					++i;
+				continue;
+			}
+
+			if (age < Window_)
+			{
+				const auto left = Window_ - age;
+				if (nextFlush == -1 || left < nextFlush)
+					nextFlush = left;
+				++i;
+				continue;
+			}
+
+			auto e = source.Last_;
+
+			const auto& lastText = e.Additional_ [AN::EF::FullText].toString ();
+			const auto& text = tr ("%n more notification(s) were suppressed, the last one: %1",
+						0, source.Suppressed_)
+					.arg (lastText);
+			e.Additional_ ["Text"] = text;
+			e.Additional_ [AN::EF::FullText] = text;
+			e.Additional_ [AN::EF::ExtendedText] = text;
+			e.Additional_ [AN::EF::EventID] = "org.LC.AdvNotifications.Coalesced/" + i.key ();
+
+			summaries.append (qMakePair (e, source.Rules_));
+
+			// Keep the source saturated so that a storm that is still going
+			// on yields a single summary per window.
+			source.WindowStart_ = now;
+			source.Count_ = Burst_;
+			source.Suppressed_ = 0;
+			source.Last_ = Entity ();
+			source.Rules_.clear ();
+			++i;
+		}
+
+		if (nextFlush != -1)
+			FlushTimer_->start (static_cast<int> (nextFlush));
+
+		for (const auto& pair : summaries)
+			emit coalesced (pair.first, pair.second);
+	}
+
+	void Coalescer::handleSettingsChanged ()
+	{
+		const auto& xsm = XmlSettingsManager::Instance ();
+		Enabled_ = xsm.property ("CoalesceNotifications").toBool ();
+		Burst_ = std::max (xsm.property ("CoalesceBurst").toInt (), 1);
+		Window_ = std::max (xsm.property ("CoalesceWindow").toInt (), 100);
+	}
+}
+}
@@ -0,0 +1,93 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QElapsedTimer>
+#include <interfaces/structures.h>
+#include "notificationrule.h"
+
+class QTimer;
+
+namespace LeechCraft
+{
+namespace AdvancedNotifications
+{
+	/** @brief Rate-limits transient notifications from a single source.
+	 *
+	 * Notifications are grouped by their sender and category. Up to a
+	 * configured number of notifications from each group are let
+	 * through during a time window, and the rest are merged into a
+	 * single summary notification emitted when the window ends.
+	 */
+	class Coalescer : public QObject
+	{
+		Q_OBJECT
+
+		struct Source
+		{
+			qint64 WindowStart_ = 0;
+			int Count_ = 0;
+
+			int Suppressed_ = 0;
+			Entity Last_;
+			QList<NotificationRule> Rules_;
+		};
+		QHash<QString, Source> Sources_;
+
+		QElapsedTimer Clock_;
+		QTimer * const FlushTimer_;
+
+		bool Enabled_ = true;
+		int Burst_ = 3;
+		int Window_ = 2000;
+	public:
+		Coalescer (QObject* = 0);
+
+		/** @brief Checks whether the notification should be shown now.
+		 *
+		 * If this function returns false, the entity is remembered and
+		 * accounted in the summary later emitted via coalesced().
+		 *
+		 * @param[in] e The notification entity.
+		 * @param[in] rules The rules matching the entity.
+		 * @return Whether transient notifications for e should be shown.
+		 */
+		bool Admit (const Entity& e, const QList<NotificationRule>& rules);
+	private slots:
+		void flush ();
+		void handleSettingsChanged ();
+	signals:
+		void coalesced (const LeechCraft::Entity&,
+				const QList<LeechCraft::AdvancedNotifications::NotificationRule>&);
+	};
+}
+}
@@ -30,7 +30,6 @@
 #include "core.h"
 #include <util/sys/resourceloader.h>
 #include "notificationruleswidget.h"
-#include "typedmatchers.h"
 #include "rulesmanager.h"
 #include "xmlsettingsmanager.h"
 
@@ -87,40 +86,7 @@ namespace AdvancedNotifications
 
 	QList<NotificationRule> Core::GetRules (const Entity& e) const
 	{
-		const QString& type = e.Additional_ ["org.LC.AdvNotifications.EventType"].toString ();
-
-		QList<NotificationRule> result;
-
-		for (const auto& rule : RulesManager_->GetRulesList ())
-		{
-			if (!rule.IsEnabled ())
-				continue;
-
-			if (!rule.GetTypes ().contains (type))
-				continue;
-
-			bool fieldsMatch = true;
-			for (const auto& match : rule.GetFieldMatches ())
-			{
-				const QString& fieldName = match.GetFieldName ();
-				const auto& matcher = match.GetMatcher ();
-				if (!matcher->Match (e.Additional_ [fieldName]))
-				{
-					fieldsMatch = false;
-					break;
-				}
-			}
-
-			if (!fieldsMatch)
-				continue;
-
-			if (rule.IsSingleShot ())
-				RulesManager_->SetRuleEnabled (rule, false);
-
-			result << rule;
-		}
-
-		return result;
+		return RulesManager_->GetMatchingRules (e);
 	}
 
 	QString Core::GetAbsoluteAudioPath (const QString& fname) const
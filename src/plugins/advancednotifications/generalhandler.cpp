@@ -39,13 +39,20 @@
 #include "core.h"
 #include "wmurgenthandler.h"
 #include "rulesmanager.h"
+#include "coalescer.h"
 
 namespace LeechCraft
 {
 namespace AdvancedNotifications
 {
+	namespace
+	{
+		const NotificationMethods TransientMethods = NMVisual | NMAudio | NMSystemDependent;
+	}
+
 	GeneralHandler::GeneralHandler (ICoreProxy_ptr proxy)
-	: Proxy_ (proxy)
+	: Coalescer_ (new Coalescer (this))
+	, Proxy_ (proxy)
 	{
 		QList<ConcreteHandlerBase_ptr> coreHandlers;
 		coreHandlers << ConcreteHandlerBase_ptr (new SystemTrayHandler);
@@ -71,6 +78,11 @@ namespace AdvancedNotifications
 		Cat2IconName_ [AN::CatGeneric] = "preferences-desktop-notification-bell";
 		Cat2IconName_ [AN::CatPackageManager] = "system-software-update";
 		Cat2IconName_ [AN::CatMediaPlayer] = "applications-multimedia";
+
+		connect (Coalescer_,
+				SIGNAL (coalesced (LeechCraft::Entity, QList<LeechCraft::AdvancedNotifications::NotificationRule>)),
+				this,
+				SLOT (handleCoalesced (LeechCraft::Entity, QList<LeechCraft::AdvancedNotifications::NotificationRule>)));
 	}
 
 	void GeneralHandler::RegisterHandler (const INotificationHandler_ptr& handler)
@@ -94,16 +106,18 @@ namespace AdvancedNotifications
 		}
 
 		const auto& rules = Core::Instance ().GetRules (e);
+		if (rules.isEmpty ())
+			return;
+
+		// Persistent notifications like tray counters and urgency hints
+		// track each event, so only the transient ones are coalesced.
+		const bool admitted = Coalescer_->Admit (e, rules);
 		for (const auto& rule : rules)
 		{
-			const auto& methods = rule.GetMethods ();
-			for (const auto& handler : Handlers_)
-			{
-				if (!(methods & handler->GetHandlerMethod ()))
-					continue;
-
-				handler->Handle (e, rule);
-			}
+			auto methods = rule.GetMethods ();
+			if (!admitted)
+				methods &= ~TransientMethods;
+			Dispatch (e, rule, methods);
 		}
 	}
 
@@ -117,5 +131,23 @@ namespace AdvancedNotifications
 		const QString& name = Cat2IconName_.value (cat, "general");
 		return Proxy_->GetIconThemeManager ()->GetIcon (name);
 	}
+
+	void GeneralHandler::Dispatch (const Entity& e,
+			const NotificationRule& rule, NotificationMethods methods)
+	{
+		for (const auto& handler : Handlers_)
+		{
+			if (!(methods & handler->GetHandlerMethod ()))
+				continue;
+
+			handler->Handle (e, rule);
+		}
+	}
+
+	void GeneralHandler::handleCoalesced (const Entity& e, const QList<NotificationRule>& rules)
+	{
+		for (const auto& rule : rules)
+			Dispatch (e, rule, rule.GetMethods () & TransientMethods);
+	}
 }
 }
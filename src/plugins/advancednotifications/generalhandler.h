@@ -35,16 +35,20 @@
 #include <interfaces/iinfo.h>
 #include <interfaces/iactionsexporter.h>
 #include "concretehandlerbase.h"
+#include "notificationrule.h"
 
 namespace LeechCraft
 {
 namespace AdvancedNotifications
 {
+	class Coalescer;
+
 	class GeneralHandler : public QObject
 	{
 		Q_OBJECT
 
 		QList<INotificationHandler_ptr> Handlers_;
+		Coalescer * const Coalescer_;
 
 		ICoreProxy_ptr Proxy_;
 		QMap<QString, QString> Cat2IconName_;
@@ -57,6 +61,11 @@ namespace AdvancedNotifications
 
 		ICoreProxy_ptr GetProxy () const;
 		QIcon GetIconForCategory (const QString&) const;
+	private:
+		void Dispatch (const Entity&, const NotificationRule&, NotificationMethods);
+	private slots:
+		void handleCoalesced (const LeechCraft::Entity&,
+				const QList<LeechCraft::AdvancedNotifications::NotificationRule>&);
 	signals:
 		void gotActions (QList<QAction*>, LeechCraft::ActionsEmbedPlace);
 	};
@@ -28,6 +28,7 @@
  **********************************************************************/
 
 #include "rulesmanager.h"
+#include <algorithm>
 #include <QStandardItemModel>
 #include <QSettings>
 #include <QCoreApplication>
@@ -175,9 +176,42 @@ namespace AdvancedNotifications
 		for (auto item : RuleToRow (rule))
 			RulesModel_->setItem (row, i++, item);
 
+		RebuildIndex ();
+
 		SaveSettings ();
 	}
 
+	QList<NotificationRule> RulesManager::GetMatchingRules (const Entity& e)
+	{
+		const auto& type = e.Additional_ ["org.LC.AdvNotifications.EventType"].toString ();
+
+		const auto pos = Type2Rules_.constFind (type);
+		if (pos == Type2Rules_.constEnd ())
+			return {};
+
+		QList<NotificationRule> result;
+		QList<int> singleShots;
+		for (const auto& indexed : *pos)
+		{
+			const bool fieldsMatch = std::all_of (indexed.Matchers_.begin (), indexed.Matchers_.end (),
+					[&e] (const QPair<QString, TypedMatcherBase_ptr>& pair)
+						{ return pair.second->Match (e.Additional_.value (pair.first)); });
+			if (!fieldsMatch)
+				continue;
+
+			const auto& rule = Rules_.at (indexed.Idx_);
+			if (rule.IsSingleShot ())
+				singleShots << indexed.Idx_;
+
+			result << rule;
+		}
+
+		for (auto idx : singleShots)
+			setRuleEnabled (idx, false);
+
+		return result;
+	}
+
 	void RulesManager::HandleEntity (const Entity& e)
 	{
 		const auto& title = e.Entity_.toString ();
@@ -251,6 +285,7 @@ namespace AdvancedNotifications
 
 		Rules_.prepend (rule);
 		RulesModel_->insertRow (0, RuleToRow (rule));
+		RebuildIndex ();
 
 		SaveSettings ();
 
@@ -443,6 +478,28 @@ namespace AdvancedNotifications
 
 		for (const auto& rule : Rules_)
 			RulesModel_->appendRow (RuleToRow (rule));
+
+		RebuildIndex ();
+	}
+
+	void RulesManager::RebuildIndex ()
+	{
+		Type2Rules_.clear ();
+
+		for (int i = 0; i < Rules_.size (); ++i)
+		{
+			const auto& rule = Rules_.at (i);
+			if (rule.IsNull () || !rule.IsEnabled ())
+				continue;
+
+			IndexedRule indexed { i, {} };
+			for (const auto& match : rule.GetFieldMatches ())
+				if (const auto& matcher = match.GetMatcher ())
+					indexed.Matchers_.append (qMakePair (match.GetFieldName (), matcher));
+
+			for (const auto& type : rule.GetTypes ())
+				Type2Rules_ [type] << indexed;
+		}
 	}
 
 	void RulesManager::SaveSettings () const
@@ -483,12 +540,14 @@ namespace AdvancedNotifications
 	{
 		Rules_.prepend (NotificationRule ());
 		RulesModel_->insertRow (0, RuleToRow (NotificationRule ()));
+		RebuildIndex ();
 	}
 
 	void RulesManager::removeRule (const QModelIndex& index)
 	{
 		RulesModel_->removeRow (index.row ());
 		Rules_.removeAt (index.row ());
+		RebuildIndex ();
 
 		SaveSettings ();
 	}
@@ -501,6 +560,7 @@ namespace AdvancedNotifications
 
 		std::swap (Rules_ [row - 1], Rules_ [row]);
 		RulesModel_->insertRow (row, RulesModel_->takeRow (row - 1));
+		RebuildIndex ();
 
 		SaveSettings ();
 	}
@@ -513,6 +573,7 @@ namespace AdvancedNotifications
 
 		std::swap (Rules_ [row - 1], Rules_ [row]);
 		RulesModel_->insertRow (row - 1, RulesModel_->takeRow (row));
+		RebuildIndex ();
 
 		SaveSettings ();
 	}
@@ -520,6 +581,7 @@ namespace AdvancedNotifications
 	void RulesManager::setRuleEnabled (int idx, bool enabled)
 	{
 		Rules_ [idx].SetEnabled (enabled);
+		RebuildIndex ();
 		if (auto item = RulesModel_->item (idx))
 		{
 			item->setData (enabled, RulesModel::Roles::IsRuleEnabled);
@@ -556,6 +618,7 @@ namespace AdvancedNotifications
 			return;
 
 		Rules_ [idx].SetEnabled (newState);
+		RebuildIndex ();
 
 		SaveSettings ();
 	}
@@ -30,6 +30,8 @@
 #pragma once
 
 #include <QObject>
+#include <QHash>
+#include <QPair>
 #include "notificationrule.h"
 
 class QAbstractItemModel;
@@ -50,6 +52,13 @@ namespace AdvancedNotifications
 		QList<NotificationRule> Rules_;
 		QStandardItemModel *RulesModel_;
 
+		struct IndexedRule
+		{
+			int Idx_;
+			QList<QPair<QString, TypedMatcherBase_ptr>> Matchers_;
+		};
+		QHash<QString, QList<IndexedRule>> Type2Rules_;
+
 		QMap<QString, QString> Cat2HR_;
 		QMap<QString, QString> Type2HR_;
 	public:
@@ -64,6 +73,8 @@ namespace AdvancedNotifications
 		void SetRuleEnabled (const NotificationRule&, bool);
 		void UpdateRule (const QModelIndex&, const NotificationRule&);
 
+		QList<NotificationRule> GetMatchingRules (const Entity&);
+
 		void HandleEntity (const Entity&);
 		void SuggestRuleConfiguration (const Entity&);
 		QList<Entity> GetAllRules (const QString&) const;
@@ -71,6 +82,7 @@ namespace AdvancedNotifications
 		void LoadDefaultRules (int = -1);
 		void LoadSettings ();
 		void ResetModel ();
+		void RebuildIndex ();
 		void SaveSettings () const;
 
 		QList<QStandardItem*> RuleToRow (const NotificationRule&) const;
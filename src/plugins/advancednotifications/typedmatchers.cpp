@@ -252,7 +252,10 @@ namespace AdvancedNotifications
 		if (!var.canConvert<QString> ())
 			return false;
 
-		bool res = Value_.Rx_.indexIn (var.toString ()) != -1;
+		const auto& str = var.toString ();
+		bool res = Value_.Rx_.patternSyntax () == QRegExp::FixedString ?
+				str.contains (Value_.Rx_.pattern (), Value_.Rx_.caseSensitivity ()) :
+				Value_.Rx_.indexIn (str) != -1;
 		if (!Value_.Contains_)
 			res = !res;
 		return res;
@@ -1874,22 +1874,22 @@ namespace Azoth
 
 		if (msg->GetMessageSubType () == IMessage::SubType::ParticipantStatusChange &&
 				(!parent || parent->GetEntryType () == ICLEntry::EntryType::MUC) &&
-				!XmlSettingsManager::Instance ().property ("ShowStatusChangesEvents").toBool ())
+				!XmlSettingsManager::Instance ().Accessors ().ShowStatusChangesEvents ())
 			return;
 
 		if (msg->GetMessageSubType () == IMessage::SubType::ParticipantStatusChange &&
 				(!parent || parent->GetEntryType () != ICLEntry::EntryType::MUC) &&
-				!XmlSettingsManager::Instance ().property ("ShowStatusChangesEventsInPrivates").toBool ())
+				!XmlSettingsManager::Instance ().Accessors ().ShowStatusChangesEventsInPrivates ())
 			return;
 
 		if ((msg->GetMessageSubType () == IMessage::SubType::ParticipantJoin ||
 					msg->GetMessageSubType () == IMessage::SubType::ParticipantLeave) &&
-				!XmlSettingsManager::Instance ().property ("ShowJoinsLeaves").toBool ())
+				!XmlSettingsManager::Instance ().Accessors ().ShowJoinsLeaves ())
 			return;
 
 		if (msg->GetMessageSubType () == IMessage::SubType::ParticipantEndedConversation)
 		{
-			if (!XmlSettingsManager::Instance ().property ("ShowEndConversations").toBool ())
+			if (!XmlSettingsManager::Instance ().Accessors ().ShowEndConversations ())
 				return;
 			else if (other)
 				msg->SetBody (tr ("%1 ended the conversation.")
@@ -1903,7 +1903,7 @@ namespace Azoth
 		if (proxy->IsCancelled ())
 			return;
 
-		if (XmlSettingsManager::Instance ().property ("SeparateMUCEventLogWindow").toBool () &&
+		if (XmlSettingsManager::Instance ().Accessors ().SeparateMUCEventLogWindow () &&
 				(!parent || parent->GetEntryType () == ICLEntry::EntryType::MUC) &&
 				(msg->GetMessageType () != IMessage::Type::MUCMessage &&
 					msg->GetMessageType () != IMessage::Type::ServiceMessage))
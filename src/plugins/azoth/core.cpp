@@ -864,7 +864,7 @@ namespace Azoth
 	QString Core::HandleSmiles (QString body)
 	{
 		const QString& pack = XmlSettingsManager::Instance ()
-				.property ("SmileIcons").toString ();
+				.Accessors ().SmileIcons ();
 
 		Util::DefaultHookProxy_ptr proxy (new Util::DefaultHookProxy);
 		emit hookGonnaHandleSmiles (proxy, body, pack);
@@ -882,7 +882,7 @@ namespace Azoth
 			return body;
 
 		const bool requireSpace = XmlSettingsManager::Instance ()
-				.property ("RequireSpaceBeforeSmiles").toBool ();
+				.Accessors ().RequireSpaceBeforeSmiles ();
 
 		const QString& img = QString ("<img src=\"%2\" title=\"%1\" />");
 		QMap<int, QString> pos2smile;
@@ -297,7 +297,7 @@ namespace Azoth
 
 			auto shortened = trimmed;
 			const auto length = XmlSettingsManager::Instance ()
-					.property ("ShortenURLLength").toInt ();
+					.Accessors ().ShortenURLLength ();
 			if (shortened.size () > length)
 				shortened = trimmed.left (length / 2) + "..." + trimmed.right (length / 2);
 
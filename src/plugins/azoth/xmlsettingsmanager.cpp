@@ -38,6 +38,7 @@ namespace LeechCraft
 namespace Azoth
 {
 	XmlSettingsManager::XmlSettingsManager ()
+	: Accessors_ (this)
 	{
 		qRegisterMetaType<QColor> ("QColor");
 		qRegisterMetaTypeStreamOperators<QColor> ("QColor");
@@ -54,6 +55,11 @@ namespace Azoth
 		return xsm;
 	}
 
+	const XmlSettingsAccessors& XmlSettingsManager::Accessors () const
+	{
+		return Accessors_;
+	}
+
 	QSettings* XmlSettingsManager::BeginSettings () const
 	{
 		QSettings *settings = new QSettings (QCoreApplication::organizationName (),
@@ -30,6 +30,7 @@
 #ifndef PLUGINS_AZOTH_XMLSETTINGSMANAGER_H
 #define PLUGINS_AZOTH_XMLSETTINGSMANAGER_H
 #include <xmlsettingsdialog/basesettingsmanager.h>
+#include "xmlsettingsaccessors.h"
 
 namespace LeechCraft
 {
@@ -38,9 +39,19 @@ namespace Azoth
 	class XmlSettingsManager : public Util::BaseSettingsManager
 	{
 		Q_OBJECT
+
+		XmlSettingsAccessors Accessors_;
+
 		XmlSettingsManager ();
 	public:
 		static XmlSettingsManager& Instance ();
+
+		/** @brief Returns the cached values of the settings.
+		 *
+		 * The accessors are kept in sync with the properties of this
+		 * object, so they are cheaper than property() in hot paths.
+		 */
+		const XmlSettingsAccessors& Accessors () const;
 	protected:
 		virtual QSettings* BeginSettings () const;
 		virtual void EndSettings (QSettings*) const;
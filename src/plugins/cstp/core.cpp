@@ -50,6 +50,7 @@
 #include <util/xpc/notificationactionhandler.h>
 #include <util/xpc/util.h>
 #include "task.h"
+#include "diskwriter.h"
 #include "xmlsettingsmanager.h"
 #include "addtask.h"
 
@@ -74,12 +75,30 @@ namespace CSTP
 	: Headers_ { "URL", tr ("State"), tr ("Progress") }
 	, SaveScheduled_ (false)
 	, Toolbar_ (0)
+	, QuotaTimer_ (new QTimer (this))
+	, SchedulingPending_ (false)
 	{
 		setObjectName ("CSTP Core");
 		qRegisterMetaType<std::shared_ptr<QFile>> ("std::shared_ptr<QFile>");
 		qRegisterMetaType<QNetworkReply*> ("QNetworkReply*");
 
+		Writer_ = new DiskWriter (this);
+		XmlSettingsManager::Instance ().RegisterObject ("WriteQueueSize",
+				this, "handleWriteQueueSizeChanged");
+		handleWriteQueueSizeChanged ();
+		Writer_->start (QThread::LowPriority);
+
+		connect (QuotaTimer_,
+				SIGNAL (timeout ()),
+				this,
+				SIGNAL (readQuotaRefilled ()));
+		XmlSettingsManager::Instance ().RegisterObject ({ "GlobalSpeedLimit", "PerTaskSpeedLimit" },
+				this, "handleSpeedLimitsChanged");
+		XmlSettingsManager::Instance ().RegisterObject ({ "MaxActiveTasks", "MaxTasksPerHost" },
+				this, "scheduleTasks");
+
 		ReadSettings ();
+		handleSpeedLimitsChanged ();
 	}
 
 	Core& Core::Instance ()
@@ -91,6 +110,7 @@ namespace CSTP
 	void Core::Release ()
 	{
 		writeSettings ();
+		Writer_->Shutdown ();
 	}
 
 	void Core::SetCoreProxy (ICoreProxy_ptr proxy)
@@ -315,14 +335,15 @@ namespace CSTP
 		if (td.Parameters_ & Internal)
 			td.Task_->ForbidNameChanges ();
 
-		connect (td.Task_.get (),
-				SIGNAL (done (bool)),
-				this,
-				SLOT (done (bool)));
-		connect (td.Task_.get (),
-				SIGNAL (updateInterface ()),
-				this,
-				SLOT (updateInterface ()));
+		if (td.Parameters_ & FromUserInitiated)
+			td.Priority_ = PriorityHigh;
+		else if (td.Parameters_ & AutoAccept)
+			td.Priority_ = PriorityLow;
+		else
+			td.Priority_ = PriorityNormal;
+		td.Queued_ = false;
+
+		SetupTask (td);
 
 		beginInsertRows (QModelIndex (), rowCount (), rowCount ());
 		ActiveTasks_.push_back (td);
@@ -423,6 +444,16 @@ namespace CSTP
 		FinishedReplies_.remove (rep);
 	}
 
+	DiskWriter* Core::GetDiskWriter () const
+	{
+		return Writer_;
+	}
+
+	RateLimiter& Core::GetGlobalLimiter ()
+	{
+		return GlobalLimiter_;
+	}
+
 	int Core::columnCount (const QModelIndex&) const
 	{
 		return Headers_.size ();
@@ -449,6 +480,9 @@ namespace CSTP
 				if (td.ErrorFlag_)
 					return task->GetErrorString ();
 
+				if (td.Queued_)
+					return tr ("Queued");
+
 				if (!task->IsRunning ())
 					return QVariant ();
 
@@ -486,6 +520,9 @@ namespace CSTP
 				return QVariant ();
 			}
 		}
+		else if (role == Qt::ToolTipRole && index.column () == HProgress)
+			return tr ("Disk write speed: %1")
+					.arg (Util::MakePrettySize (Writer_->GetThroughput ()) + tr ("/s"));
 		else if (role == LeechCraft::RoleControls)
 			return QVariant::fromValue<QToolBar*> (Toolbar_);
 		else if (role == CustomDataRoles::RoleJobHolderRow)
@@ -563,22 +600,19 @@ namespace CSTP
 			if (!Selected_.isValid ())
 				return;
 			i = Selected_.row ();
+
+			// Explicitly started by the user, so it's urgent.
+			TaskAt (i).Priority_ = PriorityHigh;
 		}
 
-		TaskDescr selected = TaskAt (i);
-		if (selected.Task_->IsRunning ())
+		auto& selected = TaskAt (i);
+		if (selected.Task_->IsRunning () || selected.Queued_)
 			return;
-		if (!selected.File_->open (QIODevice::ReadWrite))
-		{
-			QString msg = tr ("Could not open file %1: %2")
-				.arg (selected.File_->fileName ())
-				.arg (selected.File_->error ());
-			qWarning () << Q_FUNC_INFO
-				<< msg;
-			emit error (msg);
-			return;
-		}
-		selected.Task_->Start (selected.File_);
+
+		selected.Queued_ = true;
+		emit dataChanged (index (i, 0), index (i, columnCount () - 1));
+
+		scheduleTasks ();
 	}
 
 	void Core::stopTriggered (int i)
@@ -590,11 +624,19 @@ namespace CSTP
 			i = Selected_.row ();
 		}
 
-		TaskDescr selected = TaskAt (i);
+		auto& selected = TaskAt (i);
+		if (selected.Queued_)
+		{
+			selected.Queued_ = false;
+			emit dataChanged (index (i, 0), index (i, columnCount () - 1));
+			return;
+		}
+
 		if (!selected.Task_->IsRunning ())
 			return;
+		// The task closes the file and emits stopped () asynchronously.
 		selected.Task_->Stop ();
-		selected.File_->close ();
+		ScheduleSave ();
 	}
 
 	void Core::startAllTriggered ()
@@ -623,7 +665,7 @@ namespace CSTP
 		QString errorStr = taskdscr->Task_->GetErrorString ();
 		QStringList tags = taskdscr->Tags_;
 
-		taskdscr->File_->close ();
+		ScheduleTasksLater ();
 
 		bool notifyUser = !(taskdscr->Parameters_ & LeechCraft::DoNotNotifyUser) &&
 				!(taskdscr->Parameters_ & LeechCraft::Internal);
@@ -715,6 +757,86 @@ namespace CSTP
 		emit dataChanged (index (pos, 0), index (pos, columnCount () - 1));
 	}
 
+	void Core::handleSpeedLimitsChanged ()
+	{
+		const auto globalLimit = XmlSettingsManager::Instance ()
+				.property ("GlobalSpeedLimit").toLongLong () * 1024;
+		const auto perTaskLimit = XmlSettingsManager::Instance ()
+				.property ("PerTaskSpeedLimit").toLongLong () * 1024;
+
+		GlobalLimiter_.SetRate (globalLimit);
+		for (const auto& td : ActiveTasks_)
+			td.Task_->SetSpeedLimit (perTaskLimit);
+
+		if (globalLimit || perTaskLimit)
+			QuotaTimer_->start (100);
+		else
+			QuotaTimer_->stop ();
+	}
+
+	void Core::handleTaskStopped ()
+	{
+		updateInterface ();
+		ScheduleTasksLater ();
+	}
+
+	void Core::scheduleTasks ()
+	{
+		SchedulingPending_ = false;
+
+		const auto maxActive = XmlSettingsManager::Instance ()
+				.property ("MaxActiveTasks").toInt ();
+		const auto maxPerHost = XmlSettingsManager::Instance ()
+				.property ("MaxTasksPerHost").toInt ();
+
+		auto getHost = [] (const TaskDescr& td) { return QUrl (td.Task_->GetURL ()).host (); };
+
+		int running = 0;
+		QHash<QString, int> perHost;
+		for (const auto& td : ActiveTasks_)
+			if (td.Task_->IsRunning ())
+			{
+				++running;
+				++perHost [getHost (td)];
+			}
+
+		// Pick the tasks to start first, since starting a task may finish
+		// it right away and thus modify ActiveTasks_.
+		QList<quint32> toStart;
+		for (int prio = PriorityHigh; prio <= PriorityLow; ++prio)
+			for (const auto& td : ActiveTasks_)
+			{
+				if (maxActive && running >= maxActive)
+					break;
+
+				if (!td.Queued_ || td.Priority_ != prio)
+					continue;
+
+				const auto& host = getHost (td);
+				if (maxPerHost && !host.isEmpty () && perHost.value (host) >= maxPerHost)
+					continue;
+
+				toStart << td.ID_;
+				++running;
+				++perHost [host];
+			}
+
+		for (const auto id : toStart)
+		{
+			const auto pos = std::find_if (ActiveTasks_.begin (), ActiveTasks_.end (),
+					[id] (const TaskDescr& td) { return td.ID_ == id; });
+			if (pos != ActiveTasks_.end () && pos->Queued_)
+				StartTask (pos);
+		}
+	}
+
+	void Core::handleWriteQueueSizeChanged ()
+	{
+		const auto mibs = XmlSettingsManager::Instance ()
+				.property ("WriteQueueSize").toLongLong ();
+		Writer_->SetMaxQueuedBytes (std::max<qint64> (mibs, 1) * 1024 * 1024);
+	}
+
 	void Core::writeSettings ()
 	{
 		QSettings settings (QCoreApplication::organizationName (),
@@ -734,6 +856,7 @@ namespace CSTP
 			settings.setValue ("Comment", i->Comment_);
 			settings.setValue ("ErrorFlag", i->ErrorFlag_);
 			settings.setValue ("Tags", i->Tags_);
+			settings.setValue ("Priority", static_cast<int> (i->Priority_));
 		}
 		SaveScheduled_ = false;
 		settings.endArray ();
@@ -771,14 +894,9 @@ namespace CSTP
 				continue;
 			}
 
-			connect (td.Task_.get (),
-					SIGNAL (done (bool)),
-					this,
-					SLOT (done (bool)));
-			connect (td.Task_.get (),
-					SIGNAL (updateInterface ()),
-					this,
-					SLOT (updateInterface ()));
+			td.Priority_ = static_cast<Priority> (settings.value ("Priority", PriorityNormal).toInt ());
+			td.Queued_ = false;
+			SetupTask (td);
 
 			QString filename = settings.value ("Filename").toString ();
 			td.File_.reset (new QFile (filename));
@@ -793,6 +911,68 @@ namespace CSTP
 		settings.endArray ();
 	}
 
+	void Core::SetupTask (const TaskDescr& td)
+	{
+		connect (td.Task_.get (),
+				SIGNAL (done (bool)),
+				this,
+				SLOT (done (bool)));
+		connect (td.Task_.get (),
+				SIGNAL (updateInterface ()),
+				this,
+				SLOT (updateInterface ()));
+		connect (td.Task_.get (),
+				SIGNAL (stopped ()),
+				this,
+				SLOT (handleTaskStopped ()));
+
+		connect (Writer_,
+				SIGNAL (drained ()),
+				td.Task_.get (),
+				SLOT (resumeReading ()));
+		connect (Writer_,
+				SIGNAL (writeFailed (std::shared_ptr<QFile>, QString)),
+				td.Task_.get (),
+				SLOT (handleWriteFailed (std::shared_ptr<QFile>, QString)));
+		connect (this,
+				SIGNAL (readQuotaRefilled ()),
+				td.Task_.get (),
+				SLOT (resumeReading ()));
+
+		td.Task_->SetSpeedLimit (XmlSettingsManager::Instance ()
+				.property ("PerTaskSpeedLimit").toLongLong () * 1024);
+	}
+
+	void Core::StartTask (tasks_t::iterator it)
+	{
+		auto& td = *it;
+		td.Queued_ = false;
+
+		const int pos = std::distance (ActiveTasks_.begin (), it);
+		emit dataChanged (index (pos, 0), index (pos, columnCount () - 1));
+
+		if (!td.File_->open (QIODevice::ReadWrite))
+		{
+			QString msg = tr ("Could not open file %1: %2")
+				.arg (td.File_->fileName ())
+				.arg (td.File_->error ());
+			qWarning () << Q_FUNC_INFO
+				<< msg;
+			emit error (msg);
+			return;
+		}
+		td.Task_->Start (td.File_);
+	}
+
+	void Core::ScheduleTasksLater ()
+	{
+		if (SchedulingPending_)
+			return;
+
+		SchedulingPending_ = true;
+		QTimer::singleShot (0, this, SLOT (scheduleTasks ()));
+	}
+
 	void Core::ScheduleSave ()
 	{
 		if (SaveScheduled_)
@@ -823,6 +1003,7 @@ namespace CSTP
 		CoreProxy_->FreeID (id);
 
 		ScheduleSave ();
+		ScheduleTasksLater ();
 	}
 
 	Core::tasks_t::const_reference Core::TaskAt (int pos) const
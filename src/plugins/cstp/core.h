@@ -40,8 +40,10 @@
 #include <interfaces/iinfo.h>
 #include <interfaces/structures.h>
 #include <interfaces/idownload.h>
+#include "ratelimiter.h"
 
 class QFile;
+class QTimer;
 
 struct EntityTestHandleResult;
 
@@ -58,6 +60,7 @@ namespace LeechCraft
 namespace CSTP
 {
 	class Task;
+	class DiskWriter;
 
 	class Core : public QAbstractItemModel
 	{
@@ -65,6 +68,14 @@ namespace CSTP
 
 		const QStringList Headers_;
 
+	public:
+		enum Priority
+		{
+			PriorityHigh,
+			PriorityNormal,
+			PriorityLow
+		};
+	private:
 		struct TaskDescr
 		{
 			std::shared_ptr<Task> Task_;
@@ -74,6 +85,11 @@ namespace CSTP
 			LeechCraft::TaskParameters Parameters_;
 			quint32 ID_;
 			QStringList Tags_;
+			Priority Priority_;
+
+			/** Whether the task is waiting for the scheduler to start it.
+				*/
+			bool Queued_;
 		};
 		typedef std::vector<TaskDescr> tasks_t;
 		tasks_t ActiveTasks_;
@@ -83,6 +99,11 @@ namespace CSTP
 		QSet<QNetworkReply*> FinishedReplies_;
 		QModelIndex Selected_;
 		ICoreProxy_ptr CoreProxy_;
+		DiskWriter *Writer_;
+
+		RateLimiter GlobalLimiter_;
+		QTimer *QuotaTimer_;
+		bool SchedulingPending_;
 
 		explicit Core ();
 	public:
@@ -115,6 +136,8 @@ namespace CSTP
 		QNetworkAccessManager* GetNetworkAccessManager () const;
 		bool HasFinishedReply (QNetworkReply*) const;
 		void RemoveFinishedReply (QNetworkReply*);
+		DiskWriter* GetDiskWriter () const;
+		RateLimiter& GetGlobalLimiter ();
 
 		virtual int columnCount (const QModelIndex& = QModelIndex ()) const;
 		virtual QVariant data (const QModelIndex&, int = Qt::DisplayRole) const;
@@ -134,8 +157,12 @@ namespace CSTP
 	private slots:
 		void done (bool);
 		void updateInterface ();
+		void handleTaskStopped ();
 		void writeSettings ();
 		void finishedReply (QNetworkReply*);
+		void handleWriteQueueSizeChanged ();
+		void handleSpeedLimitsChanged ();
+		void scheduleTasks ();
 	private:
 		int AddTask (const QUrl&,
 				const QString&,
@@ -151,6 +178,9 @@ namespace CSTP
 				const QStringList&,
 				LeechCraft::TaskParameters = LeechCraft::NoParameters);
 		int AddTask (TaskDescr&);
+		void SetupTask (const TaskDescr&);
+		void StartTask (tasks_t::iterator);
+		void ScheduleTasksLater ();
 		void ReadSettings ();
 		void ScheduleSave ();
 		tasks_t::const_iterator FindTask (QObject*) const;
@@ -166,6 +196,11 @@ namespace CSTP
 		void gotEntity (const LeechCraft::Entity&);
 		void error (const QString&);
 		void fileExists (boost::logic::tribool*);
+
+		/** Emitted periodically while there are speed limits, so that
+			* the tasks throttled by them could continue reading.
+			*/
+		void readQuotaRefilled ();
 	};
 }
 }
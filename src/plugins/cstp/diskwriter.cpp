@@ -0,0 +1,224 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "diskwriter.h"
+#include <QFile>
+#include <QElapsedTimer>
+#include <QtDebug>
+
+namespace LeechCraft
+{
+namespace CSTP
+{
+	DiskWriter::DiskWriter (QObject *parent)
+	: QThread (parent)
+	, MaxQueuedBytes_ (16 * 1024 * 1024)
+	{
+	}
+
+	DiskWriter::~DiskWriter ()
+	{
+		Shutdown ();
+	}
+
+	void DiskWriter::SetMaxQueuedBytes (qint64 bytes)
+	{
+		QMutexLocker locker (&Mutex_);
+		MaxQueuedBytes_ = bytes;
+	}
+
+	bool DiskWriter::IsFull () const
+	{
+		QMutexLocker locker (&Mutex_);
+		if (QueuedBytes_ < MaxQueuedBytes_)
+			return false;
+
+		WasFull_ = true;
+		return true;
+	}
+
+	void DiskWriter::Write (const std::shared_ptr<QFile>& file, qint64 pos, const QByteArray& data)
+	{
+		if (data.isEmpty ())
+			return;
+
+		QMutexLocker locker (&Mutex_);
+		if (Quit_)
+		{
+			// Late writes after shutdown are done synchronously.
+			locker.unlock ();
+			if ((pos >= 0 && !file->seek (pos)) || file->write (data) != data.size ())
+				emit writeFailed (file, file->errorString ());
+			return;
+		}
+
+		Queue_.push_back ({ file, pos, data, {}, {} });
+		QueuedBytes_ += data.size ();
+
+		if (QueuedBytes_ >= MaxQueuedBytes_)
+			WasFull_ = true;
+
+		HasWork_.wakeOne ();
+	}
+
+	QFuture<bool> DiskWriter::Schedule (const std::shared_ptr<QFile>& file, const FileOp_f& op)
+	{
+		QFutureInterface<bool> result;
+		result.reportStarted ();
+
+		QMutexLocker locker (&Mutex_);
+		if (Quit_)
+		{
+			// Late operations after shutdown are run synchronously.
+			locker.unlock ();
+			const bool ok = op (file.get ());
+			result.reportFinished (&ok);
+			return result.future ();
+		}
+
+		Queue_.push_back ({ file, -1, {}, op, result });
+		HasWork_.wakeOne ();
+
+		return result.future ();
+	}
+
+	QFuture<bool> DiskWriter::Close (const std::shared_ptr<QFile>& file)
+	{
+		return Schedule (file,
+				[] (QFile *target)
+				{
+					target->close ();
+					return true;
+				});
+	}
+
+	QFuture<bool> DiskWriter::Resize (const std::shared_ptr<QFile>& file, qint64 size)
+	{
+		return Schedule (file,
+				[size] (QFile *target)
+				{
+					if (target->resize (size))
+						return true;
+
+					qWarning () << Q_FUNC_INFO
+							<< "unable to resize"
+							<< target->fileName ()
+							<< "to"
+							<< size
+							<< target->errorString ();
+					return false;
+				});
+	}
+
+	void DiskWriter::Shutdown ()
+	{
+		{
+			QMutexLocker locker (&Mutex_);
+			Quit_ = true;
+			HasWork_.wakeAll ();
+		}
+
+		wait ();
+	}
+
+	qint64 DiskWriter::GetThroughput () const
+	{
+		QMutexLocker locker (&Mutex_);
+		return Throughput_;
+	}
+
+	void DiskWriter::run ()
+	{
+		QElapsedTimer sinceUpdate;
+		sinceUpdate.start ();
+
+		auto updateThroughput = [this, &sinceUpdate] () -> void
+		{
+			const auto elapsed = sinceUpdate.elapsed ();
+			if (elapsed < 1000)
+				return;
+
+			Throughput_ = WrittenSinceUpdate_ * 1000 / elapsed;
+			WrittenSinceUpdate_ = 0;
+			sinceUpdate.restart ();
+		};
+
+		QMutexLocker locker (&Mutex_);
+		while (true)
+		{
+			while (Queue_.empty () && !Quit_)
+			{
+				HasWork_.wait (&Mutex_, 1000);
+				updateThroughput ();
+			}
+
+			if (Queue_.empty ())
+				break;
+
+			auto job = Queue_.front ();
+			Queue_.pop_front ();
+
+			if (job.Op_)
+			{
+				locker.unlock ();
+				const bool result = job.Op_ (job.File_.get ());
+				job.Result_.reportFinished (&result);
+				locker.relock ();
+				continue;
+			}
+
+			locker.unlock ();
+			const bool ok = (job.Pos_ < 0 || job.File_->seek (job.Pos_)) &&
+					job.File_->write (job.Data_) == job.Data_.size ();
+			const auto& errorString = ok ? QString () : job.File_->errorString ();
+			locker.relock ();
+
+			QueuedBytes_ -= job.Data_.size ();
+			WrittenSinceUpdate_ += job.Data_.size ();
+
+			if (!ok)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "error writing to"
+						<< job.File_->fileName ()
+						<< errorString;
+				emit writeFailed (job.File_, errorString);
+			}
+
+			if (WasFull_ && QueuedBytes_ <= MaxQueuedBytes_ / 2)
+			{
+				WasFull_ = false;
+				emit drained ();
+			}
+
+			updateThroughput ();
+		}
+	}
+}
+}
@@ -0,0 +1,121 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <functional>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QByteArray>
+#include <QFutureInterface>
+
+class QFile;
+
+namespace LeechCraft
+{
+namespace CSTP
+{
+	/** Writes downloaded data to the target files on a dedicated thread.
+		*
+		* Tasks enqueue buffers via Write() and check IsFull() before
+		* reading more data from the network, so that the amount of data
+		* waiting to be written stays bounded. The drained() signal is
+		* emitted once a full queue gets back to half of its limit.
+		*
+		* Nothing but the writer thread may touch a file while it has
+		* pending writes, so closing, resizing and other operations on
+		* such a file should be enqueued via Schedule() as well. They are
+		* run after all the writes enqueued before them.
+		*/
+	class DiskWriter : public QThread
+	{
+		Q_OBJECT
+	public:
+		typedef std::function<bool (QFile*)> FileOp_f;
+	private:
+		struct Job
+		{
+			std::shared_ptr<QFile> File_;
+			qint64 Pos_;
+			QByteArray Data_;
+
+			FileOp_f Op_;
+			QFutureInterface<bool> Result_;
+		};
+
+		mutable QMutex Mutex_;
+		QWaitCondition HasWork_;
+
+		std::deque<Job> Queue_;
+		qint64 QueuedBytes_ = 0;
+		qint64 MaxQueuedBytes_;
+		mutable bool WasFull_ = false;
+		bool Quit_ = false;
+
+		qint64 WrittenSinceUpdate_ = 0;
+		qint64 Throughput_ = 0;
+	public:
+		DiskWriter (QObject* = 0);
+		~DiskWriter ();
+
+		void SetMaxQueuedBytes (qint64);
+		bool IsFull () const;
+
+		/** Enqueues writing the data at the given position of the file,
+			* or at its current position if pos is negative.
+			*/
+		void Write (const std::shared_ptr<QFile>& file, qint64 pos, const QByteArray& data);
+
+		/** Enqueues running the op on the file in the writer thread. The
+			* returned future holds the value returned by the op.
+			*/
+		QFuture<bool> Schedule (const std::shared_ptr<QFile>&, const FileOp_f& op);
+
+		QFuture<bool> Close (const std::shared_ptr<QFile>&);
+		QFuture<bool> Resize (const std::shared_ptr<QFile>&, qint64 size);
+
+		/** Stops the thread after all the pending writes are done.
+			*/
+		void Shutdown ();
+
+		/** Returns the write throughput over the last second, in bytes
+			* per second.
+			*/
+		qint64 GetThroughput () const;
+	protected:
+		void run ();
+	signals:
+		void drained ();
+		void writeFailed (std::shared_ptr<QFile>, const QString&);
+	};
+}
+}
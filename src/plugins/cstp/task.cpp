@@ -36,10 +36,15 @@
 #include <QDataStream>
 #include <QDir>
 #include <QTimer>
+#include <QPointer>
+#include <QFutureWatcher>
+#include <QtConcurrentRun>
 #include <QtDebug>
 #include <util/xpc/util.h>
+#include <util/sll/slotclosure.h>
 #include <interfaces/core/icoreproxy.h>
 #include "core.h"
+#include "diskwriter.h"
 #include "xmlsettingsmanager.h"
 
 namespace LeechCraft
@@ -53,6 +58,54 @@ namespace CSTP
 			if (rep)
 				rep->deleteLater ();
 		}
+
+		const int MaxSegmentRetries = 3;
+
+		/** The network layer stops reading from the socket once this much
+			* data is waiting in a reply, which throttles the sender while
+			* the disk writer is full.
+			*/
+		const qint64 ReplyReadBufferSize = 2 * 1024 * 1024;
+
+		DiskWriter* GetWriter ()
+		{
+			return Core::Instance ().GetDiskWriter ();
+		}
+
+		int GetSegmentsCount ()
+		{
+			return std::max (1, XmlSettingsManager::Instance ()
+					.property ("SegmentsCount").toInt ());
+		}
+
+		qint64 GetMinSegmentSize ()
+		{
+			return std::max<qint64> (1, XmlSettingsManager::Instance ()
+					.property ("MinSegmentSize").toLongLong () * 1024);
+		}
+
+		/** Calls the handler with the result of the future once it
+			* finishes, unless the context object is destroyed by then.
+			*/
+		void WhenFinished (const QFuture<bool>& future,
+				QObject *context, const std::function<void (bool)>& handler)
+		{
+			const auto watcher = new QFutureWatcher<bool>;
+			const QPointer<QObject> guard { context };
+			new Util::SlotClosure<Util::DeleteLaterPolicy>
+			{
+				[watcher, guard, handler] () -> void
+				{
+					watcher->deleteLater ();
+					if (guard)
+						handler (watcher->result ());
+				},
+				watcher,
+				SIGNAL (finished ()),
+				watcher
+			};
+			watcher->setFuture (future);
+		}
 	}
 
 	Task::Task (const QUrl& url, const QVariantMap& params)
@@ -67,6 +120,11 @@ namespace CSTP
 	, CanChangeName_ (true)
 	, Referer_ (params ["Referer"].toUrl ())
 	, Params_ (params)
+	, SegmentsForbidden_ (false)
+	, DoneAtStart_ (0)
+	, ReadStalled_ (false)
+	, PendingFileOps_ (0)
+	, Stopping_ (false)
 	{
 		StartTime_.start ();
 
@@ -85,6 +143,11 @@ namespace CSTP
 	, UpdateCounter_ (0)
 	, Timer_ (new QTimer (this))
 	, CanChangeName_ (true)
+	, SegmentsForbidden_ (true)
+	, DoneAtStart_ (0)
+	, ReadStalled_ (false)
+	, PendingFileOps_ (0)
+	, Stopping_ (false)
 	{
 		StartTime_.start ();
 
@@ -94,45 +157,61 @@ namespace CSTP
 				SIGNAL (updateInterface ()));
 	}
 
+	Task::~Task ()
+	{
+		StopSegments ();
+	}
+
 	void Task::Start (const std::shared_ptr<QFile>& tof)
 	{
 		FileSizeAtStart_ = tof->size ();
 		To_ = tof;
 
-		if (!Reply_.get ())
+		if (!Segments_.isEmpty ())
 		{
-			if (URL_.scheme () == "file")
+			// Resuming a segmented download: the file is preallocated,
+			// so just refetch the ranges that are still missing.
+			if (tof->size () == Total_)
 			{
-				QTimer::singleShot (100,
-						this,
-						SLOT (handleLocalTransfer ()));
+				StartTime_.restart ();
+				DoneAtStart_ = Done_;
+				LastError_.clear ();
+				for (auto& segment : Segments_)
+				{
+					segment.Retries_ = 0;
+					StartSegment (segment);
+				}
+
+				if (!Timer_->isActive ())
+					Timer_->start (3000);
 				return;
 			}
 
-			QString ua = XmlSettingsManager::Instance ()
-				.property ("UserUserAgent").toString ();
-			if (ua.isEmpty ())
-				ua = XmlSettingsManager::Instance ()
-					.property ("PredefinedUserAgent").toString ();
+			qWarning () << Q_FUNC_INFO
+					<< "file size"
+					<< tof->size ()
+					<< "doesn't match the segmented download size"
+					<< Total_
+					<< ", restarting from scratch";
+			Segments_.clear ();
+			tof->resize (0);
+			FileSizeAtStart_ = 0;
+		}
 
-			if (ua == "%leechcraft%")
-				ua = "LeechCraft.CSTP/" + Core::Instance ().GetCoreProxy ()->GetVersion ();
+		if (!Reply_.get ())
+		{
+			if (URL_.scheme () == "file")
+			{
+				StartLocalTransfer ();
+				return;
+			}
 
-			QNetworkRequest req (URL_);
+			auto req = MakeRequest ();
 			if (tof->size ())
 				req.setRawHeader ("Range", QString ("bytes=%1-").arg (tof->size ()).toLatin1 ());
-			req.setRawHeader ("User-Agent", ua.toLatin1 ());
-
-			if (Referer_.isEmpty ())
-				req.setRawHeader ("Referer", QString (QString ("http://") + URL_.host ()).toLatin1 ());
-			else
-				req.setRawHeader ("Referer", Referer_.toEncoded ());
-
-			req.setRawHeader ("Host", URL_.host ().toLatin1 ());
-			req.setRawHeader ("Origin", URL_.scheme ().toLatin1 () + "://" + URL_.host ().toLatin1 ());
-			req.setRawHeader ("Accept", "*/*");
 
 			StartTime_.restart ();
+			DoneAtStart_ = 0;
 
 			auto nam = Core::Instance ().GetNetworkAccessManager ();
 
@@ -182,6 +261,7 @@ namespace CSTP
 			Timer_->start (3000);
 
 		Reply_->setParent (0);
+		Reply_->setReadBufferSize (ReplyReadBufferSize);
 		connect (Reply_.get (),
 				SIGNAL (downloadProgress (qint64, qint64)),
 				this,
@@ -206,8 +286,20 @@ namespace CSTP
 
 	void Task::Stop ()
 	{
+		StopSegments ();
+
 		if (Reply_.get ())
 			Reply_->abort ();
+
+		ReadStalled_ = false;
+
+		Stopping_ = true;
+		RunFileOp ([this] { return GetWriter ()->Close (To_); },
+				[this] (bool) -> void
+				{
+					Stopping_ = false;
+					emit stopped ();
+				});
 	}
 
 	void Task::ForbidNameChanges ()
@@ -215,18 +307,29 @@ namespace CSTP
 		CanChangeName_ = false;
 	}
 
+	void Task::SetSpeedLimit (qint64 bytesPerSecond)
+	{
+		if (Limiter_.GetRate () != bytesPerSecond)
+			Limiter_.SetRate (bytesPerSecond);
+	}
+
 	QByteArray Task::Serialize () const
 	{
 		QByteArray result;
 		{
 			QDataStream out (&result, QIODevice::WriteOnly);
-			out << 2
+			QList<QPair<qint64, qint64>> segments;
+			for (const auto& segment : Segments_)
+				segments.append ({ segment.Pos_, segment.End_ });
+
+			out << 3
 				<< URL_
 				<< StartTime_
 				<< Done_
 				<< Total_
 				<< Speed_
-				<< CanChangeName_;
+				<< CanChangeName_
+				<< segments;
 		}
 		return result;
 	}
@@ -246,8 +349,17 @@ namespace CSTP
 		}
 		if (version >= 2)
 			in >> CanChangeName_;
+		if (version >= 3)
+		{
+			QList<QPair<qint64, qint64>> segments;
+			in >> segments;
+
+			Segments_.clear ();
+			for (const auto& pair : segments)
+				Segments_.append ({ nullptr, pair.first, pair.second, 0 });
+		}
 
-		if (version < 1 || version > 2)
+		if (version < 1 || version > 3)
 			throw std::runtime_error ("Unknown version");
 	}
 
@@ -268,7 +380,7 @@ namespace CSTP
 
 	QString Task::GetState () const
 	{
-		if (!Reply_.get ())
+		if (!Reply_.get () && !HasRunningSegments ())
 			return tr ("Stopped");
 		else if (Done_ == Total_)
 			return tr ("Finished");
@@ -288,12 +400,17 @@ namespace CSTP
 
 	bool Task::IsRunning () const
 	{
-		return Reply_.get () && !URL_.isEmpty ();
+		return (Reply_.get () || HasRunningSegments () || PendingFileOps_) &&
+				!URL_.isEmpty ();
 	}
 
 	QString Task::GetErrorString () const
 	{
-		return Reply_.get () ? Reply_->errorString () : tr ("Task isn't initialized properly");
+		if (Reply_.get ())
+			return Reply_->errorString ();
+		if (!LastError_.isEmpty ())
+			return LastError_;
+		return tr ("Task isn't initialized properly");
 	}
 
 	void Task::Reset ()
@@ -304,11 +421,13 @@ namespace CSTP
 		Speed_ = 0;
 		FileSizeAtStart_ = -1;
 		Reply_.reset ();
+		StopSegments ();
+		Segments_.clear ();
 	}
 
 	void Task::RecalculateSpeed ()
 	{
-		Speed_ = static_cast<double> (Done_ * 1000) / static_cast<double> (StartTime_.elapsed ());
+		Speed_ = static_cast<double> ((Done_ - DoneAtStart_) * 1000) / static_cast<double> (StartTime_.elapsed ());
 	}
 
 	void Task::HandleMetadataRedirection ()
@@ -332,7 +451,7 @@ namespace CSTP
 				<< newUrl
 				<< "for"
 				<< Reply_->url ();
-			emit done (true);
+			Finish (true);
 		}
 		else
 		{
@@ -432,24 +551,38 @@ namespace CSTP
 			return;
 		}
 
-		QIODevice::OpenMode om = To_->openMode ();
-		To_->close ();
-
-		if (!To_->rename (path))
-		{
-			qWarning () << Q_FUNC_INFO
-				<< "failed to rename to"
-				<< path
-				<< To_->errorString ();
-		}
-		if (!To_->open (om))
-		{
-			qWarning () << Q_FUNC_INFO
-				<< "failed to re-open the renamed file"
-				<< path;
-			To_->rename (oldPath);
-			To_->open (om);
-		}
+		// The file is closed and renamed by the writer thread, but its
+		// name is only changed here, as the GUI thread reads it.
+		const auto om = std::make_shared<QIODevice::OpenMode> ();
+		RunFileOp ([this, om, path, oldPath]
+				{
+					return GetWriter ()->Schedule (To_,
+							[om, path, oldPath] (QFile *file) -> bool
+							{
+								*om = file->openMode ();
+								file->close ();
+								if (QFile::rename (oldPath, path))
+									return true;
+
+								qWarning () << Q_FUNC_INFO
+									<< "failed to rename to"
+									<< path;
+								return false;
+							});
+				},
+				[this, om, path, oldPath] (bool renamed) -> void
+				{
+					To_->setFileName (renamed ? path : oldPath);
+					if (*om == QIODevice::NotOpen || To_->open (*om))
+						return;
+
+					qWarning () << Q_FUNC_INFO
+						<< "failed to re-open the renamed file"
+						<< path;
+					if (QFile::rename (path, oldPath))
+						To_->setFileName (oldPath);
+					To_->open (*om);
+				});
 	}
 
 	void Task::Cleanup ()
@@ -466,6 +599,332 @@ namespace CSTP
 		Reply_.reset ();
 	}
 
+	void Task::Finish (bool error)
+	{
+		if (!To_)
+		{
+			emit done (error);
+			return;
+		}
+
+		RunFileOp ([this] { return GetWriter ()->Close (To_); },
+				[this, error] (bool) { emit done (error); });
+	}
+
+	void Task::WhenIdle (const std::function<void ()>& action)
+	{
+		IdleActions_ << action;
+		RunIdleActions ();
+	}
+
+	void Task::RunIdleActions ()
+	{
+		QPointer<Task> guard (this);
+		while (guard && !PendingFileOps_ && !IdleActions_.isEmpty ())
+			IdleActions_.takeFirst () ();
+	}
+
+	void Task::RunFileOp (const std::function<QFuture<bool> ()>& op,
+			const std::function<void (bool)>& handler)
+	{
+		WhenIdle ([this, op, handler] () -> void
+				{
+					++PendingFileOps_;
+					WhenFinished (op (), this,
+							[this, handler] (bool result) -> void
+							{
+								--PendingFileOps_;
+
+								QPointer<Task> guard (this);
+								handler (result);
+								if (guard)
+									RunIdleActions ();
+								if (guard && !PendingFileOps_)
+									resumeReading ();
+							});
+				});
+	}
+
+	QNetworkRequest Task::MakeRequest () const
+	{
+		QString ua = XmlSettingsManager::Instance ()
+			.property ("UserUserAgent").toString ();
+		if (ua.isEmpty ())
+			ua = XmlSettingsManager::Instance ()
+				.property ("PredefinedUserAgent").toString ();
+
+		if (ua == "%leechcraft%")
+			ua = "LeechCraft.CSTP/" + Core::Instance ().GetCoreProxy ()->GetVersion ();
+
+		QNetworkRequest req (URL_);
+		req.setRawHeader ("User-Agent", ua.toLatin1 ());
+
+		if (Referer_.isEmpty ())
+			req.setRawHeader ("Referer", QString (QString ("http://") + URL_.host ()).toLatin1 ());
+		else
+			req.setRawHeader ("Referer", Referer_.toEncoded ());
+
+		req.setRawHeader ("Host", URL_.host ().toLatin1 ());
+		req.setRawHeader ("Origin", URL_.scheme ().toLatin1 () + "://" + URL_.host ().toLatin1 ());
+		req.setRawHeader ("Accept", "*/*");
+		return req;
+	}
+
+	void Task::ReportWriteError (const QString& error)
+	{
+		qWarning () << Q_FUNC_INFO
+				<< "Error writing to file:"
+				<< To_->fileName ()
+				<< error;
+
+		QString errString = tr ("Error writing to file %1: %2")
+				.arg (To_->fileName ())
+				.arg (error);
+		Entity e = Util::MakeNotification ("LeechCraft CSTP",
+				errString,
+				PCritical_);
+		emit gotEntity (e);
+	}
+
+	bool Task::TrySplitIntoSegments ()
+	{
+		if (SegmentsForbidden_ ||
+				!Reply_ ||
+				URL_.isEmpty () ||
+				!Segments_.isEmpty () ||
+				FileSizeAtStart_ ||
+				Params_.value ("Operation", QNetworkAccessManager::GetOperation).toInt () !=
+						QNetworkAccessManager::GetOperation)
+			return false;
+
+		if (Reply_->attribute (QNetworkRequest::HttpStatusCodeAttribute).toInt () != 200 ||
+				!Reply_->rawHeader ("Accept-Ranges").toLower ().contains ("bytes"))
+			return false;
+
+		const auto length = Reply_->header (QNetworkRequest::ContentLengthHeader).toLongLong ();
+		const auto count = std::min<qint64> (GetSegmentsCount (), length / GetMinSegmentSize ());
+		if (count < 2)
+			return false;
+
+		qDebug () << Q_FUNC_INFO
+				<< "splitting"
+				<< URL_
+				<< "of size"
+				<< length
+				<< "into"
+				<< count
+				<< "segments";
+
+		// The single-stream reply has served its purpose of probing the
+		// server, the segments will refetch everything by ranges.
+		disconnect (Reply_.get (),
+				0,
+				this,
+				0);
+		Reply_->abort ();
+		Cleanup ();
+
+		Total_ = length;
+		Done_ = 0;
+		DoneAtStart_ = 0;
+		LastError_.clear ();
+		StartTime_.restart ();
+
+		const auto segmentSize = length / count;
+		for (qint64 i = 0; i < count; ++i)
+		{
+			const auto end = i == count - 1 ? length : (i + 1) * segmentSize;
+			Segments_.append ({ nullptr, i * segmentSize, end, 0 });
+		}
+
+		for (auto& segment : Segments_)
+			StartSegment (segment);
+
+		// Nothing is read until the file is preallocated.
+		RunFileOp ([this, length] { return GetWriter ()->Resize (To_, length); },
+				[this] (bool ok) -> void
+				{
+					if (!ok && !Stopping_ && HasRunningSegments ())
+						FallbackToSingleStream ();
+				});
+
+		return true;
+	}
+
+	void Task::StartSegment (Segment& segment)
+	{
+		auto req = MakeRequest ();
+		req.setRawHeader ("Range",
+				QString ("bytes=%1-%2").arg (segment.Pos_).arg (segment.End_ - 1).toLatin1 ());
+
+		segment.Reply_ = Core::Instance ().GetNetworkAccessManager ()->get (req);
+		segment.Reply_->setReadBufferSize (ReplyReadBufferSize);
+		connect (segment.Reply_,
+				SIGNAL (metaDataChanged ()),
+				this,
+				SLOT (handleSegmentMetaDataChanged ()));
+		connect (segment.Reply_,
+				SIGNAL (readyRead ()),
+				this,
+				SLOT (handleSegmentReadyRead ()));
+		connect (segment.Reply_,
+				SIGNAL (finished ()),
+				this,
+				SLOT (handleSegmentFinished ()));
+	}
+
+	void Task::ReleaseSegmentReply (Segment& segment)
+	{
+		if (!segment.Reply_)
+			return;
+
+		const auto reply = segment.Reply_;
+		segment.Reply_ = nullptr;
+
+		disconnect (reply,
+				0,
+				this,
+				0);
+		reply->abort ();
+		Core::Instance ().RemoveFinishedReply (reply);
+		reply->deleteLater ();
+	}
+
+	void Task::StopSegments ()
+	{
+		for (auto& segment : Segments_)
+			ReleaseSegmentReply (segment);
+	}
+
+	bool Task::HasRunningSegments () const
+	{
+		return std::any_of (Segments_.begin (), Segments_.end (),
+				[] (const Segment& segment) { return segment.Reply_; });
+	}
+
+	int Task::FindSegment (QObject *reply) const
+	{
+		for (int i = 0; i < Segments_.size (); ++i)
+			if (Segments_.at (i).Reply_ == reply)
+				return i;
+		return -1;
+	}
+
+	void Task::WriteSegmentData (Segment& segment, bool force)
+	{
+		auto toRead = std::min (segment.Reply_->bytesAvailable (), segment.End_ - segment.Pos_);
+		if (!force)
+		{
+			const auto allowance = GetReadAllowance ();
+			if (allowance < toRead)
+			{
+				ReadStalled_ = true;
+				toRead = allowance;
+			}
+		}
+		if (toRead <= 0)
+			return;
+
+		const auto& data = segment.Reply_->read (toRead);
+		ConsumeReadAllowance (data.size ());
+		GetWriter ()->Write (To_, segment.Pos_, data);
+
+		segment.Pos_ += data.size ();
+		Done_ += data.size ();
+		RecalculateSpeed ();
+	}
+
+	qint64 Task::GetReadAllowance ()
+	{
+		if (PendingFileOps_ || GetWriter ()->IsFull ())
+			return 0;
+
+		return std::min (Limiter_.GetAvailable (),
+				Core::Instance ().GetGlobalLimiter ().GetAvailable ());
+	}
+
+	void Task::ConsumeReadAllowance (qint64 bytes)
+	{
+		Limiter_.Consume (bytes);
+		Core::Instance ().GetGlobalLimiter ().Consume (bytes);
+	}
+
+	void Task::ReadSegment (int idx, bool force)
+	{
+		auto& segment = Segments_ [idx];
+		WriteSegmentData (segment, force);
+
+		if (segment.Pos_ >= segment.End_)
+			FinishSegment (idx);
+	}
+
+	void Task::FinishSegment (int idx)
+	{
+		auto& finished = Segments_ [idx];
+		ReleaseSegmentReply (finished);
+
+		// Steal the second half of the biggest remaining segment, if it's
+		// big enough to be worth another connection.
+		int victimIdx = -1;
+		qint64 victimRemaining = 2 * GetMinSegmentSize ();
+		for (int i = 0; i < Segments_.size (); ++i)
+		{
+			const auto& segment = Segments_.at (i);
+			const auto remaining = segment.End_ - segment.Pos_;
+			if (i != idx && segment.Reply_ && remaining >= victimRemaining)
+			{
+				victimIdx = i;
+				victimRemaining = remaining;
+			}
+		}
+
+		if (victimIdx != -1)
+		{
+			auto& victim = Segments_ [victimIdx];
+			const auto mid = victim.Pos_ + victimRemaining / 2;
+
+			finished.Pos_ = mid;
+			finished.End_ = victim.End_;
+			finished.Retries_ = 0;
+			victim.End_ = mid;
+
+			StartSegment (finished);
+			return;
+		}
+
+		Segments_.removeAt (idx);
+		if (!Segments_.isEmpty ())
+			return;
+
+		Done_ = Total_;
+		emit updateInterface ();
+		Finish (false);
+	}
+
+	void Task::FallbackToSingleStream ()
+	{
+		qWarning () << Q_FUNC_INFO
+				<< URL_
+				<< "doesn't honor ranges, falling back to a single stream";
+
+		StopSegments ();
+		Segments_.clear ();
+		SegmentsForbidden_ = true;
+
+		Done_ = -1;
+		Total_ = 0;
+		RunFileOp ([this]
+				{
+					return GetWriter ()->Schedule (To_,
+							[] (QFile *file) { return file->resize (0) && file->seek (0); });
+				},
+				[this] (bool) -> void
+				{
+					if (!Stopping_)
+						Start (To_);
+				});
+	}
+
 	void Task::handleDataTransferProgress (qint64 done, qint64 total)
 	{
 		Done_ = done;
@@ -479,58 +938,67 @@ namespace CSTP
 
 	void Task::redirectedConstruction (const QByteArray& newUrl)
 	{
-		if (To_ && FileSizeAtStart_ >= 0)
-		{
-			To_->close ();
-			To_->resize (FileSizeAtStart_);
-			To_->open (QIODevice::ReadWrite);
-		}
-
 		Reply_.reset ();
 
 		Referer_ = URL_;
 		URL_ = QUrl::fromEncoded (newUrl);
-		Start (To_);
+
+		if (!To_ || FileSizeAtStart_ < 0)
+		{
+			Start (To_);
+			return;
+		}
+
+		const auto size = FileSizeAtStart_;
+		RunFileOp ([this, size]
+				{
+					return GetWriter ()->Schedule (To_,
+							[size] (QFile *file) -> bool
+							{
+								file->close ();
+								const bool resized = file->resize (size);
+								return file->open (QIODevice::ReadWrite) && resized;
+							});
+				},
+				[this] (bool) -> void
+				{
+					if (!Stopping_)
+						Start (To_);
+				});
 	}
 
 	void Task::handleMetaDataChanged ()
 	{
 		HandleMetadataRedirection ();
 		HandleMetadataFilename ();
+		TrySplitIntoSegments ();
 	}
 
-	void Task::handleLocalTransfer ()
+	namespace
 	{
-		QString localFile = URL_.toLocalFile ();
-		qDebug () << "LOCAL FILE" << localFile << To_->fileName ();
-		QFileInfo fi (localFile);
-		if (!fi.isFile ())
+		bool CopyLocalFile (const QString& localFile, const std::shared_ptr<QFile>& to)
 		{
-			qWarning () << Q_FUNC_INFO
-					<< URL_
-					<< "is not a file";
-			QTimer::singleShot (0,
-					this,
-					SLOT (handleError ()));
-			return;
-		}
+			if (!QFileInfo (localFile).isFile ())
+			{
+				qWarning () << Q_FUNC_INFO
+						<< localFile
+						<< "is not a file";
+				return false;
+			}
 
-		QString destination = To_->fileName ();
-		QFile file (localFile);
-		To_->close ();
-		if (!To_->remove () ||
-				!file.copy (destination))
-		{
-			if (!To_->open (QIODevice::WriteOnly))
+			const QString destination = to->fileName ();
+			QFile file (localFile);
+			to->close ();
+			if (to->remove () && file.copy (destination))
+				return true;
+
+			if (!to->open (QIODevice::WriteOnly))
 			{
 				qWarning () << Q_FUNC_INFO
 						<< "unable to open destfile"
-						<< To_->fileName ()
+						<< to->fileName ()
 						<< "for writing";
-				QTimer::singleShot (0,
-						this,
-						SLOT (handleError ()));
-				return;
+				return false;
 			}
 
 			if (!file.open (QIODevice::ReadOnly))
@@ -539,49 +1007,54 @@ namespace CSTP
 						<< "unable to open sourcefile"
 						<< file.fileName ()
 						<< "for reading";
-				QTimer::singleShot (0,
-						this,
-						SLOT (handleError ()));
-				return;
+				return false;
 			}
 
 			const int chunkSize = 10 * 1024 * 1024;
 			QByteArray chunk = file.read (chunkSize);
 			while (chunk.size ())
 			{
-				To_->write (chunk);
+				if (to->write (chunk) != chunk.size ())
+				{
+					qWarning () << Q_FUNC_INFO
+							<< "unable to write to"
+							<< to->fileName ()
+							<< to->errorString ();
+					return false;
+				}
 				chunk = file.read (chunkSize);
 			}
+			return true;
 		}
+	}
 
-		QTimer::singleShot (0,
-				this,
-				SLOT (handleFinished ()));
+	void Task::StartLocalTransfer ()
+	{
+		const auto& localFile = URL_.toLocalFile ();
+		qDebug () << "LOCAL FILE" << localFile << To_->fileName ();
+
+		// Counts as a pending file operation, so the task is reported as
+		// running while the copy is in progress.
+		RunFileOp ([this, localFile] { return QtConcurrent::run (CopyLocalFile, localFile, To_); },
+				[this] (bool ok) -> void
+				{
+					if (ok)
+						handleFinished ();
+					else
+						handleError ();
+				});
 	}
 
 	bool Task::handleReadyRead ()
 	{
 		if (Reply_.get ())
 		{
-			quint64 avail = Reply_->bytesAvailable ();
-			quint64 res = To_->write (Reply_->readAll ());
-			if ((static_cast<quint64> (-1) == res) ||
-					(res != avail))
-			{
-				qWarning () << Q_FUNC_INFO
-						<< "Error writing to file:"
-						<< To_->fileName ()
-						<< To_->errorString ();
-
-				QString errString = tr ("Error writing to file %1: %2")
-						.arg (To_->fileName ())
-						.arg (To_->errorString ());
-				Entity e = Util::MakeNotification ("LeechCraft CSTP",
-						errString,
-						PCritical_);
-				emit gotEntity (e);
-				emit done (true);
-			}
+			const auto& data = Reply_->read (std::min (GetReadAllowance (), Reply_->bytesAvailable ()));
+			ConsumeReadAllowance (data.size ());
+			GetWriter ()->Write (To_, -1, data);
+
+			if (Reply_->bytesAvailable ())
+				ReadStalled_ = true;
 		}
 		if (URL_.isEmpty () &&
 				Core::Instance ().HasFinishedReply (Reply_.get ()))
@@ -594,14 +1067,144 @@ namespace CSTP
 
 	void Task::handleFinished ()
 	{
-		Cleanup ();
-		emit done (false);
+		// The rest of the data may only be written once the file is in
+		// place again.
+		WhenIdle ([this] () -> void
+				{
+					if (Reply_ && Reply_->bytesAvailable ())
+					{
+						const auto& data = Reply_->readAll ();
+						ConsumeReadAllowance (data.size ());
+						GetWriter ()->Write (To_, -1, data);
+					}
+
+					Cleanup ();
+					Finish (false);
+				});
 	}
 
 	void Task::handleError ()
 	{
 		Cleanup ();
-		emit done (true);
+		Finish (true);
+	}
+
+	void Task::handleSegmentMetaDataChanged ()
+	{
+		const auto reply = qobject_cast<QNetworkReply*> (sender ());
+		if (!reply || FindSegment (reply) == -1)
+			return;
+
+		const auto status = reply->attribute (QNetworkRequest::HttpStatusCodeAttribute);
+		if (status.isValid () && status.toInt () != 206)
+			FallbackToSingleStream ();
+	}
+
+	void Task::handleSegmentReadyRead ()
+	{
+		const auto idx = FindSegment (sender ());
+		if (idx == -1)
+			return;
+
+		ReadSegment (idx, false);
+	}
+
+	void Task::handleSegmentFinished ()
+	{
+		const auto reply = sender ();
+		WhenIdle ([this, reply] { HandleSegmentFinished (reply); });
+	}
+
+	void Task::HandleSegmentFinished (QObject *reply)
+	{
+		const auto idx = FindSegment (reply);
+		if (idx == -1)
+			return;
+
+		auto& segment = Segments_ [idx];
+		if (segment.Reply_->error () == QNetworkReply::NoError)
+			WriteSegmentData (segment, true);
+
+		if (segment.Pos_ >= segment.End_)
+		{
+			FinishSegment (idx);
+			return;
+		}
+
+		const auto& errorString = segment.Reply_->errorString ();
+		qWarning () << Q_FUNC_INFO
+				<< "segment"
+				<< segment.Pos_
+				<< segment.End_
+				<< "of"
+				<< URL_
+				<< "finished prematurely:"
+				<< errorString;
+
+		ReleaseSegmentReply (segment);
+		if (++segment.Retries_ <= MaxSegmentRetries)
+		{
+			StartSegment (segment);
+			return;
+		}
+
+		LastError_ = errorString;
+		StopSegments ();
+		Finish (true);
+	}
+
+	void Task::resumeReading ()
+	{
+		if (!ReadStalled_)
+			return;
+
+		ReadStalled_ = false;
+
+		if (Reply_)
+		{
+			handleReadyRead ();
+			return;
+		}
+
+		QList<QNetworkReply*> replies;
+		for (const auto& segment : Segments_)
+			if (segment.Reply_)
+				replies << segment.Reply_;
+
+		// Finishing the last segment may lead to this task being deleted.
+		QPointer<Task> guard (this);
+		for (const auto reply : replies)
+		{
+			const auto idx = FindSegment (reply);
+			if (idx == -1)
+				continue;
+
+			ReadSegment (idx, false);
+			if (!guard || ReadStalled_)
+				return;
+		}
+	}
+
+	void Task::handleWriteFailed (std::shared_ptr<QFile> file, const QString& error)
+	{
+		if (file != To_ || (!Reply_ && !HasRunningSegments ()))
+			return;
+
+		ReportWriteError (error);
+
+		StopSegments ();
+		if (Reply_)
+		{
+			disconnect (Reply_.get (),
+					0,
+					this,
+					0);
+			Reply_->abort ();
+			Cleanup ();
+		}
+
+		LastError_ = error;
+		Finish (true);
 	}
 }
 }
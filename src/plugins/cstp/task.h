@@ -30,12 +30,15 @@
 #pragma once
 
 #include <memory>
+#include <functional>
 #include <QObject>
 #include <QUrl>
 #include <QTime>
 #include <QNetworkReply>
 #include <QStringList>
+#include <QFuture>
 #include <interfaces/structures.h>
+#include "ratelimiter.h"
 
 class QAuthenticator;
 class QNetworkProxy;
@@ -64,13 +67,42 @@ namespace CSTP
 
 		QUrl Referer_;
 		const QVariantMap Params_;
+
+		/** A byte range [Pos_; End_) of the file that is still to be
+			* downloaded, possibly via its own ranged request.
+			*/
+		struct Segment
+		{
+			QNetworkReply *Reply_;
+			qint64 Pos_;
+			qint64 End_;
+			int Retries_;
+		};
+		QList<Segment> Segments_;
+		bool SegmentsForbidden_;
+		qint64 DoneAtStart_;
+		QString LastError_;
+
+		bool ReadStalled_;
+		RateLimiter Limiter_;
+
+		/** Operations on To_ are run off the GUI thread one at a time,
+			* and nothing is read from the network while one is pending.
+			* The actions in IdleActions_ are run in order once there are
+			* no pending operations.
+			*/
+		int PendingFileOps_;
+		QList<std::function<void ()>> IdleActions_;
+		bool Stopping_;
 	public:
 		explicit Task (const QUrl& url = QUrl (), const QVariantMap& params = QVariantMap ());
 		explicit Task (QNetworkReply*);
+		~Task ();
 
 		void Start (const std::shared_ptr<QFile>&);
 		void Stop ();
 		void ForbidNameChanges ();
+		void SetSpeedLimit (qint64);
 
 		QByteArray Serialize () const;
 		void Deserialize (QByteArray&);
@@ -90,20 +122,54 @@ namespace CSTP
 		void HandleMetadataFilename ();
 
 		void Cleanup ();
+		void Finish (bool error);
+
+		void WhenIdle (const std::function<void ()>&);
+		void RunIdleActions ();
+		void RunFileOp (const std::function<QFuture<bool> ()>& op,
+				const std::function<void (bool)>& handler);
+
+		QNetworkRequest MakeRequest () const;
+		void ReportWriteError (const QString&);
+
+		bool TrySplitIntoSegments ();
+		void StartSegment (Segment&);
+		void ReleaseSegmentReply (Segment&);
+		void StopSegments ();
+		bool HasRunningSegments () const;
+		int FindSegment (QObject*) const;
+		void WriteSegmentData (Segment&, bool force);
+		void ReadSegment (int, bool force);
+		qint64 GetReadAllowance ();
+		void ConsumeReadAllowance (qint64);
+		void FinishSegment (int);
+		void HandleSegmentFinished (QObject*);
+		void FallbackToSingleStream ();
+		void StartLocalTransfer ();
 	private slots:
 		void handleDataTransferProgress (qint64, qint64);
 		void redirectedConstruction (const QByteArray&);
 		void handleMetaDataChanged ();
-		void handleLocalTransfer ();
 		/** Returns true if the reply is at end after this read.
 			*/
 		bool handleReadyRead ();
 		void handleFinished ();
 		void handleError ();
+
+		void handleSegmentMetaDataChanged ();
+		void handleSegmentReadyRead ();
+		void handleSegmentFinished ();
+
+		void resumeReading ();
+		void handleWriteFailed (std::shared_ptr<QFile>, const QString&);
 	signals:
 		void gotEntity (const LeechCraft::Entity&);
 		void updateInterface ();
 		void done (bool);
+
+		/** Emitted once the file is closed after Stop().
+			*/
+		void stopped ();
 	};
 }
 }
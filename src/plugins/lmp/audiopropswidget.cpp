@@ -36,7 +36,6 @@
 #include <QStandardItemModel>
 #include <QMessageBox>
 #include <QClipboard>
-#include <QMutexLocker>
 #include <QFileInfo>
 #include <QtDebug>
 #include <taglib/taglib_config.h>
@@ -326,8 +325,6 @@ namespace LMP
 		if (info.LocalPath_.isEmpty ())
 			return;
 
-		QMutexLocker tlLocker (&Core::Instance ().GetLocalFileResolver ()->GetMutex ());
-
 		auto r = Core::Instance ().GetLocalFileResolver ()->GetFileRef (info.LocalPath_);
 		auto tag = r.tag ();
 		if (!tag)
@@ -33,11 +33,13 @@
 #include <numeric>
 #include <QStandardItemModel>
 #include <QSortFilterProxyModel>
+#include <QDir>
 #include <QtConcurrentMap>
 #include <QtConcurrentRun>
 #include <QTimer>
 #include <QtDebug>
 #include <util/xpc/util.h>
+#include <util/sll/slotclosure.h>
 #include "localcollectionstorage.h"
 #include "core.h"
 #include "util.h"
@@ -65,6 +67,8 @@ namespace LMP
 	, UpdateNewArtists_ (0)
 	, UpdateNewAlbums_ (0)
 	, UpdateNewTracks_ (0)
+	, ResolvingLengths_ (false)
+	, ResolveLengthsAgain_ (false)
 	{
 		connect (Watcher_,
 				SIGNAL (finished ()),
@@ -151,7 +155,41 @@ namespace LMP
 		{
 			QSet<QString> UnchangedFiles_;
 			QSet<QString> ChangedFiles_;
+			QStringList SkippedDirs_;
 		};
+
+		QList<QFileInfo> IterateChangedDir (const QString& dirPath, bool symLinks,
+				const QSet<QString>& knownPaths, QStringList& skippedDirs)
+		{
+			const QDir dir (dirPath);
+			const auto& prefix = dir.absolutePath () + '/';
+
+			QSet<QString> knownSubdirs;
+			for (const auto& path : knownPaths)
+			{
+				if (!path.startsWith (prefix))
+					continue;
+
+				const auto slashPos = path.indexOf ('/', prefix.size ());
+				if (slashPos != -1)
+					knownSubdirs << path.left (slashPos);
+			}
+
+			auto filters = QDir::AllDirs | QDir::Files | QDir::NoDotAndDotDot;
+			if (!symLinks)
+				filters |= QDir::NoSymLinks;
+
+			QList<QFileInfo> result;
+			for (const auto& entryInfo : dir.entryInfoList (filters))
+			{
+				const auto& path = entryInfo.absoluteFilePath ();
+				if (entryInfo.isDir () && knownSubdirs.contains (path))
+					skippedDirs << path;
+				else
+					result += RecIterateInfo (path, symLinks);
+			}
+			return result;
+		}
 	}
 
 	void LocalCollection::Scan (const QString& path, bool root)
@@ -168,59 +206,98 @@ namespace LMP
 
 		const bool symLinks = XmlSettingsManager::Instance ()
 				.property ("FollowSymLinks").toBool ();
-		auto worker = [path, symLinks] () -> IterateResult
+		auto worker = [path, symLinks, root] () -> IterateResult
 		{
 			IterateResult result;
 
 			LocalCollectionStorage storage;
 
-			const auto& paths = storage.GetTracksPaths ();
+			const auto& paths = QSet<QString>::fromList (storage.GetTracksPaths ());
 
-			const auto& allInfos = RecIterateInfo (path, symLinks);
+			QHash<QString, QDateTime> storedMTimes;
+			try
+			{
+				storedMTimes = storage.GetMTimes ();
+			}
+			catch (const std::exception& e)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "error getting mtimes"
+						<< e.what ();
+			}
+
+			const auto& allInfos = root ?
+					RecIterateInfo (path, symLinks) :
+					IterateChangedDir (path, symLinks, paths, result.SkippedDirs_);
+
+			QList<QPair<QString, QDateTime>> changedMTimes;
 			for (const auto& info : allInfos)
 			{
 				const auto& trackPath = info.absoluteFilePath ();
 				const auto& mtime = info.lastModified ();
-				try
-				{
-					const auto& storedDt = storage.GetMTime (trackPath);
-					if (storedDt.isValid () &&
-							std::abs (storedDt.msecsTo (mtime)) < 1500)
-					{
-						result.UnchangedFiles_ << trackPath;
-						continue;
-					}
-				}
-				catch (const std::exception& e)
+
+				const auto& storedDt = storedMTimes.value (trackPath);
+				if (storedDt.isValid () &&
+						std::abs (storedDt.msecsTo (mtime)) < 1500)
 				{
-					qWarning () << Q_FUNC_INFO
-							<< "error getting mtime"
-							<< trackPath
-							<< e.what ();
+					result.UnchangedFiles_ << trackPath;
+					continue;
 				}
 
 				if (paths.contains (trackPath))
-				{
-					try
-					{
-						storage.SetMTime (trackPath, mtime);
-					}
-					catch (const std::exception& e)
-					{
-						qWarning () << Q_FUNC_INFO
-								<< "error setting mtime"
-								<< trackPath
-								<< e.what ();
-					}
-				}
+					changedMTimes.append (qMakePair (trackPath, mtime));
 				result.ChangedFiles_ << trackPath;
 			}
 
+			try
+			{
+				storage.SetMTimes (changedMTimes);
+			}
+			catch (const std::exception& e)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "error setting mtimes"
+						<< e.what ();
+			}
+
 			return result;
 		};
 		watcher->setFuture (QtConcurrent::run (worker));
 	}
 
+	void LocalCollection::ScanFiles (const QStringList& files)
+	{
+		QSet<QString> changed;
+		QList<QPair<QString, QDateTime>> mtimes;
+		for (const auto& file : files)
+			for (const auto& info : RecIterateInfo (file))
+			{
+				const auto& path = info.absoluteFilePath ();
+				changed << path;
+				if (PresentPaths_.contains (path))
+					mtimes.append (qMakePair (path, info.lastModified ()));
+			}
+
+		if (changed.isEmpty ())
+			return;
+
+		try
+		{
+			Storage_->SetMTimes (mtimes);
+		}
+		catch (const std::exception& e)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "error setting mtimes"
+					<< e.what ();
+		}
+
+		if (Watcher_->isRunning ())
+			NewPathsQueue_ << changed;
+		else
+			InitiateScan (changed);
+	}
+
 	void LocalCollection::Unscan (const QString& path)
 	{
 		if (!RootPaths_.contains (path))
@@ -669,14 +746,21 @@ namespace LMP
 			emit rootPathsChanged (RootPaths_);
 	}
 
-	void LocalCollection::CheckRemovedFiles (const QSet<QString>& scanned, const QString& rootPath)
+	void LocalCollection::CheckRemovedFiles (const QSet<QString>& scanned,
+			const QString& rootPath, const QStringList& skippedDirs)
 	{
 		auto toRemove = PresentPaths_;
 		toRemove.subtract (scanned);
 
+		auto isSkipped = [&skippedDirs] (const QString& path)
+		{
+			return std::any_of (skippedDirs.begin (), skippedDirs.end (),
+					[&path] (const QString& dir) { return path.startsWith (dir + '/'); });
+		};
+
 		for (auto pos = toRemove.begin (); pos != toRemove.end (); )
 		{
-			if (pos->startsWith (rootPath))
+			if (pos->startsWith (rootPath) && !isSkipped (*pos))
 				++pos;
 			else
 				pos = toRemove.erase (pos);
@@ -695,7 +779,7 @@ namespace LMP
 		{
 			try
 			{
-				return resolver->ResolveInfo (path);
+				return resolver->ResolveInfo (path, TagLib::AudioProperties::Fast);
 			}
 			catch (const ResolveError& error)
 			{
@@ -711,6 +795,108 @@ namespace LMP
 		Watcher_->setFuture (future);
 	}
 
+	void LocalCollection::ResolveEstimatedLengths ()
+	{
+		if (ResolvingLengths_)
+		{
+			ResolveLengthsAgain_ = true;
+			return;
+		}
+
+		QList<QPair<int, QString>> tracks;
+		try
+		{
+			tracks = Storage_->GetEstimatedLengthTracks ();
+		}
+		catch (const std::exception& e)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "cannot get tracks with estimated lengths:"
+					<< e.what ();
+			return;
+		}
+
+		if (tracks.isEmpty ())
+			return;
+
+		ResolvingLengths_ = true;
+
+		auto resolver = Core::Instance ().GetLocalFileResolver ();
+		auto worker = [resolver, tracks] () -> QList<QPair<int, int>>
+		{
+			// Files that fail to resolve keep their marks and are retried
+			// the next time.
+			QList<QPair<int, int>> result;
+			for (const auto& pair : tracks)
+			{
+				try
+				{
+					result << qMakePair (pair.first, resolver->ResolveInfo (pair.second).Length_);
+				}
+				catch (const ResolveError& error)
+				{
+					qWarning () << Q_FUNC_INFO
+							<< "error resolving accurate length for"
+							<< error.GetPath ()
+							<< error.what ();
+				}
+			}
+			return result;
+		};
+
+		auto watcher = new QFutureWatcher<QList<QPair<int, int>>> (this);
+		new Util::SlotClosure<Util::DeleteLaterPolicy>
+		{
+			[this, watcher] () -> void
+			{
+				watcher->deleteLater ();
+				HandleAccurateLengths (watcher->result ());
+
+				ResolvingLengths_ = false;
+				if (ResolveLengthsAgain_)
+				{
+					ResolveLengthsAgain_ = false;
+					ResolveEstimatedLengths ();
+				}
+			},
+			watcher,
+			SIGNAL (finished ()),
+			watcher
+		};
+		watcher->setFuture (QtConcurrent::run (std::function<QList<QPair<int, int>> ()> (worker)));
+	}
+
+	void LocalCollection::HandleAccurateLengths (const QList<QPair<int, int>>& lengths)
+	{
+		try
+		{
+			Storage_->SetAccurateLengths (lengths);
+		}
+		catch (const std::exception& e)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "cannot store accurate lengths:"
+					<< e.what ();
+			return;
+		}
+
+		for (const auto& pair : lengths)
+		{
+			const auto trackId = pair.first;
+			const auto album = GetTrackAlbum (trackId);
+			if (!album)
+				continue;
+
+			const auto pos = std::find_if (album->Tracks_.begin (), album->Tracks_.end (),
+					[trackId] (const Collection::Track& track) { return track.ID_ == trackId; });
+			if (pos == album->Tracks_.end () || pos->Length_ == pair.second)
+				continue;
+
+			pos->Length_ = pair.second;
+			CollectionModel_->SetTrackLength (trackId, pair.second);
+		}
+	}
+
 	void LocalCollection::recordPlayedTrack (const QString& path)
 	{
 		if (!Path2Track_.contains (path))
@@ -761,7 +947,7 @@ namespace LMP
 		auto watcher = dynamic_cast<QFutureWatcher<IterateResult>*> (sender ());
 		const auto& result = watcher->result ();
 
-		CheckRemovedFiles (result.ChangedFiles_ + result.UnchangedFiles_, path);
+		CheckRemovedFiles (result.ChangedFiles_ + result.UnchangedFiles_, path, result.SkippedDirs_);
 
 		if (Watcher_->isRunning ())
 			NewPathsQueue_ << result.ChangedFiles_;
@@ -773,12 +959,15 @@ namespace LMP
 	{
 		auto future = Watcher_->future ();
 		QList<MediaInfo> newInfos, existingInfos;
+		QStringList scannedPaths;
 		for (const auto& info : future)
 		{
 			const auto& path = info.LocalPath_;
 			if (path.isEmpty ())
 				continue;
 
+			scannedPaths << path;
+
 			if (PresentPaths_.contains (path))
 				existingInfos << info;
 			else
@@ -810,6 +999,30 @@ namespace LMP
 		}
 
 		HandleExistingInfos (existingInfos);
+
+		// The scan reads the files with TagLib::AudioProperties::Fast,
+		// so their lengths may be just estimates.
+		QList<int> estimatedIds;
+		for (const auto& path : scannedPaths)
+		{
+			const auto trackId = FindTrack (path);
+			if (trackId >= 0)
+				estimatedIds << trackId;
+		}
+
+		try
+		{
+			Storage_->SetLengthsEstimated (estimatedIds);
+		}
+		catch (const std::exception& e)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "cannot mark estimated lengths:"
+					<< e.what ();
+		}
+
+		if (NewPathsQueue_.isEmpty ())
+			ResolveEstimatedLengths ();
 	}
 
 	void LocalCollection::saveRootPaths ()
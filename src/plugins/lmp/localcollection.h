@@ -88,6 +88,9 @@ namespace LMP
 		int UpdateNewArtists_;
 		int UpdateNewAlbums_;
 		int UpdateNewTracks_;
+
+		bool ResolvingLengths_;
+		bool ResolveLengthsAgain_;
 	public:
 		enum class DynamicPlaylist
 		{
@@ -122,7 +125,20 @@ namespace LMP
 
 		void Clear ();
 
+		/** @brief Scans the given path for new or changed tracks.
+		 *
+		 * If root is true, the path is added to the collection root
+		 * paths and walked recursively. Otherwise the path is treated as
+		 * a changed directory: its subdirectories already containing
+		 * known tracks are skipped, since they are watched on their own.
+		 */
 		void Scan (const QString&, bool root = true);
+
+		/** @brief Rescans the given changed or newly created files.
+		 *
+		 * Files that aren't audio files are ignored.
+		 */
+		void ScanFiles (const QStringList&);
 		void Unscan (const QString&);
 		void Rescan ();
 
@@ -160,9 +176,19 @@ namespace LMP
 		void AddRootPaths (QStringList);
 		void RemoveRootPaths (const QStringList&);
 
-		void CheckRemovedFiles (const QSet<QString>& scanned, const QString& root);
+		void CheckRemovedFiles (const QSet<QString>& scanned,
+				const QString& root, const QStringList& skippedDirs);
 
 		void InitiateScan (const QSet<QString>&);
+
+		/** @brief Rereads the lengths of the tracks scanned with the
+		 * TagLib::AudioProperties::Fast style.
+		 *
+		 * The files are read in background, and the accurate lengths
+		 * are stored both in the collection and in the storage.
+		 */
+		void ResolveEstimatedLengths ();
+		void HandleAccurateLengths (const QList<QPair<int, int>>&);
 	public slots:
 		void recordPlayedTrack (const QString&);
 	private slots:
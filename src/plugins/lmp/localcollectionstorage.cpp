@@ -384,6 +384,35 @@ namespace LMP
 		}
 	}
 
+	QHash<QString, QDateTime> LocalCollectionStorage::GetMTimes ()
+	{
+		if (!GetAllMTimes_.exec ())
+		{
+			Util::DBLock::DumpError (GetAllMTimes_);
+			throw std::runtime_error ("cannot get files mtimes");
+		}
+
+		QHash<QString, QDateTime> result;
+		while (GetAllMTimes_.next ())
+			result [GetAllMTimes_.value (0).toString ()] = GetAllMTimes_.value (1).toDateTime ();
+		GetAllMTimes_.finish ();
+		return result;
+	}
+
+	void LocalCollectionStorage::SetMTimes (const QList<QPair<QString, QDateTime>>& mtimes)
+	{
+		if (mtimes.isEmpty ())
+			return;
+
+		Util::DBLock lock (DB_);
+		lock.Init ();
+
+		for (const auto& pair : mtimes)
+			SetMTime (pair.first, pair.second);
+
+		lock.Good ();
+	}
+
 	const int LovedStateID = 1;
 	const int BannedStateID = 2;
 
@@ -459,6 +488,20 @@ namespace LMP
 		}
 	}
 
+	void LocalCollectionStorage::SetRgTrackInfos (const QList<QPair<int, RGData>>& infos)
+	{
+		if (infos.isEmpty ())
+			return;
+
+		Util::DBLock lock (DB_);
+		lock.Init ();
+
+		for (const auto& pair : infos)
+			SetRgTrackInfo (pair.first, pair.second);
+
+		lock.Good ();
+	}
+
 	RGData LocalCollectionStorage::GetRgTrackInfo (const QString& filepath)
 	{
 		GetTrackRgData_.bindValue (":filepath", filepath);
@@ -485,6 +528,71 @@ namespace LMP
 		return data;
 	}
 
+	QList<QPair<int, QString>> LocalCollectionStorage::GetEstimatedLengthTracks ()
+	{
+		if (!GetEstimatedLengths_.exec ())
+		{
+			Util::DBLock::DumpError (GetEstimatedLengths_);
+			throw std::runtime_error ("cannot fetch tracks with estimated lengths");
+		}
+
+		QList<QPair<int, QString>> result;
+		while (GetEstimatedLengths_.next ())
+			result << qMakePair (GetEstimatedLengths_.value (0).toInt (),
+					GetEstimatedLengths_.value (1).toString ());
+		return result;
+	}
+
+	void LocalCollectionStorage::SetLengthsEstimated (const QList<int>& trackIds)
+	{
+		if (trackIds.isEmpty ())
+			return;
+
+		Util::DBLock lock (DB_);
+		lock.Init ();
+
+		for (const auto trackId : trackIds)
+		{
+			SetLengthEstimated_.bindValue (":track_id", trackId);
+			if (!SetLengthEstimated_.exec ())
+			{
+				Util::DBLock::DumpError (SetLengthEstimated_);
+				throw std::runtime_error ("cannot mark track length as estimated");
+			}
+		}
+
+		lock.Good ();
+	}
+
+	void LocalCollectionStorage::SetAccurateLengths (const QList<QPair<int, int>>& lengths)
+	{
+		if (lengths.isEmpty ())
+			return;
+
+		Util::DBLock lock (DB_);
+		lock.Init ();
+
+		for (const auto& pair : lengths)
+		{
+			SetTrackLength_.bindValue (":track_id", pair.first);
+			SetTrackLength_.bindValue (":length", pair.second);
+			if (!SetTrackLength_.exec ())
+			{
+				Util::DBLock::DumpError (SetTrackLength_);
+				throw std::runtime_error ("cannot set track length");
+			}
+
+			RemoveLengthEstimated_.bindValue (":track_id", pair.first);
+			if (!RemoveLengthEstimated_.exec ())
+			{
+				Util::DBLock::DumpError (RemoveLengthEstimated_);
+				throw std::runtime_error ("cannot unmark estimated track length");
+			}
+		}
+
+		lock.Good ();
+	}
+
 	void LocalCollectionStorage::MarkLovedBanned (int trackId, int state)
 	{
 		SetLovedBanned_.bindValue (":track_id", trackId);
@@ -755,6 +863,9 @@ namespace LMP
 		GetFileMTime_ = QSqlQuery (DB_);
 		GetFileMTime_.prepare ("SELECT MTime FROM fileTimes, tracks WHERE tracks.Path = :filepath AND tracks.Id = fileTimes.TrackID;");
 
+		GetAllMTimes_ = QSqlQuery (DB_);
+		GetAllMTimes_.prepare ("SELECT tracks.Path, fileTimes.MTime FROM tracks INNER JOIN fileTimes ON tracks.Id = fileTimes.TrackID;");
+
 		SetFileMTime_ = QSqlQuery (DB_);
 		SetFileMTime_.prepare ("INSERT OR REPLACE INTO fileTimes (TrackID, MTime) VALUES ((SELECT Id FROM tracks WHERE Path = :filepath), :mtime);");
 
@@ -782,6 +893,18 @@ namespace LMP
 				" VALUES "
 				"(:track_id, :mtime, :track_gain, :track_peak, :album_gain, :album_peak);");
 
+		GetEstimatedLengths_ = QSqlQuery (DB_);
+		GetEstimatedLengths_.prepare ("SELECT tracks.Id, tracks.Path FROM tracks INNER JOIN estimatedLengths ON tracks.Id = estimatedLengths.TrackId;");
+
+		SetLengthEstimated_ = QSqlQuery (DB_);
+		SetLengthEstimated_.prepare ("INSERT OR IGNORE INTO estimatedLengths (TrackId) VALUES (:track_id);");
+
+		SetTrackLength_ = QSqlQuery (DB_);
+		SetTrackLength_.prepare ("UPDATE tracks SET Length = :length WHERE Id = :track_id;");
+
+		RemoveLengthEstimated_ = QSqlQuery (DB_);
+		RemoveLengthEstimated_.prepare ("DELETE FROM estimatedLengths WHERE TrackId = :track_id;");
+
 		AppendToPlayHistory_ = QSqlQuery (DB_);
 		AppendToPlayHistory_.prepare ("INSERT INTO playhistory "
 				"(TrackId, Date) VALUES (:track_id, :date);");
@@ -857,6 +980,11 @@ namespace LMP
 				"AlbumGain DOUBLE NOT NULL, "
 				"AlbumPeak DOUBLE NOT NULL "
 				");");
+		table2query << QueryPair_t ("estimatedLengths",
+				"CREATE TABLE estimatedLengths ("
+				"Id INTEGER PRIMARY KEY AUTOINCREMENT, "
+				"TrackId INTEGER UNIQUE NOT NULL REFERENCES tracks (Id) ON DELETE CASCADE "
+				");");
 		table2query << QueryPair_t ("playhistory",
 				"CREATE TABLE playhistory ("
 				"Id INTEGER PRIMARY KEY AUTOINCREMENT, "
@@ -73,6 +73,7 @@ namespace LMP
 
 		QSqlQuery GetFileIdMTime_;
 		QSqlQuery GetFileMTime_;
+		QSqlQuery GetAllMTimes_;
 		QSqlQuery SetFileMTime_;
 
 		// 1 is loved, 2 is banned
@@ -84,6 +85,11 @@ namespace LMP
 		QSqlQuery GetTrackRgData_;
 		QSqlQuery SetTrackRgData_;
 
+		QSqlQuery GetEstimatedLengths_;
+		QSqlQuery SetLengthEstimated_;
+		QSqlQuery SetTrackLength_;
+		QSqlQuery RemoveLengthEstimated_;
+
 		QSqlQuery AppendToPlayHistory_;
 	public:
 		struct LoadResult
@@ -117,6 +123,9 @@ namespace LMP
 		QDateTime GetMTime (const QString&);
 		void SetMTime (const QString&, const QDateTime&);
 
+		QHash<QString, QDateTime> GetMTimes ();
+		void SetMTimes (const QList<QPair<QString, QDateTime>>&);
+
 		void SetTrackLoved (int);
 		void SetTrackBanned (int);
 		void ClearTrackLovedBanned (int);
@@ -125,7 +134,30 @@ namespace LMP
 
 		QList<int> GetOutdatedRgTracks ();
 		void SetRgTrackInfo (int, const RGData&);
+		void SetRgTrackInfos (const QList<QPair<int, RGData>>&);
 		RGData GetRgTrackInfo (const QString&);
+
+		/** @brief Returns the tracks whose lengths may be estimated.
+		 *
+		 * @return The list of pairs of track IDs and their paths.
+		 *
+		 * @sa SetLengthsEstimated(), SetAccurateLengths()
+		 */
+		QList<QPair<int, QString>> GetEstimatedLengthTracks ();
+
+		/** @brief Marks the lengths of the given tracks as estimated.
+		 *
+		 * The marks are kept until SetAccurateLengths() is called for
+		 * the corresponding tracks or the tracks are removed.
+		 */
+		void SetLengthsEstimated (const QList<int>&);
+
+		/** @brief Stores the accurate lengths of the given tracks.
+		 *
+		 * @param[in] lengths The list of pairs of track IDs and their
+		 * accurate lengths.
+		 */
+		void SetAccurateLengths (const QList<QPair<int, int>>&);
 	private:
 		void MarkLovedBanned (int, int);
 		QList<int> GetLovedBanned (int);
@@ -28,8 +28,9 @@
  **********************************************************************/
 
 #include "localcollectionwatcher.h"
-#include <algorithm>
+#include <stdexcept>
 #include <QTimer>
+#include <QDir>
 #include "core.h"
 #include "localcollection.h"
 #include "recursivedirwatcher.h"
@@ -47,6 +48,18 @@ namespace LMP
 				SIGNAL (directoryChanged (QString)),
 				this,
 				SLOT (handleDirectoryChanged (QString)));
+		connect (Watcher_,
+				SIGNAL (filesChanged (QStringList)),
+				this,
+				SLOT (handleFilesChanged (QStringList)));
+		connect (Watcher_,
+				SIGNAL (filesRemoved (QStringList)),
+				this,
+				SLOT (handleFilesRemoved (QStringList)));
+		connect (Watcher_,
+				SIGNAL (rootRescanRequired (QString)),
+				this,
+				SLOT (handleRootRescanRequired (QString)));
 
 		ScanTimer_->setSingleShot (true);
 		connect (ScanTimer_,
@@ -71,15 +84,10 @@ namespace LMP
 			ScanTimer_->stop ();
 		ScanTimer_->start (2000);
 
-		if (std::any_of (ScheduledDirs_.begin (), ScheduledDirs_.end (),
-				[&dir] (const QString& other) { return dir.startsWith (other); }))
-			return;
-
-		const auto pos = std::remove_if (ScheduledDirs_.begin (), ScheduledDirs_.end (),
-				[&dir] (const QString& other) { return other.startsWith (dir); });
-		ScheduledDirs_.erase (pos, ScheduledDirs_.end ());
-
-		ScheduledDirs_ << dir;
+		// Changed directories are scanned without descending into their
+		// known subdirectories, so a parent doesn't cover its children.
+		if (!ScheduledDirs_.contains (dir))
+			ScheduledDirs_ << dir;
 	}
 
 	void LocalCollectionWatcher::handleDirectoryChanged (const QString& path)
@@ -87,6 +95,38 @@ namespace LMP
 		ScheduleDir (path);
 	}
 
+	void LocalCollectionWatcher::handleFilesChanged (const QStringList& files)
+	{
+		Core::Instance ().GetLocalCollection ()->ScanFiles (files);
+	}
+
+	void LocalCollectionWatcher::handleFilesRemoved (const QStringList& files)
+	{
+		const auto collection = Core::Instance ().GetLocalCollection ();
+		for (const auto& file : files)
+			try
+			{
+				collection->RemoveTrack (file);
+			}
+			catch (const std::exception&)
+			{
+				// RemoveTrack() has already logged the error.
+			}
+	}
+
+	void LocalCollectionWatcher::handleRootRescanRequired (const QString& root)
+	{
+		// The watcher keeps the absolute paths of the roots, while the
+		// collection keeps them the way they were added.
+		const auto collection = Core::Instance ().GetLocalCollection ();
+		for (const auto& dir : collection->GetDirs ())
+			if (QDir { dir }.absolutePath () == root)
+			{
+				collection->Scan (dir, true);
+				return;
+			}
+	}
+
 	void LocalCollectionWatcher::rescanQueue ()
 	{
 		for (const auto& path : ScheduledDirs_)
@@ -32,6 +32,8 @@
 #include <QFileInfo>
 #include <taglib/fileref.h>
 #include <taglib/tag.h>
+#include <taglib/id3v1genres.h>
+#include <taglib/id3v2framefactory.h>
 
 namespace LeechCraft
 {
@@ -54,34 +56,49 @@ namespace LMP
 
 	LocalFileResolver::LocalFileResolver (QObject *parent)
 	: QObject (parent)
+	, Cache_ (4096)
 	{
+		/* Separate FileRefs are safe to use from different threads,
+		 * except for a few global objects that TagLib creates lazily on
+		 * first use without any synchronization. Create them beforehand
+		 * so that ResolveInfo() doesn't need a global lock.
+		 */
+		TagLib::ID3v1::genreList ();
+		TagLib::ID3v2::FrameFactory::instance ();
 	}
 
 	TagLib::FileRef LocalFileResolver::GetFileRef (const QString& file) const
 	{
+		return GetFileRef (file, TagLib::AudioProperties::Accurate);
+	}
+
+	TagLib::FileRef LocalFileResolver::GetFileRef (const QString& file,
+			TagLib::AudioProperties::ReadStyle style) const
+	{
 #ifdef Q_OS_WIN32
-		return TagLib::FileRef (reinterpret_cast<const wchar_t*> (file.utf16 ()));
+		return TagLib::FileRef (reinterpret_cast<const wchar_t*> (file.utf16 ()), true, style);
 #else
-		return TagLib::FileRef (file.toUtf8 ().constData (), true, TagLib::AudioProperties::Accurate);
+		return TagLib::FileRef (file.toUtf8 ().constData (), true, style);
 #endif
 	}
 
 	MediaInfo LocalFileResolver::ResolveInfo (const QString& file)
 	{
-		const auto& modified = QFileInfo (file).lastModified ();
-		{
-			QReadLocker locker (&CacheLock_);
-			if (Cache_.contains (file))
-			{
-				const auto& pair = Cache_ [file];
-				if (pair.first == modified)
-					return pair.second;
-			}
-		}
+		return ResolveInfo (file, TagLib::AudioProperties::Accurate);
+	}
 
-		QMutexLocker tlLocker (&TaglibMutex_);
+	MediaInfo LocalFileResolver::ResolveInfo (const QString& file,
+			TagLib::AudioProperties::ReadStyle style)
+	{
+		const bool wantAccurate = style == TagLib::AudioProperties::Accurate;
 
-		auto r = GetFileRef (file);
+		const auto& modified = QFileInfo (file).lastModified ();
+		if (const auto& entry = Cache_.value (file))
+			if (entry->Modified_ == modified &&
+					(entry->IsAccurate_ || !wantAccurate))
+				return entry->Info_;
+
+		auto r = GetFileRef (file, style);
 		auto tag = r.tag ();
 		if (!tag)
 			throw ResolveError (file, "failed to get file tags");
@@ -104,12 +121,7 @@ namespace LMP
 			static_cast<qint32> (tag->year ()),
 			static_cast<qint32> (tag->track ())
 		};
-		{
-			QWriteLocker locker (&CacheLock_);
-			if (Cache_.size () > 200)
-				Cache_.clear ();
-			Cache_ [file] = qMakePair (modified, info);
-		}
+		Cache_.insert (file, CacheEntry { modified, info, wantAccurate });
 		return info;
 	}
 
@@ -31,11 +31,10 @@
 
 #include <stdexcept>
 #include <QObject>
-#include <QHash>
-#include <QReadWriteLock>
 #include <QMutex>
 #include <QDateTime>
 #include <taglib/fileref.h>
+#include <util/sll/assoccache.h>
 #include "interfaces/lmp/itagresolver.h"
 #include "mediainfo.h"
 
@@ -60,13 +59,44 @@ namespace LMP
 		Q_INTERFACES (LeechCraft::LMP::ITagResolver)
 
 		QMutex TaglibMutex_;
-		QReadWriteLock CacheLock_;
-		QHash<QString, QPair<QDateTime, MediaInfo>> Cache_;
+
+		struct CacheEntry
+		{
+			QDateTime Modified_;
+			MediaInfo Info_;
+			bool IsAccurate_;
+		};
+		Util::ConcurrentAssocCache<QString, CacheEntry> Cache_;
 	public:
 		LocalFileResolver (QObject* = 0);
 
 		TagLib::FileRef GetFileRef (const QString&) const;
+		TagLib::FileRef GetFileRef (const QString&, TagLib::AudioProperties::ReadStyle) const;
+
+		/** @brief Resolves the media info with the accurate track length.
+		 *
+		 * This function may be called from several threads at once.
+		 */
 		MediaInfo ResolveInfo (const QString&);
+
+		/** @brief Resolves the media info reading the audio properties
+		 * in the given style.
+		 *
+		 * The TagLib::AudioProperties::Fast style may only estimate the
+		 * track length for some formats (like VBR MP3 files without the
+		 * Xing header), but avoids scanning the whole file. A later call
+		 * to ResolveInfo() for the same file rereads it to compute the
+		 * accurate length.
+		 *
+		 * This function may be called from several threads at once.
+		 */
+		MediaInfo ResolveInfo (const QString&, TagLib::AudioProperties::ReadStyle);
+
+		/** @brief Returns the mutex guarding tags modifications.
+		 *
+		 * Reading the tags via ResolveInfo() does not lock this mutex,
+		 * so it should only be used to serialize writing the tags.
+		 */
 		QMutex& GetMutex ();
 	};
 }
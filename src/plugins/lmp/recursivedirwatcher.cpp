@@ -29,8 +29,10 @@
 
 #include "recursivedirwatcher.h"
 
-#ifdef Q_OS_MAC
+#if defined (Q_OS_MAC)
 #include "recursivedirwatcher_mac.h"
+#elif defined (ENABLE_INOTIFY)
+#include "recursivedirwatcher_inotify.h"
 #else
 #include "recursivedirwatcher_generic.h"
 #endif
@@ -47,6 +49,21 @@ namespace LMP
 				SIGNAL (directoryChanged (QString)),
 				this,
 				SIGNAL (directoryChanged (QString)));
+
+#if !defined (Q_OS_MAC) && defined (ENABLE_INOTIFY)
+		connect (Impl_,
+				SIGNAL (filesChanged (QStringList)),
+				this,
+				SIGNAL (filesChanged (QStringList)));
+		connect (Impl_,
+				SIGNAL (filesRemoved (QStringList)),
+				this,
+				SIGNAL (filesRemoved (QStringList)));
+		connect (Impl_,
+				SIGNAL (rootRescanRequired (QString)),
+				this,
+				SIGNAL (rootRescanRequired (QString)));
+#endif
 	}
 
 	void RecursiveDirWatcher::AddRoot (const QString& root)
@@ -48,7 +48,31 @@ namespace LMP
 		void AddRoot (const QString&);
 		void RemoveRoot (const QString&);
 	signals:
+		/** @brief Emitted when a directory should be rescanned.
+		 */
 		void directoryChanged (const QString&);
+
+		/** @brief Emitted with the files that were created or modified.
+		 *
+		 * Only the backends that can track individual files emit this
+		 * signal, currently the inotify one. The events are coalesced.
+		 */
+		void filesChanged (const QStringList&);
+
+		/** @brief Emitted with the files that were removed.
+		 *
+		 * Like filesChanged(), this is emitted only by the backends
+		 * tracking individual files.
+		 */
+		void filesRemoved (const QStringList&);
+
+		/** @brief Emitted when the whole tree under the root should be
+		 * rescanned.
+		 *
+		 * This happens when the backend could have missed some changes,
+		 * like when the inotify event queue overflows.
+		 */
+		void rootRescanRequired (const QString&);
 	};
 }
 }
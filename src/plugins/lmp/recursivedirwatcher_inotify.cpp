@@ -0,0 +1,342 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "recursivedirwatcher_inotify.h"
+#include <cerrno>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <QSocketNotifier>
+#include <QTimer>
+#include <QDir>
+#include <QFile>
+#include <QtDebug>
+#include "xmlsettingsmanager.h"
+
+namespace LeechCraft
+{
+namespace LMP
+{
+	namespace
+	{
+		const uint32_t WatchMask = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE |
+				IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+		// How many directories are added to the watch list per event loop
+		// iteration, so that adding a huge collection doesn't freeze the UI.
+		const int WatchBatchSize = 256;
+
+		const int FlushDelay = 1000;
+
+		QString ParentDir (const QString& path)
+		{
+			return path.left (path.lastIndexOf ('/'));
+		}
+	}
+
+	RecursiveDirWatcherImpl::RecursiveDirWatcherImpl (QObject *parent)
+	: QObject { parent }
+	, Fd_ { inotify_init1 (IN_NONBLOCK | IN_CLOEXEC) }
+	, WatchQueueTimer_ { new QTimer { this } }
+	, FlushTimer_ { new QTimer { this } }
+	{
+		connect (WatchQueueTimer_,
+				SIGNAL (timeout ()),
+				this,
+				SLOT (processWatchQueue ()));
+
+		FlushTimer_->setSingleShot (true);
+		connect (FlushTimer_,
+				SIGNAL (timeout ()),
+				this,
+				SLOT (flush ()));
+
+		if (Fd_ < 0)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to initialize inotify:"
+					<< errno;
+			return;
+		}
+
+		Notifier_ = new QSocketNotifier { Fd_, QSocketNotifier::Read, this };
+		connect (Notifier_,
+				SIGNAL (activated (int)),
+				this,
+				SLOT (readEvents ()));
+	}
+
+	RecursiveDirWatcherImpl::~RecursiveDirWatcherImpl ()
+	{
+		if (Fd_ >= 0)
+			close (Fd_);
+	}
+
+	void RecursiveDirWatcherImpl::AddRoot (const QString& root)
+	{
+		if (Fd_ < 0)
+			return;
+
+		const auto& path = QDir { root }.absolutePath ();
+		if (Roots_.contains (path))
+			return;
+
+		Roots_ << path;
+		EnqueueWatch (path);
+	}
+
+	void RecursiveDirWatcherImpl::RemoveRoot (const QString& root)
+	{
+		const auto& path = QDir { root }.absolutePath ();
+		if (!Roots_.removeAll (path))
+			return;
+
+		RemoveWatches (path);
+	}
+
+	void RecursiveDirWatcherImpl::EnqueueWatch (const QString& path)
+	{
+		WatchQueue_ << path;
+		if (!WatchQueueTimer_->isActive ())
+			WatchQueueTimer_->start (0);
+	}
+
+	void RecursiveDirWatcherImpl::RemoveWatches (const QString& path)
+	{
+		const auto& prefix = path + '/';
+		auto isUnder = [&path, &prefix] (const QString& other)
+		{
+			return other == path || other.startsWith (prefix);
+		};
+
+		for (auto i = Path2Wd_.begin (); i != Path2Wd_.end (); )
+		{
+			if (!isUnder (i.key ()))
+			{
+				++i;
+				continue;
+			}
+
+			inotify_rm_watch (Fd_, *i);
+			Wd2Path_.remove (*i);
+			i = Path2Wd_.erase (i);
+		}
+
+		for (auto i = WatchQueue_.begin (); i != WatchQueue_.end (); )
+		{
+			if (isUnder (*i))
+				i = WatchQueue_.erase (i);
+			else
+				++i;
+		}
+	}
+
+	void RecursiveDirWatcherImpl::HandleEvent (const inotify_event *event)
+	{
+		if (event->mask & IN_Q_OVERFLOW)
+		{
+			HandleOverflow ();
+			return;
+		}
+
+		const auto wdPos = Wd2Path_.constFind (event->wd);
+		if (wdPos == Wd2Path_.constEnd ())
+			return;
+
+		const auto dir = *wdPos;
+
+		if (event->mask & IN_IGNORED)
+		{
+			Path2Wd_.remove (dir);
+			Wd2Path_.remove (event->wd);
+			return;
+		}
+
+		if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF))
+		{
+			if (Roots_.contains (dir))
+				MarkDirChanged (dir);
+			return;
+		}
+
+		if (!event->len)
+			return;
+
+		const auto& path = dir + '/' + QFile::decodeName (event->name);
+
+		if (event->mask & IN_ISDIR)
+		{
+			if (event->mask & (IN_CREATE | IN_MOVED_TO))
+			{
+				EnqueueWatch (path);
+				MarkDirChanged (path);
+			}
+			else if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+			{
+				RemoveWatches (path);
+				MarkDirChanged (dir);
+			}
+			return;
+		}
+
+		// A freshly created file is reported once it's closed after writing,
+		// so IN_CREATE is only interesting for directories.
+		if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+			MarkFileChanged (path);
+		else if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+			MarkFileRemoved (path);
+	}
+
+	void RecursiveDirWatcherImpl::HandleOverflow ()
+	{
+		qWarning () << Q_FUNC_INFO
+				<< "inotify queue overflow, rescanning the roots";
+
+		// Any event could have been lost, including the creation of
+		// directories that are thus not watched yet, so walk the trees
+		// again as well.
+		for (const auto& root : Roots_)
+		{
+			EnqueueWatch (root);
+			emit rootRescanRequired (root);
+		}
+	}
+
+	void RecursiveDirWatcherImpl::MarkFileChanged (const QString& path)
+	{
+		RemovedFiles_.remove (path);
+		ChangedFiles_ << path;
+
+		if (!FlushTimer_->isActive ())
+			FlushTimer_->start (FlushDelay);
+	}
+
+	void RecursiveDirWatcherImpl::MarkFileRemoved (const QString& path)
+	{
+		ChangedFiles_.remove (path);
+		RemovedFiles_ << path;
+
+		if (!FlushTimer_->isActive ())
+			FlushTimer_->start (FlushDelay);
+	}
+
+	void RecursiveDirWatcherImpl::MarkDirChanged (const QString& path)
+	{
+		ChangedDirs_ << path;
+
+		if (!FlushTimer_->isActive ())
+			FlushTimer_->start (FlushDelay);
+	}
+
+	void RecursiveDirWatcherImpl::processWatchQueue ()
+	{
+		auto filters = QDir::Dirs | QDir::NoDotAndDotDot;
+		if (!XmlSettingsManager::Instance ().property ("FollowSymLinks").toBool ())
+			filters |= QDir::NoSymLinks;
+
+		for (int i = 0; i < WatchBatchSize && !WatchQueue_.isEmpty (); ++i)
+		{
+			const auto path = WatchQueue_.takeFirst ();
+
+			// Adding a watch for an already watched directory just returns
+			// its descriptor, so the directories are rewalked cheaply after
+			// an overflow, and stale descriptors of recreated directories
+			// are replaced.
+			const auto wd = inotify_add_watch (Fd_, QFile::encodeName (path).constData (), WatchMask);
+			if (wd < 0)
+			{
+				if (errno == ENOSPC && !WatchLimitReported_)
+				{
+					qWarning () << Q_FUNC_INFO
+							<< "inotify watches limit reached, consider raising fs.inotify.max_user_watches";
+					WatchLimitReported_ = true;
+				}
+				continue;
+			}
+
+			// Different paths to the same directory (via symlinks) share the
+			// descriptor. The first path is kept, and the directory isn't
+			// walked again, which also stops on symlink loops.
+			const auto wdPos = Wd2Path_.constFind (wd);
+			if (wdPos != Wd2Path_.constEnd () && *wdPos != path)
+				continue;
+
+			const auto oldWd = Path2Wd_.value (path, -1);
+			if (oldWd >= 0 && oldWd != wd)
+				Wd2Path_.remove (oldWd);
+
+			Wd2Path_ [wd] = path;
+			Path2Wd_ [path] = wd;
+
+			const QDir dir { path };
+			for (const auto& subdir : dir.entryList (filters))
+				WatchQueue_ << dir.filePath (subdir);
+		}
+
+		if (WatchQueue_.isEmpty ())
+			WatchQueueTimer_->stop ();
+	}
+
+	void RecursiveDirWatcherImpl::readEvents ()
+	{
+		alignas (inotify_event) char buffer [64 * 1024];
+
+		while (true)
+		{
+			const auto length = read (Fd_, buffer, sizeof (buffer));
+			if (length <= 0)
+				break;
+
+			for (auto ptr = buffer; ptr < buffer + length; )
+			{
+				const auto event = reinterpret_cast<const inotify_event*> (ptr);
+				HandleEvent (event);
+				ptr += sizeof (inotify_event) + event->len;
+			}
+		}
+	}
+
+	void RecursiveDirWatcherImpl::flush ()
+	{
+		const auto removed = RemovedFiles_.toList ();
+		const auto changed = ChangedFiles_.toList ();
+		const auto dirs = ChangedDirs_;
+
+		RemovedFiles_.clear ();
+		ChangedFiles_.clear ();
+		ChangedDirs_.clear ();
+
+		if (!removed.isEmpty ())
+			emit filesRemoved (removed);
+		if (!changed.isEmpty ())
+			emit filesChanged (changed);
+		for (const auto& dir : dirs)
+			emit directoryChanged (dir);
+	}
+}
+}
@@ -0,0 +1,92 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+
+class QSocketNotifier;
+class QTimer;
+
+struct inotify_event;
+
+namespace LeechCraft
+{
+namespace LMP
+{
+	class RecursiveDirWatcherImpl : public QObject
+	{
+		Q_OBJECT
+
+		const int Fd_;
+		QSocketNotifier *Notifier_ = nullptr;
+
+		QStringList Roots_;
+		QHash<int, QString> Wd2Path_;
+		QHash<QString, int> Path2Wd_;
+
+		QStringList WatchQueue_;
+		QTimer * const WatchQueueTimer_;
+		bool WatchLimitReported_ = false;
+
+		QSet<QString> ChangedFiles_;
+		QSet<QString> RemovedFiles_;
+		QSet<QString> ChangedDirs_;
+		QTimer * const FlushTimer_;
+	public:
+		RecursiveDirWatcherImpl (QObject*);
+		~RecursiveDirWatcherImpl ();
+
+		void AddRoot (const QString&);
+		void RemoveRoot (const QString&);
+	private:
+		void EnqueueWatch (const QString&);
+		void RemoveWatches (const QString&);
+
+		void HandleEvent (const inotify_event*);
+		void HandleOverflow ();
+
+		void MarkFileChanged (const QString&);
+		void MarkFileRemoved (const QString&);
+		void MarkDirChanged (const QString&);
+	private slots:
+		void processWatchQueue ();
+		void readEvents ();
+		void flush ();
+	signals:
+		void directoryChanged (const QString&);
+		void filesChanged (const QStringList&);
+		void filesRemoved (const QStringList&);
+		void rootRescanRequired (const QString&);
+	};
+}
+}
@@ -28,10 +28,11 @@
  **********************************************************************/
 
 #include "rganalysismanager.h"
+#include <algorithm>
+#include <QThread>
 #include "localcollection.h"
 #include "localcollectionstorage.h"
 #include "engine/rganalyser.h"
-#include "engine/rgfilter.h"
 #include "xmlsettingsmanager.h"
 
 namespace LeechCraft
@@ -49,6 +50,8 @@ namespace LMP
 
 		XmlSettingsManager::Instance ().RegisterObject ("AutobuildRG",
 				this, "handleScanFinished");
+		XmlSettingsManager::Instance ().RegisterObject ("RgAnalysisThreads",
+				this, "rotateQueue");
 	}
 
 	namespace
@@ -57,11 +60,60 @@ namespace LMP
 		{
 			return XmlSettingsManager::Instance ().property ("AutobuildRG").toBool ();
 		}
+
+		int GetMaxAnalysers ()
+		{
+			const auto threads = XmlSettingsManager::Instance ()
+					.property ("RgAnalysisThreads").toInt ();
+			return threads > 0 ?
+					threads :
+					std::max (QThread::idealThreadCount (), 1);
+		}
+
+		/** The results are written to the storage in batches of at
+		 * least this many tracks.
+		 */
+		const int FlushThreshold = 64;
+	}
+
+	void RgAnalysisManager::FlushData ()
+	{
+		if (PendingData_.isEmpty ())
+			return;
+
+		try
+		{
+			Coll_->GetStorage ()->SetRgTrackInfos (PendingData_);
+		}
+		catch (const std::exception& e)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "error saving RG data for"
+					<< PendingData_.size ()
+					<< "tracks:"
+					<< e.what ();
+		}
+
+		PendingData_.clear ();
 	}
 
 	void RgAnalysisManager::handleAnalysed ()
 	{
-		const auto& result = CurrentAnalyser_->GetResult ();
+		const auto pos = std::find_if (Analysers_.begin (), Analysers_.end (),
+				[this] (const std::shared_ptr<RgAnalyser>& analyser)
+					{ return analyser.get () == sender (); });
+		if (pos == Analysers_.end ())
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unknown analyser"
+					<< sender ();
+			return;
+		}
+
+		const auto analyser = *pos;
+		Analysers_.erase (pos);
+
+		const auto& result = analyser->GetResult ();
 
 		for (const auto& track : result.Tracks_)
 		{
@@ -74,39 +126,64 @@ namespace LMP
 				continue;
 			}
 
-			Coll_->GetStorage ()->SetRgTrackInfo (id,
-					{
-						track.TrackGain_,
-						track.TrackPeak_,
-						result.AlbumGain_,
-						result.AlbumPeak_
-					});
+			const RGData data
+			{
+				track.TrackGain_,
+				track.TrackPeak_,
+				result.AlbumGain_,
+				result.AlbumPeak_
+			};
+			PendingData_.append (qMakePair (id, data));
 		}
 
-		CurrentAnalyser_.reset ();
+		AnalysedTracks_ += result.Tracks_.size ();
+
+		if (PendingData_.size () >= FlushThreshold)
+			FlushData ();
+
 		rotateQueue ();
 	}
 
 	void RgAnalysisManager::rotateQueue ()
 	{
-		if (AlbumsQueue_.isEmpty ())
-			return;
-
 		if (!IsScanAllowed ())
+			AlbumsQueue_.Clear ();
+
+		const auto maxAnalysers = GetMaxAnalysers ();
+		while (Analysers_.size () < maxAnalysers && !AlbumsQueue_.IsEmpty ())
 		{
-			AlbumsQueue_.clear ();
-			return;
+			QStringList paths;
+			for (const auto& track : AlbumsQueue_.TakeNext ()->Tracks_)
+				paths << track.FilePath_;
+			if (paths.isEmpty ())
+				continue;
+
+			std::shared_ptr<RgAnalyser> analyser { new RgAnalyser { paths, this } };
+			Analysers_ << analyser;
+			connect (analyser.get (),
+					SIGNAL (finished ()),
+					this,
+					SLOT (handleAnalysed ()));
 		}
 
-		QStringList paths;
-		for (const auto& track : AlbumsQueue_.takeFirst ()->Tracks_)
-			paths << track.FilePath_;
+		if (!Analysers_.isEmpty ())
+			return;
 
-		CurrentAnalyser_.reset (new RgAnalyser { paths, this });
-		connect (CurrentAnalyser_.get (),
-				SIGNAL (finished ()),
-				this,
-				SLOT (handleAnalysed ()));
+		FlushData ();
+
+		if (AnalysedTracks_)
+		{
+			const auto secs = std::max (RunTimer_.elapsed (), qint64 { 1 }) / 1000.;
+			qDebug () << Q_FUNC_INFO
+					<< "analysed"
+					<< AnalysedTracks_
+					<< "tracks in"
+					<< secs
+					<< "s,"
+					<< AnalysedTracks_ / secs
+					<< "tracks/s";
+			AnalysedTracks_ = 0;
+		}
 	}
 
 	void RgAnalysisManager::handleScanFinished ()
@@ -115,20 +192,28 @@ namespace LMP
 		if (!IsScanAllowed ())
 			return;
 
-		QSet<int> albums;
+		QSet<int> albumIds;
 		for (const auto track : Coll_->GetStorage ()->GetOutdatedRgTracks ())
-			albums << Coll_->GetTrackAlbumId (track);
+			albumIds << Coll_->GetTrackAlbumId (track);
 
-		const bool wasEmpty = AlbumsQueue_.isEmpty ();
-
-		for (auto albumId : albums)
+		QList<Collection::Album_ptr> albums;
+		for (auto albumId : albumIds)
 			if (const auto& album = Coll_->GetAlbum (albumId))
-				AlbumsQueue_ << album;
+				albums << album;
+
+		const bool wasIdle = AlbumsQueue_.IsEmpty () && Analysers_.isEmpty ();
+		if (!AlbumsQueue_.Enqueue (albums))
+			return;
 
-		qDebug () << AlbumsQueue_.size ()
+		if (wasIdle)
+		{
+			RunTimer_.start ();
+			AnalysedTracks_ = 0;
+		}
+
+		qDebug () << AlbumsQueue_.GetSize ()
 				<< "albums to rescan";
-		if (wasEmpty)
-			rotateQueue ();
+		rotateQueue ();
 	}
 }
 }
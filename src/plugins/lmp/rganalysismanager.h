@@ -31,7 +31,10 @@
 
 #include <QObject>
 #include <QSet>
+#include <QElapsedTimer>
 #include "interfaces/lmp/collectiontypes.h"
+#include "engine/rgfilter.h"
+#include "rganalysisqueue.h"
 
 namespace LeechCraft
 {
@@ -46,11 +49,18 @@ namespace LMP
 
 		LocalCollection * const Coll_;
 
-		std::shared_ptr<RgAnalyser> CurrentAnalyser_;
+		QList<std::shared_ptr<RgAnalyser>> Analysers_;
 
-		QList<Collection::Album_ptr> AlbumsQueue_;
+		RgAnalysisQueue AlbumsQueue_;
+
+		QList<QPair<int, RGData>> PendingData_;
+
+		QElapsedTimer RunTimer_;
+		int AnalysedTracks_ = 0;
 	public:
 		RgAnalysisManager (LocalCollection*, QObject* = nullptr);
+	private:
+		void FlushData ();
 	private slots:
 		void handleAnalysed ();
 		void rotateQueue ();
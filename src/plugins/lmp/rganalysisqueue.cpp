@@ -0,0 +1,92 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "rganalysisqueue.h"
+#include <algorithm>
+
+namespace LeechCraft
+{
+namespace LMP
+{
+	namespace
+	{
+		int GetAlbumLength (const Collection::Album_ptr& album)
+		{
+			int length = 0;
+			for (const auto& track : album->Tracks_)
+				length += track.Length_;
+			return length;
+		}
+	}
+
+	int RgAnalysisQueue::Enqueue (const QList<Collection::Album_ptr>& albums)
+	{
+		int added = 0;
+		for (const auto& album : albums)
+		{
+			if (!album)
+				continue;
+
+			const auto id = album->ID_;
+			if (std::any_of (Albums_.begin (), Albums_.end (),
+					[id] (const QueuedAlbum& queued) { return queued.Album_->ID_ == id; }))
+				continue;
+
+			Albums_.append ({ album, GetAlbumLength (album) });
+			++added;
+		}
+
+		std::stable_sort (Albums_.begin (), Albums_.end (),
+				[] (const QueuedAlbum& left, const QueuedAlbum& right)
+					{ return left.Length_ > right.Length_; });
+
+		return added;
+	}
+
+	Collection::Album_ptr RgAnalysisQueue::TakeNext ()
+	{
+		return Albums_.takeFirst ().Album_;
+	}
+
+	bool RgAnalysisQueue::IsEmpty () const
+	{
+		return Albums_.isEmpty ();
+	}
+
+	int RgAnalysisQueue::GetSize () const
+	{
+		return Albums_.size ();
+	}
+
+	void RgAnalysisQueue::Clear ()
+	{
+		Albums_.clear ();
+	}
+}
+}
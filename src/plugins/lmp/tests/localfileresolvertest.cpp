@@ -0,0 +1,224 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "localfileresolvertest.h"
+#include <QtTest>
+#include <QDir>
+#include <QFile>
+#include <QtConcurrentMap>
+#include <taglib/fileref.h>
+#include <taglib/tag.h>
+#include "../localfileresolver.h"
+
+QTEST_MAIN (LeechCraft::LMP::LocalFileResolverTest)
+
+namespace LeechCraft
+{
+namespace LMP
+{
+	namespace
+	{
+		const int FilesCount = 200;
+		const int FramesCount = 300;
+
+		// MPEG-1 Layer III, 128 kbps, 44.1 kHz, no padding.
+		const int FrameSize = 417;
+		const int SamplesPerFrame = 1152;
+		const int SampleRate = 44100;
+
+		QByteArray GenerateStream ()
+		{
+			QByteArray frame (FrameSize, 0);
+			frame [0] = static_cast<char> (0xff);
+			frame [1] = static_cast<char> (0xfb);
+			frame [2] = static_cast<char> (0x90);
+			frame [3] = static_cast<char> (0x00);
+
+			QByteArray result;
+			result.reserve (FrameSize * FramesCount);
+			for (int i = 0; i < FramesCount; ++i)
+				result += frame;
+			return result;
+		}
+
+		QString GetArtist (int i)
+		{
+			return QString ("Artist %1").arg (i % 10);
+		}
+
+		QString GetAlbum (int i)
+		{
+			return QString ("Album %1").arg (i % 20);
+		}
+
+		QString GetTitle (int i)
+		{
+			return QString ("Title %1").arg (i);
+		}
+
+		TagLib::String ToTagLib (const QString& str)
+		{
+			return TagLib::String (str.toUtf8 ().constData (), TagLib::String::UTF8);
+		}
+
+		MediaInfo ResolveFast (LocalFileResolver *resolver, const QString& path)
+		{
+			return resolver->ResolveInfo (path, TagLib::AudioProperties::Fast);
+		}
+	}
+
+	void LocalFileResolverTest::initTestCase ()
+	{
+		CorpusDir_ = QDir::temp ().filePath ("lc_lmp_localfileresolvertest");
+		QVERIFY (QDir::temp ().mkpath (CorpusDir_));
+
+		const auto& stream = GenerateStream ();
+
+		LocalFileResolver resolver;
+		for (int i = 0; i < FilesCount; ++i)
+		{
+			const auto& path = QDir (CorpusDir_).filePath (QString ("track%1.mp3").arg (i));
+
+			QFile file (path);
+			QVERIFY (file.open (QIODevice::WriteOnly));
+			file.write (stream);
+			file.close ();
+
+			auto ref = resolver.GetFileRef (path);
+			QVERIFY (!ref.isNull () && ref.tag ());
+
+			const auto tag = ref.tag ();
+			tag->setArtist (ToTagLib (GetArtist (i)));
+			tag->setAlbum (ToTagLib (GetAlbum (i)));
+			tag->setTitle (ToTagLib (GetTitle (i)));
+			tag->setYear (2000 + i % 10);
+			tag->setTrack (i % 20 + 1);
+			QVERIFY (ref.save ());
+
+			Files_ << path;
+		}
+	}
+
+	void LocalFileResolverTest::cleanupTestCase ()
+	{
+		for (const auto& file : Files_)
+			QFile::remove (file);
+		QDir::temp ().rmdir (CorpusDir_);
+	}
+
+	void LocalFileResolverTest::testResolveTags ()
+	{
+		LocalFileResolver resolver;
+
+		for (int i = 0; i < FilesCount; i += 37)
+		{
+			const auto& info = resolver.ResolveInfo (Files_.at (i));
+			QCOMPARE (info.LocalPath_, Files_.at (i));
+			QCOMPARE (info.Artist_, GetArtist (i));
+			QCOMPARE (info.Album_, GetAlbum (i));
+			QCOMPARE (info.Title_, GetTitle (i));
+			QCOMPARE (info.Year_, 2000 + i % 10);
+			QCOMPARE (info.TrackNumber_, i % 20 + 1);
+
+			// TagLib may either truncate or round the length in seconds.
+			const auto expectedLength = FramesCount * SamplesPerFrame / SampleRate;
+			QVERIFY (qAbs (info.Length_ - expectedLength) <= 1);
+		}
+	}
+
+	void LocalFileResolverTest::testFastMatchesAccurate ()
+	{
+		LocalFileResolver fastResolver;
+		LocalFileResolver accurateResolver;
+
+		for (const auto& file : Files_)
+		{
+			const auto& fast = ResolveFast (&fastResolver, file);
+			const auto& accurate = accurateResolver.ResolveInfo (file);
+			QCOMPARE (fast.Title_, accurate.Title_);
+			QCOMPARE (fast.Length_, accurate.Length_);
+		}
+	}
+
+	void LocalFileResolverTest::testParallelMatchesSequential ()
+	{
+		LocalFileResolver sequentialResolver;
+		LocalFileResolver parallelResolver;
+
+		const auto& parallel = QtConcurrent::blockingMapped<QList<MediaInfo>> (Files_,
+				std::function<MediaInfo (const QString&)> ([&parallelResolver] (const QString& path)
+					{ return ResolveFast (&parallelResolver, path); }));
+
+		QCOMPARE (parallel.size (), Files_.size ());
+		for (int i = 0; i < Files_.size (); ++i)
+		{
+			const auto& info = ResolveFast (&sequentialResolver, Files_.at (i));
+			QCOMPARE (parallel.at (i).LocalPath_, info.LocalPath_);
+			QCOMPARE (parallel.at (i).Artist_, info.Artist_);
+			QCOMPARE (parallel.at (i).Title_, info.Title_);
+			QCOMPARE (parallel.at (i).Length_, info.Length_);
+		}
+	}
+
+	/* Each benchmark iteration uses a new resolver so that the results
+	 * are never taken from the cache.
+	 */
+
+	void LocalFileResolverTest::benchSequentialAccurate ()
+	{
+		QBENCHMARK
+		{
+			LocalFileResolver resolver;
+			for (const auto& file : Files_)
+				resolver.ResolveInfo (file);
+		}
+	}
+
+	void LocalFileResolverTest::benchSequentialFast ()
+	{
+		QBENCHMARK
+		{
+			LocalFileResolver resolver;
+			for (const auto& file : Files_)
+				ResolveFast (&resolver, file);
+		}
+	}
+
+	void LocalFileResolverTest::benchParallelFast ()
+	{
+		QBENCHMARK
+		{
+			LocalFileResolver resolver;
+			QtConcurrent::blockingMapped<QList<MediaInfo>> (Files_,
+					std::function<MediaInfo (const QString&)> ([&resolver] (const QString& path)
+						{ return ResolveFast (&resolver, path); }));
+		}
+	}
+}
+}
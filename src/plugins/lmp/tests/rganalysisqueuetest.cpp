@@ -0,0 +1,130 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "rganalysisqueuetest.h"
+#include <QtTest>
+#include "../rganalysisqueue.h"
+
+QTEST_MAIN (LeechCraft::LMP::RgAnalysisQueueTest)
+
+namespace LeechCraft
+{
+namespace LMP
+{
+	namespace
+	{
+		Collection::Album_ptr MakeAlbum (int id, const QList<int>& lengths)
+		{
+			const auto album = std::make_shared<Collection::Album> ();
+			album->ID_ = id;
+			album->Year_ = 0;
+
+			int trackId = id * 100;
+			for (const auto length : lengths)
+				album->Tracks_.append ({ trackId++, 0, {}, length, {}, {} });
+			return album;
+		}
+
+		QList<int> TakeAll (RgAnalysisQueue& queue)
+		{
+			QList<int> result;
+			while (!queue.IsEmpty ())
+				result << queue.TakeNext ()->ID_;
+			return result;
+		}
+	}
+
+	void RgAnalysisQueueTest::testLongestFirst ()
+	{
+		RgAnalysisQueue queue;
+		const auto added = queue.Enqueue ({
+					MakeAlbum (1, { 100, 100 }),
+					MakeAlbum (2, { 300, 400, 500 }),
+					MakeAlbum (3, { 50 }),
+					MakeAlbum (4, { 1000 })
+				});
+
+		QCOMPARE (added, 4);
+		QCOMPARE (queue.GetSize (), 4);
+		QCOMPARE (TakeAll (queue), (QList<int> { 2, 4, 1, 3 }));
+	}
+
+	void RgAnalysisQueueTest::testEqualLengthsKeepOrder ()
+	{
+		RgAnalysisQueue queue;
+		queue.Enqueue ({
+					MakeAlbum (1, { 200 }),
+					MakeAlbum (2, { 100, 100 }),
+					MakeAlbum (3, { 300 }),
+					MakeAlbum (4, { 50, 150 })
+				});
+
+		QCOMPARE (TakeAll (queue), (QList<int> { 3, 1, 2, 4 }));
+	}
+
+	void RgAnalysisQueueTest::testDuplicatesSkipped ()
+	{
+		RgAnalysisQueue queue;
+		QCOMPARE (queue.Enqueue ({ MakeAlbum (1, { 100 }), MakeAlbum (1, { 100 }) }), 1);
+		QCOMPARE (queue.Enqueue ({ MakeAlbum (1, { 100 }), MakeAlbum (2, { 10 }) }), 1);
+		QCOMPARE (queue.Enqueue ({ MakeAlbum (2, { 10 }) }), 0);
+
+		QCOMPARE (TakeAll (queue), (QList<int> { 1, 2 }));
+	}
+
+	void RgAnalysisQueueTest::testMergeKeepsOrder ()
+	{
+		RgAnalysisQueue queue;
+		queue.Enqueue ({ MakeAlbum (1, { 100 }), MakeAlbum (2, { 300 }) });
+		QCOMPARE (queue.TakeNext ()->ID_, 2);
+
+		queue.Enqueue ({ MakeAlbum (3, { 500 }), MakeAlbum (4, { 50 }), MakeAlbum (5, { 100 }) });
+		QCOMPARE (TakeAll (queue), (QList<int> { 3, 1, 5, 4 }));
+	}
+
+	void RgAnalysisQueueTest::testNullAlbumsSkipped ()
+	{
+		RgAnalysisQueue queue;
+		QCOMPARE (queue.Enqueue ({ {}, MakeAlbum (1, { 100 }) }), 1);
+		QCOMPARE (TakeAll (queue), (QList<int> { 1 }));
+	}
+
+	void RgAnalysisQueueTest::testClear ()
+	{
+		RgAnalysisQueue queue;
+		queue.Enqueue ({ MakeAlbum (1, { 100 }), MakeAlbum (2, { 300 }) });
+		queue.Clear ();
+		QVERIFY (queue.IsEmpty ());
+		QCOMPARE (queue.GetSize (), 0);
+
+		QCOMPARE (queue.Enqueue ({ MakeAlbum (1, { 100 }) }), 1);
+		QCOMPARE (TakeAll (queue), (QList<int> { 1 }));
+	}
+}
+}
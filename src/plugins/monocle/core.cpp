@@ -34,6 +34,7 @@
 #include <interfaces/iplugin2.h>
 #include "interfaces/monocle/iredirectproxy.h"
 #include "pixmapcachemanager.h"
+#include "thumbscache.h"
 #include "recentlyopenedmanager.h"
 #include "defaultbackendmanager.h"
 #include "docstatemanager.h"
@@ -46,6 +47,7 @@ namespace Monocle
 {
 	Core::Core ()
 	: CacheManager_ (new PixmapCacheManager (this))
+	, ThumbsCache_ (new ThumbsCache (this))
 	, ROManager_ (new RecentlyOpenedManager (this))
 	, DefaultBackendManager_ (new DefaultBackendManager (this))
 	, DocStateManager_ (new DocStateManager (this))
@@ -169,6 +171,11 @@ namespace Monocle
 		return CacheManager_;
 	}
 
+	ThumbsCache* Core::GetThumbsCache () const
+	{
+		return ThumbsCache_;
+	}
+
 	RecentlyOpenedManager* Core::GetROManager () const
 	{
 		return ROManager_;
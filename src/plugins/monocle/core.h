@@ -44,6 +44,7 @@ namespace Monocle
 {
 	class RecentlyOpenedManager;
 	class PixmapCacheManager;
+	class ThumbsCache;
 	class DefaultBackendManager;
 	class DocStateManager;
 	class BookmarksManager;
@@ -57,6 +58,7 @@ namespace Monocle
 		QList<QObject*> Backends_;
 
 		PixmapCacheManager *CacheManager_;
+		ThumbsCache *ThumbsCache_;
 		RecentlyOpenedManager *ROManager_;
 		DefaultBackendManager *DefaultBackendManager_;
 		DocStateManager *DocStateManager_;
@@ -78,6 +80,7 @@ namespace Monocle
 		CoreLoadProxy* LoadDocument (const QString&);
 
 		PixmapCacheManager* GetPixmapCacheManager () const;
+		ThumbsCache* GetThumbsCache () const;
 		RecentlyOpenedManager* GetROManager () const;
 		DefaultBackendManager* GetDefaultBackendManager () const;
 		DocStateManager* GetDocStateManager () const;
@@ -28,7 +28,10 @@
  **********************************************************************/
 
 #include "docinfodialog.h"
+#include <util/util.h>
 #include "interfaces/monocle/idocument.h"
+#include "core.h"
+#include "pixmapcachemanager.h"
 
 namespace LeechCraft
 {
@@ -46,6 +49,14 @@ namespace Monocle
 		Ui_.Genres_->setText (info.Genres_.join ("; "));
 		Ui_.Keywords_->setText (info.Keywords_.join ("; "));
 		Ui_.Date_->setText (info.Date_.toString ());
+
+		const auto& stats = Core::Instance ().GetPixmapCacheManager ()->GetStats ();
+		const auto total = stats.Hits_ + stats.Misses_;
+		const auto hitRate = total ? 100. * stats.Hits_ / total : 0;
+		Ui_.CacheStats_->setText (tr ("%1 of %2 in %n page(s), %3% hit rate", 0, stats.PixmapsCount_)
+				.arg (Util::MakePrettySize (stats.CurrentSize_))
+				.arg (Util::MakePrettySize (stats.MaxSize_))
+				.arg (hitRate, 0, 'f', 1));
 	}
 }
 }
@@ -33,6 +33,9 @@
 #include <boost/property_tree/json_parser.hpp>
 #include <util/util.h>
 #include <util/sys/paths.h>
+#include <QFile>
+#include <QDataStream>
+#include <QtDebug>
 #include "common.h"
 
 #if BOOST_VERSION >= 105000
@@ -53,6 +56,11 @@ namespace Monocle
 		{
 			return id.at (0) + '/' + id + ".json";
 		}
+
+		QString GetTextIndexFileName (const QString& id)
+		{
+			return id.at (0) + '/' + id + ".textindex";
+		}
 	}
 
 	DocStateManager::DocStateManager (QObject *parent)
@@ -134,5 +142,55 @@ namespace Monocle
 #endif
 		return result;
 	}
+
+	void DocStateManager::SetTextIndex (const QString& id, const TextIndex& index)
+	{
+		if (!DocDir_.exists (id.at (0)))
+			DocDir_.mkdir (id.at (0));
+
+		QFile file (DocDir_.absoluteFilePath (GetTextIndexFileName (id)));
+		if (!file.open (QIODevice::WriteOnly))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< file.fileName ()
+					<< file.errorString ();
+			return;
+		}
+
+		QByteArray data;
+		{
+			QDataStream ostr (&data, QIODevice::WriteOnly);
+			ostr << static_cast<quint8> (1)
+					<< index.DocModified_
+					<< index.Pages_;
+		}
+		file.write (qCompress (data, 1));
+	}
+
+	auto DocStateManager::GetTextIndex (const QString& id) const -> TextIndex
+	{
+		QFile file (DocDir_.absoluteFilePath (GetTextIndexFileName (id)));
+		if (!file.exists () || !file.open (QIODevice::ReadOnly))
+			return {};
+
+		QDataStream istr (qUncompress (file.readAll ()));
+		quint8 version = 0;
+		istr >> version;
+		if (version != 1)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unknown version"
+					<< version
+					<< "for"
+					<< file.fileName ();
+			return {};
+		}
+
+		TextIndex result;
+		istr >> result.DocModified_
+				>> result.Pages_;
+		return result;
+	}
 }
 }
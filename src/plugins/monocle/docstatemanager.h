@@ -31,6 +31,8 @@
 
 #include <QObject>
 #include <QDir>
+#include <QDateTime>
+#include <QStringList>
 
 namespace LeechCraft
 {
@@ -51,10 +53,19 @@ namespace Monocle
 			ScaleMode ScaleMode_;
 		};
 
+		struct TextIndex
+		{
+			QDateTime DocModified_;
+			QStringList Pages_;
+		};
+
 		DocStateManager (QObject* = 0);
 
 		void SetState (const QString&, const State&);
 		State GetState (const QString&) const;
+
+		void SetTextIndex (const QString&, const TextIndex&);
+		TextIndex GetTextIndex (const QString&) const;
 	};
 }
 }
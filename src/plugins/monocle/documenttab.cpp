@@ -139,6 +139,10 @@ namespace Monocle
 				SIGNAL (navigateRequested (QString, int, double, double)),
 				this,
 				SLOT (handleNavigateRequested (QString, int, double, double)));
+		connect (SearchHandler_,
+				SIGNAL (searchFinished (bool)),
+				this,
+				SLOT (handleSearchFinished (bool)));
 
 		FormManager_ = new FormManager (Ui_.PagesView_, this);
 		AnnManager_ = new AnnManager (Ui_.PagesView_, this);
@@ -956,6 +960,11 @@ namespace Monocle
 		handlePrint ();
 	}
 
+	void DocumentTab::handleSearchFinished (bool found)
+	{
+		FindDialog_->SetSuccessful (found);
+	}
+
 	void DocumentTab::handleThumbnailClicked (int num)
 	{
 		SetCurrentPage (num);
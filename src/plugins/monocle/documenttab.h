@@ -165,6 +165,7 @@ namespace Monocle
 
 		void handleNavigateRequested (QString, int, double, double);
 		void handlePrintRequested ();
+		void handleSearchFinished (bool);
 
 		void handleThumbnailClicked (int);
 
@@ -70,6 +70,58 @@ namespace Monocle
 		 * containing \em text for those indexes.
 		 */
 		virtual QMap<int, QList<QRectF>> GetTextPositions (const QString& text, Qt::CaseSensitivity cs) = 0;
+
+		/** @brief Returns the search results for the \em text in the
+		 * given range of pages.
+		 *
+		 * This function is similar to GetTextPositions(), but only the
+		 * \em count pages starting with \em start should be searched.
+		 * Monocle uses this function to search the document in chunks
+		 * and show the results as soon as they are found.
+		 *
+		 * The default implementation calls GetTextPositions() and drops
+		 * the pages outside of the requested range, so reimplementing
+		 * this function is highly recommended.
+		 *
+		 * @param[in] text The text to search for.
+		 * @param[in] cs The case sensitivity of the search.
+		 * @param[in] start The index of the first page to search.
+		 * @param[in] count The number of pages to search.
+		 * @return The map from page indexes to list of rectangles
+		 * containing \em text for those indexes.
+		 *
+		 * @sa GetTextPositions(), IsSearchThreadSafe()
+		 */
+		virtual QMap<int, QList<QRectF>> GetPageRangeTextPositions (const QString& text,
+				Qt::CaseSensitivity cs, int start, int count)
+		{
+			auto result = GetTextPositions (text, cs);
+			for (auto i = result.begin (); i != result.end (); )
+				if (i.key () < start || i.key () >= start + count)
+					i = result.erase (i);
+				else
+					++i;
+			return result;
+		}
+
+		/** @brief Returns whether searching may be done in a separate
+		 * thread.
+		 *
+		 * If this function returns true, GetPageRangeTextPositions()
+		 * will be called from a thread other than the GUI one, possibly
+		 * concurrently with page rendering. Otherwise the search is
+		 * done on the GUI thread in small chunks of pages.
+		 *
+		 * The default implementation returns false.
+		 *
+		 * @return Whether searching is thread-safe.
+		 *
+		 * @sa GetPageRangeTextPositions()
+		 */
+		virtual bool IsSearchThreadSafe () const
+		{
+			return false;
+		}
 	};
 }
 }
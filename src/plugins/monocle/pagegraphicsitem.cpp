@@ -39,11 +39,13 @@
 #include <QGraphicsScene>
 #include <QGraphicsView>
 #include <QMenu>
+#include <QPainter>
 #include <QWidgetAction>
 #include "core.h"
 #include "pixmapcachemanager.h"
 #include "arbitraryrotationwidget.h"
 #include "pageslayoutmanager.h"
+#include "thumbscache.h"
 
 namespace LeechCraft
 {
@@ -57,9 +59,9 @@ namespace Monocle
 	, YScale_ (1)
 	, Invalid_ (true)
 	, LayoutManager_ (0)
+	, ThumbsCache_ (0)
 	{
 		setTransformationMode (Qt::SmoothTransformation);
-		setPixmap (QPixmap (Doc_->GetPageSize (page)));
 		setAcceptHoverEvents (true);
 	}
 
@@ -73,6 +75,12 @@ namespace Monocle
 		LayoutManager_ = manager;
 	}
 
+	void PageGraphicsItem::SetThumbsCache (ThumbsCache *cache, const QByteArray& docKey)
+	{
+		ThumbsCache_ = cache;
+		ThumbsDocKey_ = docKey;
+	}
+
 	void PageGraphicsItem::SetReleaseHandler (std::function<void (int, QPointF)> handler)
 	{
 		ReleaseHandler_ = handler;
@@ -84,15 +92,13 @@ namespace Monocle
 			std::abs (ys - YScale_) < std::numeric_limits<double>::epsilon ())
 			return;
 
+		prepareGeometryChange ();
+
 		XScale_ = xs;
 		YScale_ = ys;
 
-		auto size = Doc_->GetPageSize (PageNum_);
-		size.rwidth () *= xs;
-		size.rheight () *= ys;
-		setPixmap (QPixmap (size));
-
-		Invalid_ = true;
+		Core::Instance ().GetPixmapCacheManager ()->PixmapDeleted (this);
+		ClearPixmap ();
 
 		if (IsDisplayed ())
 			update ();
@@ -145,10 +151,7 @@ namespace Monocle
 
 	void PageGraphicsItem::ClearPixmap ()
 	{
-		auto size = Doc_->GetPageSize (PageNum_);
-		size.rwidth () *= XScale_;
-		size.rheight () *= YScale_;
-		setPixmap (QPixmap (size));
+		setPixmap (QPixmap ());
 
 		Invalid_ = true;
 	}
@@ -160,11 +163,26 @@ namespace Monocle
 			update ();
 	}
 
+	QRectF PageGraphicsItem::boundingRect () const
+	{
+		return { offset (), GetScaledSize () };
+	}
+
+	QPainterPath PageGraphicsItem::shape () const
+	{
+		QPainterPath path;
+		path.addRect (boundingRect ());
+		return path;
+	}
+
 	void PageGraphicsItem::paint (QPainter *painter,
 			const QStyleOptionGraphicsItem *option, QWidget *w)
 	{
+		bool rendered = false;
 		if (Invalid_ && IsDisplayed ())
 		{
+			rendered = true;
+
 			auto backendObj = Doc_->GetBackendPlugin ();
 			if (qobject_cast<IBackendPlugin*> (backendObj)->IsThreaded ())
 			{
@@ -174,28 +192,29 @@ namespace Monocle
 						this,
 						SLOT (handlePixmapRendered ()));
 
-				watcher->setFuture (QtConcurrent::run ([this]
-						{ return Doc_->RenderPage (PageNum_, XScale_, YScale_); }));
+				watcher->setFuture (QtConcurrent::run ([this] { return RenderImage (); }));
 
-				auto size = Doc_->GetPageSize (PageNum_);
-				size.rwidth () *= XScale_;
-				size.rheight () *= YScale_;
-				QPixmap px (size);
-				px.fill ();
-				setPixmap (px);
+				setPixmap (QPixmap ());
 			}
 			else
 			{
-				const auto& img = Doc_->RenderPage (PageNum_, XScale_, YScale_);
-				setPixmap (QPixmap::fromImage (img));
+				setPixmap (QPixmap::fromImage (RenderImage ()));
 			}
 			Invalid_ = false;
 
 			Core::Instance ().GetPixmapCacheManager ()->PixmapChanged (this);
 		}
 
-		QGraphicsPixmapItem::paint (painter, option, w);
-		Core::Instance ().GetPixmapCacheManager ()->PixmapPainted (this);
+		const bool hasPixmap = !pixmap ().isNull ();
+		if (hasPixmap)
+			QGraphicsPixmapItem::paint (painter, option, w);
+		else
+			painter->fillRect (boundingRect (), Qt::white);
+
+		// Blank placeholders for pages that are invalid or still being
+		// rendered are neither hits nor misses.
+		if (rendered || hasPixmap)
+			Core::Instance ().GetPixmapCacheManager ()->PixmapPainted (this, !rendered);
 	}
 
 	void PageGraphicsItem::mousePressEvent (QGraphicsSceneMouseEvent *event)
@@ -247,6 +266,29 @@ namespace Monocle
 		rotateMenu.exec (event->screenPos ());
 	}
 
+	QSizeF PageGraphicsItem::GetScaledSize () const
+	{
+		auto size = Doc_->GetPageSize (PageNum_);
+		size.rwidth () *= XScale_;
+		size.rheight () *= YScale_;
+		return size;
+	}
+
+	QImage PageGraphicsItem::RenderImage ()
+	{
+		if (!ThumbsCache_)
+			return Doc_->RenderPage (PageNum_, XScale_, YScale_);
+
+		const auto& size = GetScaledSize ().toSize ();
+		const auto& cached = ThumbsCache_->Get (ThumbsDocKey_, PageNum_, size);
+		if (!cached.isNull ())
+			return cached;
+
+		const auto& image = Doc_->RenderPage (PageNum_, XScale_, YScale_);
+		ThumbsCache_->Put (ThumbsDocKey_, PageNum_, size, image);
+		return image;
+	}
+
 	bool PageGraphicsItem::IsDisplayed () const
 	{
 		const auto& thisMapped = mapToScene (boundingRect ()).boundingRect ();
@@ -40,6 +40,7 @@ namespace Monocle
 {
 	class PagesLayoutManager;
 	class ArbitraryRotationWidget;
+	class ThumbsCache;
 
 	class PageGraphicsItem : public QObject
 						   , public QGraphicsPixmapItem
@@ -58,6 +59,9 @@ namespace Monocle
 
 		PagesLayoutManager *LayoutManager_;
 
+		ThumbsCache *ThumbsCache_;
+		QByteArray ThumbsDocKey_;
+
 		QPointer<ArbitraryRotationWidget> ArbWidget_;
 	public:
 		typedef std::function<void (QRectF)> RectSetter_f;
@@ -73,6 +77,7 @@ namespace Monocle
 		~PageGraphicsItem ();
 
 		void SetLayoutManager (PagesLayoutManager*);
+		void SetThumbsCache (ThumbsCache*, const QByteArray&);
 
 		void SetReleaseHandler (std::function<void (int, QPointF)>);
 
@@ -87,12 +92,17 @@ namespace Monocle
 
 		void ClearPixmap ();
 		void UpdatePixmap ();
+
+		QRectF boundingRect () const;
+		QPainterPath shape () const;
 	protected:
 		void paint (QPainter*, const QStyleOptionGraphicsItem*, QWidget*);
 		void mousePressEvent (QGraphicsSceneMouseEvent*);
 		void mouseReleaseEvent (QGraphicsSceneMouseEvent*);
 		void contextMenuEvent (QGraphicsSceneContextMenuEvent*);
 	private:
+		QSizeF GetScaledSize () const;
+		QImage RenderImage ();
 		bool IsDisplayed () const;
 	private slots:
 		void rotateCCW ();
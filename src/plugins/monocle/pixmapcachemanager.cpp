@@ -28,7 +28,7 @@
  **********************************************************************/
 
 #include "pixmapcachemanager.h"
-#include <numeric>
+#include <iterator>
 #include <QtDebug>
 #include "xmlsettingsmanager.h"
 #include "pagegraphicsitem.h"
@@ -41,6 +41,8 @@ namespace Monocle
 	: QObject (parent)
 	, CurrentSize_ (0)
 	, MaxSize_ (0)
+	, Hits_ (0)
+	, Misses_ (0)
 	{
 		XmlSettingsManager::Instance ().RegisterObject ("PixmapCacheSize",
 				this, "handleCacheSizeChanged");
@@ -49,43 +51,71 @@ namespace Monocle
 
 	namespace
 	{
-		quint64 GetPixmapSize (const QPixmap& px)
+		qint64 GetPixmapSize (const QPixmap& px)
 		{
-			return px.width () * px.height () * px.defaultDepth () / 8 * 1.5;
+			if (px.isNull ())
+				return 0;
+
+			return static_cast<qint64> (px.width ()) * px.height () * px.depth () / 8;
 		}
 	}
 
-	void PixmapCacheManager::PixmapPainted (PageGraphicsItem *item)
+	void PixmapCacheManager::PixmapPainted (PageGraphicsItem *item, bool hit)
 	{
-		RecentlyUsed_.removeAll (item);
-		RecentlyUsed_ << item;
+		if (hit)
+			++Hits_;
+		else
+			++Misses_;
+
+		const auto pos = Entries_.find (item);
+		if (pos == Entries_.end ())
+			return;
+
+		RecentlyUsed_.splice (RecentlyUsed_.end (), RecentlyUsed_, pos->Pos_);
 	}
 
 	void PixmapCacheManager::PixmapChanged (PageGraphicsItem *item)
 	{
-		if (RecentlyUsed_.removeAll (item))
-			CurrentSize_ = std::accumulate (RecentlyUsed_.begin (), RecentlyUsed_.end (), 0,
-					[] (qint64 size, decltype (RecentlyUsed_.front ()) item)
-						{ return size + GetPixmapSize (item->pixmap ()); });
+		Remove (item);
+
+		const auto size = GetPixmapSize (item->pixmap ());
+		if (!size)
+			return;
+
+		RecentlyUsed_.push_back (item);
+		Entries_ [item] = { std::prev (RecentlyUsed_.end ()), size };
+		CurrentSize_ += size;
 
-		RecentlyUsed_ << item;
-		CurrentSize_ += GetPixmapSize (item->pixmap ());
 		CheckCache ();
 	}
 
 	void PixmapCacheManager::PixmapDeleted (PageGraphicsItem *item)
 	{
-		CurrentSize_ -= GetPixmapSize (item->pixmap ());
-		RecentlyUsed_.removeAll (item);
+		Remove (item);
+	}
+
+	PixmapCacheManager::Stats PixmapCacheManager::GetStats () const
+	{
+		return { CurrentSize_, MaxSize_, Entries_.size (), Hits_, Misses_ };
+	}
+
+	void PixmapCacheManager::Remove (PageGraphicsItem *item)
+	{
+		const auto pos = Entries_.find (item);
+		if (pos == Entries_.end ())
+			return;
+
+		CurrentSize_ -= pos->Size_;
+		RecentlyUsed_.erase (pos->Pos_);
+		Entries_.erase (pos);
 	}
 
 	void PixmapCacheManager::CheckCache ()
 	{
 		while (MaxSize_ < CurrentSize_ && RecentlyUsed_.size () > 2)
 		{
-			auto page = RecentlyUsed_.takeFirst ();
-			const quint64 pxSize = GetPixmapSize (page->pixmap ());
-			CurrentSize_ -= pxSize;
+			const auto page = RecentlyUsed_.front ();
+			Remove (page);
 			page->ClearPixmap ();
 		}
 	}
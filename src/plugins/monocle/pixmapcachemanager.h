@@ -29,7 +29,9 @@
 
 #pragma once
 
+#include <list>
 #include <QObject>
+#include <QHash>
 
 namespace LeechCraft
 {
@@ -43,14 +45,38 @@ namespace Monocle
 
 		qint64 CurrentSize_;
 		qint64 MaxSize_;
-		QList<PageGraphicsItem*> RecentlyUsed_;
+
+		quint64 Hits_;
+		quint64 Misses_;
+
+		typedef std::list<PageGraphicsItem*> LRUList_t;
+		LRUList_t RecentlyUsed_;
+
+		struct CacheEntry
+		{
+			LRUList_t::iterator Pos_;
+			qint64 Size_;
+		};
+		QHash<PageGraphicsItem*, CacheEntry> Entries_;
 	public:
+		struct Stats
+		{
+			qint64 CurrentSize_;
+			qint64 MaxSize_;
+			int PixmapsCount_;
+			quint64 Hits_;
+			quint64 Misses_;
+		};
+
 		PixmapCacheManager (QObject* = 0);
 
-		void PixmapPainted (PageGraphicsItem*);
+		void PixmapPainted (PageGraphicsItem*, bool hit);
 		void PixmapChanged (PageGraphicsItem*);
 		void PixmapDeleted (PageGraphicsItem*);
+
+		Stats GetStats () const;
 	private:
+		void Remove (PageGraphicsItem*);
 		void CheckCache ();
 	private slots:
 		void handleCacheSizeChanged ();
@@ -29,7 +29,9 @@
 
 #include "document.h"
 #include <thread>
+#include <algorithm>
 #include <QThread>
+#include <QMutexLocker>
 #include <QtDebug>
 #include <QBuffer>
 #include <QFile>
@@ -195,41 +197,66 @@ namespace PDF
 		typedef QMap<int, QList<QRectF>> Result_t;
 		Result_t result;
 #if POPPLER_VERSION_MAJOR > 0 || POPPLER_VERSION_MINOR >= 22
-		const auto popplerCS = cs == Qt::CaseSensitive ?
-						Poppler::Page::CaseSensitive :
-						Poppler::Page::CaseInsensitive;
-
 		const auto numPages = PDocument_->numPages ();
 
-		QVector<QList<QRectF>> resVec;
-		resVec.resize (numPages);
+		QVector<Result_t> resVec;
+		resVec.resize (QThread::idealThreadCount ());
 
 		std::vector<std::thread> threads;
 
-		auto worker = [&resVec, &popplerCS, &text, this] (int start, int count)
-		{
-			std::unique_ptr<Poppler::Document> doc (Poppler::Document::load (DocURL_.toLocalFile ()));
-			for (auto i = start, end = start + count; i < end; ++i)
-			{
-				std::unique_ptr<Poppler::Page> p (doc->page (i));
-				resVec [i] = p->search (text, popplerCS);
-			}
-		};
-		const auto threadCount = QThread::idealThreadCount ();
+		const auto threadCount = resVec.size ();
 		const auto packSize = numPages / threadCount;
 		for (int i = 0; i < threadCount; ++i)
-			threads.emplace_back (worker, i * packSize, (i == threadCount - 1) ? (numPages % threadCount) : packSize);
+			threads.emplace_back ([&resVec, &text, cs, i, this] (int start, int count)
+					{ resVec [i] = GetPageRangeTextPositions (text, cs, start, count); },
+					i * packSize,
+					(i == threadCount - 1) ? (numPages - i * packSize) : packSize);
 
 		for (auto& thread : threads)
 			thread.join ();
 
-		for (int i = 0; i < numPages; ++i)
-			if (!resVec.at (i).isEmpty ())
-				result [i] = resVec.at (i);
+		for (const auto& partial : resVec)
+			for (auto i = partial.begin (); i != partial.end (); ++i)
+				result [i.key ()] = i.value ();
 #endif
 		return result;
 	}
 
+	QMap<int, QList<QRectF>> Document::GetPageRangeTextPositions (const QString& text,
+			Qt::CaseSensitivity cs, int start, int count)
+	{
+		QMap<int, QList<QRectF>> result;
+#if POPPLER_VERSION_MAJOR > 0 || POPPLER_VERSION_MINOR >= 22
+		const auto popplerCS = cs == Qt::CaseSensitive ?
+						Poppler::Page::CaseSensitive :
+						Poppler::Page::CaseInsensitive;
+
+		const auto& doc = AcquireSearchDoc ();
+		if (!doc)
+			return result;
+
+		const auto end = std::min (start + count, doc->numPages ());
+		for (auto i = start; i < end; ++i)
+		{
+			std::unique_ptr<Poppler::Page> p (doc->page (i));
+			if (!p)
+				continue;
+
+			const auto& rects = p->search (text, popplerCS);
+			if (!rects.isEmpty ())
+				result [i] = rects;
+		}
+
+		ReleaseSearchDoc (doc);
+#endif
+		return result;
+	}
+
+	bool Document::IsSearchThreadSafe () const
+	{
+		return true;
+	}
+
 	auto Document::CanSave () const -> SaveQueryResult
 	{
 		if (PDocument_->isEncrypted ())
@@ -265,6 +292,26 @@ namespace PDF
 		}
 	}
 
+	PDocument_ptr Document::AcquireSearchDoc ()
+	{
+		{
+			QMutexLocker locker (&SearchDocsMutex_);
+			if (!SearchDocs_.isEmpty ())
+				return SearchDocs_.takeLast ();
+		}
+
+		// Poppler documents aren't thread-safe, so each searching thread
+		// gets its own copy. The copies are reused by the subsequent
+		// ranges instead of reloading the file for each of them.
+		return PDocument_ptr (Poppler::Document::load (DocURL_.toLocalFile ()));
+	}
+
+	void Document::ReleaseSearchDoc (const PDocument_ptr& doc)
+	{
+		QMutexLocker locker (&SearchDocsMutex_);
+		SearchDocs_ << doc;
+	}
+
 	void Document::RequestNavigation (const QString& filename,
 			int page, double x, double y)
 	{
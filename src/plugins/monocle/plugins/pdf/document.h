@@ -32,6 +32,7 @@
 #include <memory>
 #include <QObject>
 #include <QUrl>
+#include <QMutex>
 #include <interfaces/monocle/idocument.h>
 #include <interfaces/monocle/ihavetoc.h>
 #include <interfaces/monocle/ihavetextcontent.h>
@@ -76,6 +77,9 @@ namespace PDF
 		QUrl DocURL_;
 
 		QObject *Plugin_;
+
+		QMutex SearchDocsMutex_;
+		QList<PDocument_ptr> SearchDocs_;
 	public:
 		Document (const QString&, QObject*);
 
@@ -98,6 +102,8 @@ namespace PDF
 		IFormFields_t GetFormFields (int);
 
 		QMap<int, QList<QRectF>> GetTextPositions (const QString&, Qt::CaseSensitivity);
+		QMap<int, QList<QRectF>> GetPageRangeTextPositions (const QString&, Qt::CaseSensitivity, int, int);
+		bool IsSearchThreadSafe () const;
 
 		SaveQueryResult CanSave () const;
 		bool Save (const QString& path);
@@ -106,6 +112,9 @@ namespace PDF
 		void RequestPrinting ();
 	private:
 		void BuildTOC ();
+
+		PDocument_ptr AcquireSearchDoc ();
+		void ReleaseSearchDoc (const PDocument_ptr&);
 	signals:
 		void navigateRequested (const QString&, int, double, double);
 		void printRequested (const QList<int>&);
@@ -0,0 +1,279 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "textsearchengine.h"
+#include <algorithm>
+#include <QTimer>
+#include <QFileInfo>
+#include <QtConcurrentRun>
+#include <QtDebug>
+#include "interfaces/monocle/isearchabledocument.h"
+#include "interfaces/monocle/ihavetextcontent.h"
+#include "core.h"
+#include "docstatemanager.h"
+#include "xmlsettingsmanager.h"
+
+namespace LeechCraft
+{
+namespace Monocle
+{
+	namespace
+	{
+		const int ThreadedChunkSize = 16;
+		const int GuiChunkSize = 2;
+
+		QString NormalizeText (const QString& text)
+		{
+			return text.simplified ();
+		}
+	}
+
+	TextSearchEngine::TextSearchEngine (QObject *parent)
+	: QObject (parent)
+	, Searchable_ (nullptr)
+	, IndexTimer_ (new QTimer (this))
+	, Watcher_ (nullptr)
+	, CS_ (Qt::CaseInsensitive)
+	, ChunkTimer_ (new QTimer (this))
+	{
+		IndexTimer_->setInterval (0);
+		connect (IndexTimer_,
+				SIGNAL (timeout ()),
+				this,
+				SLOT (indexNextPage ()));
+
+		ChunkTimer_->setInterval (0);
+		connect (ChunkTimer_,
+				SIGNAL (timeout ()),
+				this,
+				SLOT (processChunk ()));
+	}
+
+	TextSearchEngine::~TextSearchEngine ()
+	{
+		Cancel ();
+	}
+
+	void TextSearchEngine::HandleDoc (IDocument_ptr doc)
+	{
+		Cancel ();
+		IndexTimer_->stop ();
+
+		Doc_ = doc;
+		Searchable_ = doc ? qobject_cast<ISearchableDocument*> (doc->GetQObject ()) : nullptr;
+		Index_.clear ();
+		DocId_.clear ();
+
+		if (!Searchable_)
+			return;
+
+		const QFileInfo fi (doc->GetDocURL ().toLocalFile ());
+		if (!fi.exists ())
+			return;
+
+		DocId_ = fi.fileName ();
+		DocModified_ = fi.lastModified ();
+
+		const auto& index = Core::Instance ().GetDocStateManager ()->GetTextIndex (DocId_);
+		if (index.DocModified_ == DocModified_ &&
+				index.Pages_.size () == doc->GetNumPages ())
+		{
+			Index_ = index.Pages_;
+			return;
+		}
+
+		if (qobject_cast<IHaveTextContent*> (doc->GetQObject ()) &&
+				XmlSettingsManager::Instance ().property ("BuildSearchIndex").toBool ())
+			IndexTimer_->start ();
+	}
+
+	void TextSearchEngine::Search (const QString& text, Qt::CaseSensitivity cs)
+	{
+		Cancel ();
+
+		if (!Searchable_ || text.isEmpty ())
+		{
+			emit searchFinished ();
+			return;
+		}
+
+		Text_ = text;
+		CS_ = cs;
+
+		const auto& ranges = GetSearchRanges (text, cs,
+				Searchable_->IsSearchThreadSafe () ? ThreadedChunkSize : GuiChunkSize);
+		if (ranges.isEmpty ())
+		{
+			emit searchFinished ();
+			return;
+		}
+
+		if (!Searchable_->IsSearchThreadSafe ())
+		{
+			PendingRanges_ = ranges;
+			ChunkTimer_->start ();
+			return;
+		}
+
+		Watcher_ = new QFutureWatcher<PageResult> (this);
+		connect (Watcher_,
+				SIGNAL (resultsReadyAt (int, int)),
+				this,
+				SLOT (handleResultsReady (int, int)));
+		connect (Watcher_,
+				SIGNAL (finished ()),
+				this,
+				SLOT (handleWatcherFinished ()));
+
+		QFutureInterface<PageResult> iface;
+		iface.reportStarted ();
+		Watcher_->setFuture (iface.future ());
+
+		const auto doc = Doc_;
+		const auto searchable = Searchable_;
+		QtConcurrent::run ([iface, doc, searchable, ranges, text, cs] () mutable
+				{
+					for (const auto& range : ranges)
+					{
+						if (iface.isCanceled ())
+							break;
+
+						const auto& map = searchable->GetPageRangeTextPositions (text,
+								cs, range.first, range.second);
+						for (auto i = map.begin (); i != map.end (); ++i)
+						{
+							const PageResult result { i.key (), i.value () };
+							iface.reportResult (result);
+						}
+					}
+
+					iface.reportFinished ();
+				});
+	}
+
+	void TextSearchEngine::Cancel ()
+	{
+		PendingRanges_.clear ();
+		ChunkTimer_->stop ();
+
+		if (!Watcher_)
+			return;
+
+		disconnect (Watcher_,
+				0,
+				this,
+				0);
+		Watcher_->cancel ();
+		Watcher_->deleteLater ();
+		Watcher_ = nullptr;
+	}
+
+	bool TextSearchEngine::IsIndexComplete () const
+	{
+		return !Index_.isEmpty () && Index_.size () == Doc_->GetNumPages ();
+	}
+
+	QList<QPair<int, int>> TextSearchEngine::GetSearchRanges (const QString& text,
+			Qt::CaseSensitivity cs, int chunkSize) const
+	{
+		QList<QPair<int, int>> result;
+
+		if (!IsIndexComplete ())
+		{
+			for (int i = 0, size = Doc_->GetNumPages (); i < size; i += chunkSize)
+				result.append ({ i, std::min (chunkSize, size - i) });
+			return result;
+		}
+
+		const auto& normalized = NormalizeText (text);
+		for (int i = 0; i < Index_.size (); ++i)
+		{
+			if (!Index_.at (i).contains (normalized, cs))
+				continue;
+
+			if (!result.isEmpty () &&
+					result.last ().first + result.last ().second == i &&
+					result.last ().second < chunkSize)
+				++result.last ().second;
+			else
+				result.append ({ i, 1 });
+		}
+		return result;
+	}
+
+	void TextSearchEngine::handleResultsReady (int begin, int end)
+	{
+		for (int i = begin; i < end; ++i)
+		{
+			const auto& result = Watcher_->resultAt (i);
+			emit pageResultsReady (result.Page_, result.Rects_);
+		}
+	}
+
+	void TextSearchEngine::handleWatcherFinished ()
+	{
+		Watcher_->deleteLater ();
+		Watcher_ = nullptr;
+
+		emit searchFinished ();
+	}
+
+	void TextSearchEngine::processChunk ()
+	{
+		if (PendingRanges_.isEmpty ())
+		{
+			ChunkTimer_->stop ();
+			return;
+		}
+
+		const auto range = PendingRanges_.takeFirst ();
+		const auto& map = Searchable_->GetPageRangeTextPositions (Text_, CS_, range.first, range.second);
+		for (auto i = map.begin (); i != map.end (); ++i)
+			emit pageResultsReady (i.key (), i.value ());
+
+		if (PendingRanges_.isEmpty ())
+		{
+			ChunkTimer_->stop ();
+			emit searchFinished ();
+		}
+	}
+
+	void TextSearchEngine::indexNextPage ()
+	{
+		const auto textContent = qobject_cast<IHaveTextContent*> (Doc_->GetQObject ());
+		Index_ << NormalizeText (textContent->GetTextContent (Index_.size (), QRect ()));
+
+		if (!IsIndexComplete ())
+			return;
+
+		IndexTimer_->stop ();
+		Core::Instance ().GetDocStateManager ()->SetTextIndex (DocId_, { DocModified_, Index_ });
+	}
+}
+}
@@ -0,0 +1,93 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QStringList>
+#include <QDateTime>
+#include <QRectF>
+#include <QFutureWatcher>
+#include "interfaces/monocle/idocument.h"
+
+class QTimer;
+
+namespace LeechCraft
+{
+namespace Monocle
+{
+	class ISearchableDocument;
+
+	class TextSearchEngine : public QObject
+	{
+		Q_OBJECT
+	public:
+		struct PageResult
+		{
+			int Page_;
+			QList<QRectF> Rects_;
+		};
+	private:
+		IDocument_ptr Doc_;
+		ISearchableDocument *Searchable_;
+
+		QString DocId_;
+		QDateTime DocModified_;
+		QStringList Index_;
+		QTimer * const IndexTimer_;
+
+		QFutureWatcher<PageResult> *Watcher_;
+
+		QString Text_;
+		Qt::CaseSensitivity CS_;
+		QList<QPair<int, int>> PendingRanges_;
+		QTimer * const ChunkTimer_;
+	public:
+		TextSearchEngine (QObject* = 0);
+		~TextSearchEngine ();
+
+		void HandleDoc (IDocument_ptr);
+
+		void Search (const QString&, Qt::CaseSensitivity);
+		void Cancel ();
+	private:
+		bool IsIndexComplete () const;
+		QList<QPair<int, int>> GetSearchRanges (const QString&, Qt::CaseSensitivity, int) const;
+	private slots:
+		void handleResultsReady (int, int);
+		void handleWatcherFinished ();
+
+		void processChunk ();
+		void indexNextPage ();
+	signals:
+		void pageResultsReady (int, const QList<QRectF>&);
+		void searchFinished ();
+	};
+}
+}
@@ -34,6 +34,7 @@
 #include "interfaces/monocle/isearchabledocument.h"
 #include "pagegraphicsitem.h"
 #include "pageslayoutmanager.h"
+#include "textsearchengine.h"
 
 namespace LeechCraft
 {
@@ -44,8 +45,19 @@ namespace Monocle
 	, View_ (view)
 	, Scene_ (view->scene ())
 	, LayoutMgr_ (mgr)
+	, Engine_ (new TextSearchEngine (this))
+	, CurrentCS_ (Qt::CaseInsensitive)
+	, SearchRunning_ (false)
 	, CurrentRectIndex_ (-1)
 	{
+		connect (Engine_,
+				SIGNAL (pageResultsReady (int, QList<QRectF>)),
+				this,
+				SLOT (handlePageResults (int, QList<QRectF>)));
+		connect (Engine_,
+				SIGNAL (searchFinished ()),
+				this,
+				SLOT (handleSearchFinished ()));
 	}
 
 	void TextSearchHandler::HandleDoc (IDocument_ptr doc, const QList<PageGraphicsItem*>& pages)
@@ -53,6 +65,9 @@ namespace Monocle
 		Doc_ = doc;
 		Pages_ = pages;
 
+		Engine_->HandleDoc (doc);
+		SearchRunning_ = false;
+
 		CurrentHighlights_.clear ();
 		CurrentRectIndex_ = -1;
 		CurrentSearchString_.clear ();
@@ -63,53 +78,22 @@ namespace Monocle
 		if (!Doc_)
 			return false;
 
-		if (text != CurrentSearchString_)
+		const auto cs = flags & Util::FindNotification::FindCaseSensitively ?
+				Qt::CaseSensitive :
+				Qt::CaseInsensitive;
+		if (text != CurrentSearchString_ || cs != CurrentCS_)
 		{
 			CurrentSearchString_ = text;
-			for (auto item : CurrentHighlights_)
-			{
-				auto parentPage = static_cast<PageGraphicsItem*> (item->parentItem ());
-				parentPage->UnregisterChildRect (item);
-				Scene_->removeItem (item);
-				delete item;
-			}
-
-			CurrentHighlights_.clear ();
+			CurrentCS_ = cs;
+			ClearHighlights ();
 
-			auto searchable = qobject_cast<ISearchableDocument*> (Doc_->GetQObject ());
-			if (!searchable)
-				return false;
-
-			const QBrush brush (Qt::yellow);
-
-			auto cs = flags & Util::FindNotification::FindCaseSensitively ?
-					Qt::CaseSensitive :
-					Qt::CaseInsensitive;
-			const auto& map = searchable->GetTextPositions (text, cs);
-			for (auto i = map.begin (); i != map.end (); ++i)
-			{
-				auto page = Pages_.at (i.key ());
-				for (const auto& rect : *i)
-				{
-					auto item = new QGraphicsRectItem (page);
-					item->setBrush (brush);
-					item->setZValue (1);
-					item->setOpacity (0.2);
-					CurrentHighlights_ << item;
-
-					page->RegisterChildRect (item, rect,
-							[item] (const QRectF& rect) { item->setRect (rect); });
-				}
-			}
-
-			if (!CurrentHighlights_.isEmpty ())
-				SelectItem (0);
-
-			return !CurrentHighlights_.isEmpty ();
+			SearchRunning_ = true;
+			Engine_->Search (text, cs);
+			return SearchRunning_ || !CurrentHighlights_.isEmpty ();
 		}
 
 		if (CurrentHighlights_.isEmpty ())
-			return false;
+			return SearchRunning_;
 
 		if (flags & Util::FindNotification::FindBackwards)
 		{
@@ -139,6 +123,20 @@ namespace Monocle
 		return true;
 	}
 
+	void TextSearchHandler::ClearHighlights ()
+	{
+		for (auto item : CurrentHighlights_)
+		{
+			auto parentPage = static_cast<PageGraphicsItem*> (item->parentItem ());
+			parentPage->UnregisterChildRect (item);
+			Scene_->removeItem (item);
+			delete item;
+		}
+
+		CurrentHighlights_.clear ();
+		CurrentRectIndex_ = -1;
+	}
+
 	void TextSearchHandler::SelectItem (int index)
 	{
 		if (CurrentRectIndex_ >= 0 && CurrentRectIndex_ < CurrentHighlights_.size ())
@@ -163,5 +161,35 @@ namespace Monocle
 			emit navigateRequested ({}, pageIdx, x, y);
 		}
 	}
+
+	void TextSearchHandler::handlePageResults (int pageNum, const QList<QRectF>& rects)
+	{
+		if (pageNum < 0 || pageNum >= Pages_.size ())
+			return;
+
+		const QBrush brush (Qt::yellow);
+
+		auto page = Pages_.at (pageNum);
+		for (const auto& rect : rects)
+		{
+			auto item = new QGraphicsRectItem (page);
+			item->setBrush (brush);
+			item->setZValue (1);
+			item->setOpacity (0.2);
+			CurrentHighlights_ << item;
+
+			page->RegisterChildRect (item, rect,
+					[item] (const QRectF& rect) { item->setRect (rect); });
+		}
+
+		if (CurrentRectIndex_ < 0 && !CurrentHighlights_.isEmpty ())
+			SelectItem (0);
+	}
+
+	void TextSearchHandler::handleSearchFinished ()
+	{
+		SearchRunning_ = false;
+		emit searchFinished (!CurrentHighlights_.isEmpty ());
+	}
 }
 }
@@ -43,6 +43,7 @@ namespace Monocle
 {
 	class PageGraphicsItem;
 	class PagesLayoutManager;
+	class TextSearchEngine;
 
 	class TextSearchHandler : public QObject
 	{
@@ -51,11 +52,14 @@ namespace Monocle
 		QGraphicsView * const View_;
 		QGraphicsScene * const Scene_;
 		PagesLayoutManager * const LayoutMgr_;
+		TextSearchEngine * const Engine_;
 
 		IDocument_ptr Doc_;
 		QList<PageGraphicsItem*> Pages_;
 
 		QString CurrentSearchString_;
+		Qt::CaseSensitivity CurrentCS_;
+		bool SearchRunning_;
 
 		QList<QGraphicsRectItem*> CurrentHighlights_;
 		int CurrentRectIndex_;
@@ -66,9 +70,14 @@ namespace Monocle
 
 		bool Search (const QString&, Util::FindNotification::FindFlags);
 	private:
+		void ClearHighlights ();
 		void SelectItem (int);
+	private slots:
+		void handlePageResults (int, const QList<QRectF>&);
+		void handleSearchFinished ();
 	signals:
 		void navigateRequested (const QString&, int, double, double);
+		void searchFinished (bool);
 	};
 }
 }
@@ -0,0 +1,342 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "thumbscache.h"
+#include <algorithm>
+#include <QImage>
+#include <QBuffer>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDataStream>
+#include <QCryptographicHash>
+#include <QtDebug>
+#include <util/sys/paths.h>
+#include "xmlsettingsmanager.h"
+
+namespace LeechCraft
+{
+namespace Monocle
+{
+	namespace
+	{
+		const quint8 IndexVersion = 1;
+
+		QByteArray MakeKey (const QByteArray& docKey, int page, const QSize& size)
+		{
+			return docKey + '/' + QByteArray::number (page) + '/' +
+					QByteArray::number (size.width ()) + 'x' + QByteArray::number (size.height ());
+		}
+	}
+
+	ThumbsCache::ThumbsCache (QObject *parent)
+	: QObject (parent)
+	, CacheDir_ (Util::GetUserDir (Util::UserDir::Cache, "monocle/thumbs"))
+	, Pack_ (CacheDir_.absoluteFilePath ("thumbs.pack"))
+	, LiveSize_ (0)
+	, MaxSize_ (0)
+	, AccessCounter_ (0)
+	, UnsavedCount_ (0)
+	{
+		LoadIndex ();
+
+		XmlSettingsManager::Instance ().RegisterObject ("ThumbsCacheSize",
+				this, "handleCacheSizeChanged");
+		handleCacheSizeChanged ();
+	}
+
+	ThumbsCache::~ThumbsCache ()
+	{
+		QMutexLocker locker (&Mutex_);
+		SaveIndex ();
+	}
+
+	QByteArray ThumbsCache::GetDocKey (const QString& path)
+	{
+		QFile file (path);
+		if (!file.open (QIODevice::ReadOnly))
+			return {};
+
+		const QFileInfo fi (path);
+
+		QCryptographicHash hash (QCryptographicHash::Sha1);
+		hash.addData (file.read (64 * 1024));
+		hash.addData (QByteArray::number (fi.size ()));
+		hash.addData (fi.lastModified ().toString (Qt::ISODate).toUtf8 ());
+		return hash.result ().toHex ();
+	}
+
+	QImage ThumbsCache::Get (const QByteArray& docKey, int page, const QSize& size)
+	{
+		if (docKey.isEmpty ())
+			return {};
+
+		QMutexLocker locker (&Mutex_);
+
+		const auto pos = Index_.find (MakeKey (docKey, page, size));
+		if (pos == Index_.end ())
+			return {};
+
+		QImage image;
+		if (!Pack_.seek (pos->Offset_) ||
+				!image.loadFromData (Pack_.read (pos->Length_), "PNG"))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to read cached thumbnail at"
+					<< pos->Offset_;
+			LiveSize_ -= pos->Length_;
+			Index_.erase (pos);
+			return {};
+		}
+
+		pos->LastAccess_ = ++AccessCounter_;
+		return image;
+	}
+
+	void ThumbsCache::Put (const QByteArray& docKey, int page, const QSize& size, const QImage& image)
+	{
+		if (docKey.isEmpty () || image.isNull ())
+			return;
+
+		QByteArray data;
+		QBuffer buffer (&data);
+		buffer.open (QIODevice::WriteOnly);
+		if (!image.save (&buffer, "PNG"))
+			return;
+		buffer.close ();
+
+		QMutexLocker locker (&Mutex_);
+		if (data.size () > MaxSize_)
+			return;
+
+		const auto& key = MakeKey (docKey, page, size);
+		const auto pos = Index_.find (key);
+		if (pos != Index_.end ())
+			LiveSize_ -= pos->Length_;
+
+		const auto offset = Pack_.size ();
+		if (!Pack_.seek (offset) || Pack_.write (data) != data.size ())
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to write thumbnail to"
+					<< Pack_.fileName ()
+					<< Pack_.errorString ();
+			Pack_.resize (offset);
+			if (pos != Index_.end ())
+				Index_.erase (pos);
+			return;
+		}
+
+		Index_ [key] = { offset, data.size (), ++AccessCounter_ };
+		LiveSize_ += data.size ();
+
+		Evict ();
+
+		if (++UnsavedCount_ >= 16)
+			SaveIndex ();
+	}
+
+	void ThumbsCache::LoadIndex ()
+	{
+		if (!Pack_.open (QIODevice::ReadWrite))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< Pack_.fileName ()
+					<< Pack_.errorString ();
+			return;
+		}
+
+		QFile indexFile (CacheDir_.absoluteFilePath ("thumbs.index"));
+		if (!indexFile.open (QIODevice::ReadOnly))
+		{
+			Reset ();
+			return;
+		}
+
+		QDataStream istr (&indexFile);
+		quint8 version = 0;
+		istr >> version;
+		if (version != IndexVersion)
+		{
+			Reset ();
+			return;
+		}
+
+		qint64 packSize = 0;
+		quint32 count = 0;
+		istr >> packSize
+				>> AccessCounter_
+				>> count;
+
+		// Thumbnails appended after the last index save are unreachable
+		// anyway, so just drop them.
+		if (Pack_.size () < packSize)
+		{
+			Reset ();
+			return;
+		}
+		Pack_.resize (packSize);
+
+		Index_.reserve (count);
+		for (quint32 i = 0; i < count && istr.status () == QDataStream::Ok; ++i)
+		{
+			QByteArray key;
+			Entry entry;
+			istr >> key
+					>> entry.Offset_
+					>> entry.Length_
+					>> entry.LastAccess_;
+
+			if (entry.Offset_ + entry.Length_ > packSize)
+				continue;
+
+			Index_ [key] = entry;
+			LiveSize_ += entry.Length_;
+		}
+
+		if (istr.status () != QDataStream::Ok)
+			Reset ();
+	}
+
+	void ThumbsCache::SaveIndex ()
+	{
+		UnsavedCount_ = 0;
+
+		QFile indexFile (CacheDir_.absoluteFilePath ("thumbs.index"));
+		if (!indexFile.open (QIODevice::WriteOnly))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< indexFile.fileName ()
+					<< indexFile.errorString ();
+			return;
+		}
+
+		QDataStream ostr (&indexFile);
+		ostr << IndexVersion
+				<< Pack_.size ()
+				<< AccessCounter_
+				<< static_cast<quint32> (Index_.size ());
+		for (auto i = Index_.begin (); i != Index_.end (); ++i)
+			ostr << i.key ()
+					<< i->Offset_
+					<< i->Length_
+					<< i->LastAccess_;
+	}
+
+	void ThumbsCache::Reset ()
+	{
+		Index_.clear ();
+		LiveSize_ = 0;
+		AccessCounter_ = 0;
+		Pack_.resize (0);
+	}
+
+	void ThumbsCache::Evict ()
+	{
+		if (LiveSize_ <= MaxSize_)
+			return;
+
+		QList<QPair<quint64, QByteArray>> byAccess;
+		byAccess.reserve (Index_.size ());
+		for (auto i = Index_.begin (); i != Index_.end (); ++i)
+			byAccess.append ({ i->LastAccess_, i.key () });
+		std::sort (byAccess.begin (), byAccess.end ());
+
+		const auto targetSize = MaxSize_ * 9 / 10;
+		for (const auto& pair : byAccess)
+		{
+			if (LiveSize_ <= targetSize)
+				break;
+
+			LiveSize_ -= Index_.take (pair.second).Length_;
+		}
+
+		if (Pack_.size () > 2 * LiveSize_)
+			Compact ();
+	}
+
+	void ThumbsCache::Compact ()
+	{
+		QFile newPack (Pack_.fileName () + ".new");
+		if (!newPack.open (QIODevice::WriteOnly))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< newPack.fileName ()
+					<< newPack.errorString ();
+			return;
+		}
+
+		decltype (Index_) newIndex;
+		newIndex.reserve (Index_.size ());
+		for (auto i = Index_.begin (); i != Index_.end (); ++i)
+		{
+			if (!Pack_.seek (i->Offset_))
+				continue;
+
+			const auto& data = Pack_.read (i->Length_);
+			if (data.size () != i->Length_)
+				continue;
+
+			newIndex [i.key ()] = { newPack.pos (), i->Length_, i->LastAccess_ };
+			newPack.write (data);
+		}
+		newPack.close ();
+
+		Pack_.close ();
+		QFile::remove (Pack_.fileName ());
+		if (!newPack.rename (Pack_.fileName ()))
+			qWarning () << Q_FUNC_INFO
+					<< "unable to rename"
+					<< newPack.fileName ()
+					<< newPack.errorString ();
+
+		Index_ = newIndex;
+		LiveSize_ = 0;
+		for (const auto& entry : Index_)
+			LiveSize_ += entry.Length_;
+
+		if (!Pack_.open (QIODevice::ReadWrite))
+		{
+			Index_.clear ();
+			LiveSize_ = 0;
+		}
+
+		SaveIndex ();
+	}
+
+	void ThumbsCache::handleCacheSizeChanged ()
+	{
+		QMutexLocker locker (&Mutex_);
+		MaxSize_ = XmlSettingsManager::Instance ().property ("ThumbsCacheSize").value<qint64> () * 1024 * 1024;
+		Evict ();
+	}
+}
+}
@@ -32,6 +32,8 @@
 #include "pageslayoutmanager.h"
 #include "pagegraphicsitem.h"
 #include "common.h"
+#include "core.h"
+#include "thumbscache.h"
 
 namespace LeechCraft
 {
@@ -63,10 +65,14 @@ namespace Monocle
 		if (!doc)
 			return;
 
+		const auto cache = Core::Instance ().GetThumbsCache ();
+		const auto& docKey = ThumbsCache::GetDocKey (doc->GetDocURL ().toLocalFile ());
+
 		QList<PageGraphicsItem*> pages;
 		for (int i = 0, size = CurrentDoc_->GetNumPages (); i < size; ++i)
 		{
 			auto item = new PageGraphicsItem (CurrentDoc_, i);
+			item->SetThumbsCache (cache, docKey);
 			Scene_.addItem (item);
 			item->SetReleaseHandler ([this] (int page, const QPointF&) { emit pageClicked (page); });
 			pages << item;
@@ -29,6 +29,7 @@
 
 #include "textdocumentadapter.h"
 #include <cmath>
+#include <algorithm>
 #include <QTextDocument>
 #include <QTextBlock>
 #include <QAbstractTextDocumentLayout>
@@ -101,35 +102,61 @@ namespace Monocle
 
 	void TextDocumentAdapter::SetDocument (QTextDocument *doc)
 	{
+		SearchEdit_.reset ();
 		Doc_.reset (doc);
 	}
 
+	QTextEdit* TextDocumentAdapter::GetSearchEdit ()
+	{
+		const auto& pageSize = Doc_->pageSize ();
+		if (SearchEdit_ && SearchEdit_->size () == pageSize.toSize ())
+			return SearchEdit_.get ();
+
+		// Attaching the document relayouts it completely, so the editor
+		// is kept around for the subsequent chunks of the same search.
+		SearchEdit_ = std::make_shared<QTextEdit> ();
+		SearchEdit_->setHorizontalScrollBarPolicy (Qt::ScrollBarAlwaysOff);
+		SearchEdit_->setVerticalScrollBarPolicy (Qt::ScrollBarAlwaysOff);
+		SearchEdit_->setFixedSize (pageSize.toSize ());
+		SearchEdit_->setDocument (Doc_.get ());
+		Doc_->setPageSize (pageSize);
+		return SearchEdit_.get ();
+	}
+
 	QMap<int, QList<QRectF>> TextDocumentAdapter::GetTextPositions (const QString& text, Qt::CaseSensitivity cs)
+	{
+		return GetPageRangeTextPositions (text, cs, 0, GetNumPages ());
+	}
+
+	QMap<int, QList<QRectF>> TextDocumentAdapter::GetPageRangeTextPositions (const QString& text,
+			Qt::CaseSensitivity cs, int start, int count)
 	{
 		const auto& pageSize = Doc_->pageSize ();
 		const auto pageHeight = pageSize.height ();
 
-		QTextEdit hackyEdit;
-		hackyEdit.setHorizontalScrollBarPolicy (Qt::ScrollBarAlwaysOff);
-		hackyEdit.setVerticalScrollBarPolicy (Qt::ScrollBarAlwaysOff);
-		hackyEdit.setFixedSize (Doc_->pageSize ().toSize ());
-		hackyEdit.setDocument (Doc_.get ());
-		Doc_->setPageSize (pageSize);
+		const auto hackyEdit = GetSearchEdit ();
 
 		const auto tdFlags = cs == Qt::CaseSensitive ?
 				QTextDocument::FindCaseSensitively :
 				QTextDocument::FindFlags ();
 
+		const auto startPos = start ?
+				Doc_->documentLayout ()->hitTest (QPointF (0, pageHeight * start), Qt::FuzzyHit) :
+				0;
+
 		QMap<int, QList<QRectF>> result;
-		auto cursor = Doc_->find (text, 0, tdFlags);
+		auto cursor = Doc_->find (text, std::max (startPos, 0), tdFlags);
 		while (!cursor.isNull ())
 		{
-			auto endRect = hackyEdit.cursorRect (cursor);
+			auto endRect = hackyEdit->cursorRect (cursor);
 			auto startCursor = cursor;
 			startCursor.setPosition (cursor.selectionStart ());
-			auto rect = hackyEdit.cursorRect (startCursor);
+			auto rect = hackyEdit->cursorRect (startCursor);
 
 			const int pageNum = rect.y () / pageHeight;
+			if (pageNum >= start + count)
+				break;
+
 			rect.moveTop (rect.y () - pageHeight * pageNum);
 			endRect.moveTop (endRect.y () - pageHeight * pageNum);
 
@@ -140,7 +167,8 @@ namespace Monocle
 			}
 			auto bounding = rect | endRect;
 
-			result [pageNum] << bounding;
+			if (pageNum >= start)
+				result [pageNum] << bounding;
 
 			cursor = Doc_->find (text, cursor, tdFlags);
 		}
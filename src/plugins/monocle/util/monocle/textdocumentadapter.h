@@ -35,6 +35,7 @@
 #include <interfaces/monocle/isearchabledocument.h>
 
 class QTextDocument;
+class QTextEdit;
 
 namespace LeechCraft
 {
@@ -46,6 +47,8 @@ namespace Monocle
 	{
 	protected:
 		std::shared_ptr<QTextDocument> Doc_;
+	private:
+		std::shared_ptr<QTextEdit> SearchEdit_;
 	public:
 		TextDocumentAdapter (QTextDocument* = 0);
 
@@ -58,8 +61,12 @@ namespace Monocle
 		void PaintPage (QPainter*, int);
 
 		QMap<int, QList<QRectF>> GetTextPositions (const QString& text, Qt::CaseSensitivity cs);
+		QMap<int, QList<QRectF>> GetPageRangeTextPositions (const QString& text,
+				Qt::CaseSensitivity cs, int start, int count);
 	protected:
 		void SetDocument (QTextDocument*);
+	private:
+		QTextEdit* GetSearchEdit ();
 	};
 }
 }
@@ -0,0 +1,159 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2010-2012  Oleg Linkin
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "hashcache.h"
+#include <QDataStream>
+#include <QFile>
+#include <QtDebug>
+#include <util/sys/paths.h>
+
+namespace LeechCraft
+{
+namespace NetStoreManager
+{
+	HashCache::HashCache (const QString& name)
+	: Path_ (Util::CreateIfNotExists ("netstoremanager/hashcache").filePath (name))
+	, Dirty_ (false)
+	{
+		Load ();
+	}
+
+	HashCache::~HashCache ()
+	{
+		Save ();
+	}
+
+	QByteArray HashCache::Get (const QString& path, qint64 size,
+			const QDateTime& modified, int algo) const
+	{
+		const auto pos = Entries_.find (path);
+		if (pos == Entries_.end ())
+			return QByteArray ();
+
+		const auto& entry = *pos;
+		if (entry.Size_ != size ||
+				entry.ModifyDate_ != modified ||
+				entry.Algorithm_ != algo)
+			return QByteArray ();
+
+		return entry.Hash_;
+	}
+
+	void HashCache::Set (const QString& path, qint64 size,
+			const QDateTime& modified, int algo, const QByteArray& hash)
+	{
+		Entries_ [path] = { size, modified, algo, hash };
+		Dirty_ = true;
+	}
+
+	void HashCache::Retain (const QSet<QString>& paths)
+	{
+		for (auto i = Entries_.begin (); i != Entries_.end (); )
+			if (!paths.contains (i.key ()))
+			{
+				i = Entries_.erase (i);
+				Dirty_ = true;
+			}
+			else
+				++i;
+	}
+
+	void HashCache::Save ()
+	{
+		if (!Dirty_)
+			return;
+
+		QFile file (Path_);
+		if (!file.open (QIODevice::WriteOnly | QIODevice::Truncate))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< Path_
+					<< file.errorString ();
+			return;
+		}
+
+		QDataStream out (&file);
+		out << static_cast<quint8> (1)
+				<< static_cast<quint32> (Entries_.size ());
+		for (auto i = Entries_.begin (), end = Entries_.end (); i != end; ++i)
+			out << i.key ()
+					<< i->Size_
+					<< i->ModifyDate_
+					<< static_cast<qint32> (i->Algorithm_)
+					<< i->Hash_;
+
+		Dirty_ = false;
+	}
+
+	void HashCache::Load ()
+	{
+		QFile file (Path_);
+		if (!file.exists ())
+			return;
+
+		if (!file.open (QIODevice::ReadOnly))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< Path_
+					<< file.errorString ();
+			return;
+		}
+
+		QDataStream in (&file);
+		quint8 version = 0;
+		in >> version;
+		if (version != 1)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unknown version"
+					<< version;
+			return;
+		}
+
+		quint32 count = 0;
+		in >> count;
+		Entries_.reserve (count);
+		for (quint32 i = 0; i < count && in.status () == QDataStream::Ok; ++i)
+		{
+			QString path;
+			Entry entry;
+			qint32 algo = 0;
+			in >> path
+					>> entry.Size_
+					>> entry.ModifyDate_
+					>> algo
+					>> entry.Hash_;
+			entry.Algorithm_ = algo;
+			Entries_ [path] = entry;
+		}
+	}
+}
+}
@@ -0,0 +1,76 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2010-2012  Oleg Linkin
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QDateTime>
+#include <QByteArray>
+
+namespace LeechCraft
+{
+namespace NetStoreManager
+{
+	/** Persistent cache of file checksums keyed by the file path.
+	 *
+	 * A cached checksum is considered valid only while the size and the
+	 * modification time of the file as well as the hash algorithm match
+	 * the ones recorded together with the checksum.
+	 */
+	class HashCache
+	{
+		struct Entry
+		{
+			qint64 Size_;
+			QDateTime ModifyDate_;
+			int Algorithm_;
+			QByteArray Hash_;
+		};
+
+		const QString Path_;
+		QHash<QString, Entry> Entries_;
+		bool Dirty_;
+	public:
+		explicit HashCache (const QString& name);
+		~HashCache ();
+
+		QByteArray Get (const QString& path, qint64 size,
+				const QDateTime& modified, int algo) const;
+		void Set (const QString& path, qint64 size,
+				const QDateTime& modified, int algo, const QByteArray& hash);
+		void Retain (const QSet<QString>& paths);
+
+		void Save ();
+	private:
+		void Load ();
+	};
+}
+}
@@ -28,13 +28,15 @@
  **********************************************************************/
 
 #include "syncer.h"
-#include <future>
+#include <algorithm>
 #include <QCryptographicHash>
 #include <QFileInfo>
 #include <QStandardItem>
 #include <QtDebug>
 #include <QUuid>
+#include <QtConcurrentMap>
 #include "interfaces/netstoremanager/istorageaccount.h"
+#include "hashcache.h"
 #include "utils.h"
 
 namespace LeechCraft
@@ -49,7 +51,14 @@ namespace NetStoreManager
 	, Started_ (false)
 	, Account_ (isa)
 	, SFLAccount_ (qobject_cast<ISupportFileListings*> (isa->GetQObject ()))
+	, HashCache_ (std::make_shared<HashCache> (QCryptographicHash::hash (isa->GetUniqueID () +
+				dirPath.toUtf8 (), QCryptographicHash::Md5).toHex ()))
+	, HashWatcher_ (new QFutureWatcher<HashResult> (this))
 	{
+		connect (HashWatcher_,
+				SIGNAL (finished ()),
+				this,
+				SLOT (handleHashingFinished ()));
 	}
 
 	QByteArray Syncer::GetAccountID () const
@@ -111,10 +120,15 @@ namespace NetStoreManager
 			if (existingPath.at (lastPos) != nonExistingPath.at (lastPos))
 				break;
 
-		SFLAccount_->CreateDirectory (nonExistingPath.at (lastPos),
-				existingPath.isEmpty () ?
-					QByteArray () :
-					Id2Path_.right.at (existingPath.join ("/")));
+		const auto& requested = nonExistingPath.mid (0, lastPos + 1).join ("/");
+		if (!RequestedDirs_.contains (requested))
+		{
+			RequestedDirs_ << requested;
+			SFLAccount_->CreateDirectory (nonExistingPath.at (lastPos),
+					existingPath.isEmpty () ?
+						QByteArray () :
+						Id2Path_.right.at (existingPath.join ("/")));
+		}
 		if (lastPos != nonExistingPath.length () - 1)
 			CallsQueue_.append ([this, nonExistingPath] ()
 				{ CreateRemotePath (nonExistingPath); });
@@ -147,6 +161,36 @@ namespace NetStoreManager
 			}
 	}
 
+	void Syncer::WithRemoteDir (const QString& path, std::function<void (QByteArray)> func)
+	{
+		if (path.isEmpty ())
+		{
+			func (QByteArray ());
+			return;
+		}
+
+		if (Id2Path_.right.count (path))
+		{
+			func (Id2Path_.right.at (path));
+			return;
+		}
+
+		CreateRemotePath (path.split ('/'));
+		CallsQueue_.append ([this, path, func] () { WithRemoteDir (path, func); });
+	}
+
+	QString Syncer::ToRemotePath (const QString& relativePath) const
+	{
+		return RemotePath_ + "/" + relativePath;
+	}
+
+	HashAlgorithm Syncer::GetHashAlgorithm () const
+	{
+		return SFLAccount_ ?
+				SFLAccount_->GetCheckSumAlgorithm () :
+				HashAlgorithm::Md5;
+	}
+
 	namespace
 	{
 		QCryptographicHash::Algorithm NSMHashType2QtCryproHashAlgorithm (HashAlgorithm hash)
@@ -162,58 +206,227 @@ namespace NetStoreManager
 				return QCryptographicHash::Md5;
 			}
 		}
+
+		struct FileHasher
+		{
+			typedef Syncer::HashResult result_type;
+
+			QCryptographicHash::Algorithm Algo_;
+
+			Syncer::HashResult operator() (const Syncer::HashJob& job) const
+			{
+				return { job.RelativePath_, Utils::HashFile (job.AbsolutePath_, Algo_) };
+			}
+		};
+
+		QString ParentPath (const QString& path)
+		{
+			const int pos = path.lastIndexOf ('/');
+			return pos < 0 ? QString () : path.left (pos);
+		}
 	}
 
-	Snapshot_t Syncer::CreateSnapshot ()
+	void Syncer::CreateSnapshot ()
 	{
-		Snapshot_t snapshot;
+		if (HashWatcher_->isRunning ())
+			return;
 
-		for (const auto& fi : QDir (LocalPath_).entryInfoList (QDir::NoDotAndDotDot | QDir::AllEntries))
+		PendingSnapshot_.clear ();
+
+		const auto algo = GetHashAlgorithm ();
+		QList<HashJob> jobs;
+		const auto& paths = Utils::ScanDir (QDir::NoDotAndDotDot | QDir::AllEntries,
+				LocalPath_, true);
+		for (const auto& absPath : paths)
 		{
-			const QString path = fi.absoluteFilePath ().remove (LocalPath_ + "/");
+			const QFileInfo fi (absPath);
+			const QString path = QString (absPath).remove (0, LocalPath_.size () + 1);
+			const auto& key = path.toUtf8 ();
+
 			Change change;
-			StorageItem storage;
-			if (!Id2Path_.right.count (path))
-				change.ItemID_ = Id2Path_.right.at (path);
+			change.ID_ = key;
+			change.Deleted_ = false;
+
+			const auto& remotePath = ToRemotePath (path);
+			if (Id2Path_.right.count (remotePath))
+				change.ItemID_ = Id2Path_.right.at (remotePath);
+			else if (Snapshot_.contains (key))
+				change.ItemID_ = Snapshot_ [key].ItemID_;
 			else
-			{
 				change.ItemID_ = QUuid::createUuid ().toByteArray ();
 
-				storage.IsDirectory_ = fi.isDir ();
-				storage.Name_ = fi.fileName ();
-				storage.ModifyDate_ = fi.lastModified ();
-				storage.ID_ = change.ItemID_;
-			}
+			StorageItem& storage = change.Item_;
+			storage.ID_ = change.ItemID_;
+			storage.IsDirectory_ = fi.isDir ();
+			storage.Name_ = fi.fileName ();
+			storage.ModifyDate_ = fi.lastModified ();
+			storage.HashType_ = algo;
 
 			if (fi.isFile ())
 			{
-				QFile file (fi.absoluteFilePath ());
-				if (file.open (QIODevice::ReadOnly))
+				storage.Size_ = fi.size ();
+				storage.Hash_ = HashCache_->Get (absPath, fi.size (),
+						fi.lastModified (), static_cast<int> (algo));
+				if (storage.Hash_.isEmpty ())
+					jobs.append (HashJob { path, absPath });
+			}
+
+			PendingSnapshot_ [key] = change;
+		}
+
+		HashWatcher_->setFuture (QtConcurrent::mapped (jobs,
+				FileHasher { NSMHashType2QtCryproHashAlgorithm (algo) }));
+	}
+
+	Syncer::SnapshotDiff Syncer::CreateDiffSnapshot (const Snapshot_t& newSnapshot,
+			const Snapshot_t& oldSnapshot) const
+	{
+		SnapshotDiff diff;
+
+		for (auto i = newSnapshot.begin (), end = newSnapshot.end (); i != end; ++i)
+		{
+			const auto pos = oldSnapshot.find (i.key ());
+			if (pos == oldSnapshot.end ())
+				diff.Created_ << *i;
+			else if (!i->Item_.IsDirectory_ &&
+					(pos->Item_.IsDirectory_ ||
+					 pos->Item_.Size_ != i->Item_.Size_ ||
+					 pos->Item_.Hash_ != i->Item_.Hash_))
+				diff.Modified_ << *i;
+		}
+
+		for (auto i = oldSnapshot.begin (), end = oldSnapshot.end (); i != end; ++i)
+			if (!newSnapshot.contains (i.key ()))
+				diff.Removed_ << *i;
+
+		// A removed file and a created file with the same size and checksum
+		// are considered to be the same file that has been renamed or moved.
+		typedef QPair<quint64, QByteArray> Signature_t;
+		QHash<Signature_t, QList<int>> removedBySignature;
+		for (int i = 0; i < diff.Removed_.size (); ++i)
+		{
+			const auto& item = diff.Removed_.at (i).Item_;
+			if (!item.IsDirectory_ && !item.Hash_.isEmpty ())
+				removedBySignature [{ item.Size_, item.Hash_ }] << i;
+		}
+
+		if (!removedBySignature.isEmpty ())
+		{
+			QSet<int> renamedSources;
+			for (auto i = diff.Created_.begin (); i != diff.Created_.end (); )
+			{
+				const auto& item = i->Item_;
+				auto pos = removedBySignature.find ({ item.Size_, item.Hash_ });
+				if (item.IsDirectory_ || pos == removedBySignature.end () || pos->isEmpty ())
 				{
-					const auto& ba = file.readAll ();
-					storage.Hash_ = QCryptographicHash::hash (ba,
-							NSMHashType2QtCryproHashAlgorithm (SFLAccount_->GetCheckSumAlgorithm ()));
-					file.close ();
+					++i;
+					continue;
 				}
-				else
-					qWarning () << Q_FUNC_INFO
-							<< "unable to open file for hash calculation";
 
-				storage.Size_ = fi.size ();
+				const int source = pos->takeFirst ();
+				renamedSources << source;
+				diff.Renamed_.append (qMakePair (diff.Removed_.at (source), *i));
+				i = diff.Created_.erase (i);
 			}
 
-			change.Item_ = storage;
-			snapshot [change.ID_] = change;
+			QList<Change> removed;
+			for (int i = 0; i < diff.Removed_.size (); ++i)
+				if (!renamedSources.contains (i))
+					removed << diff.Removed_.at (i);
+			diff.Removed_ = removed;
 		}
 
-		return snapshot;
+		return diff;
 	}
 
-	Snapshot_t Syncer::CreateDiffSnapshot (const Snapshot_t& newSnapshot,
-			const Snapshot_t& oldSnapshot)
+	void Syncer::UploadFile (const Change& change, bool update)
 	{
-		Snapshot_t diffSnapshot;
-		return diffSnapshot;
+		const QString path = QString::fromUtf8 (change.ID_);
+		const auto& remotePath = ToRemotePath (path);
+		const auto& absPath = LocalPath_ + "/" + path;
+
+		QByteArray id;
+		if (Id2Path_.right.count (remotePath))
+		{
+			id = Id2Path_.right.at (remotePath);
+			if (!change.Item_.Hash_.isEmpty () &&
+					Id2Item_.value (id).Hash_ == change.Item_.Hash_)
+				return;
+		}
+
+		WithRemoteDir (ParentPath (remotePath),
+				[this, absPath, id, update] (const QByteArray& parentId)
+				{
+					if (update && !id.isEmpty ())
+						Account_->Upload (absPath, parentId, UploadType::Update, id);
+					else
+						Account_->Upload (absPath, parentId);
+				});
+	}
+
+	void Syncer::ApplyDiff (const SnapshotDiff& diff)
+	{
+		auto byPath = [] (const Change& left, const Change& right)
+			{ return left.ID_ < right.ID_; };
+
+		auto created = diff.Created_;
+		std::sort (created.begin (), created.end (), byPath);
+		for (const auto& change : created)
+			if (change.Item_.IsDirectory_)
+				CreateRemotePath (ToRemotePath (QString::fromUtf8 (change.ID_)).split ('/'));
+			else
+				UploadFile (change, false);
+
+		for (const auto& change : diff.Modified_)
+			UploadFile (change, true);
+
+		for (const auto& pair : diff.Renamed_)
+		{
+			const auto& oldRemote = ToRemotePath (QString::fromUtf8 (pair.first.ID_));
+			if (!Id2Path_.right.count (oldRemote))
+			{
+				UploadFile (pair.second, false);
+				continue;
+			}
+
+			const auto& id = Id2Path_.right.at (oldRemote);
+			const auto& newRemote = ToRemotePath (QString::fromUtf8 (pair.second.ID_));
+			const auto& newName = pair.second.Item_.Name_;
+			if (ParentPath (oldRemote) == ParentPath (newRemote))
+			{
+				SFLAccount_->Rename (id, newName);
+				continue;
+			}
+
+			const bool sameName = pair.first.Item_.Name_ == newName;
+			WithRemoteDir (ParentPath (newRemote),
+					[this, id, newName, sameName] (const QByteArray& parentId)
+					{
+						SFLAccount_->Move ({ id }, parentId);
+						if (!sameName)
+							SFLAccount_->Rename (id, newName);
+					});
+		}
+
+		// Trash only the topmost removed entries: removing a directory
+		// takes care of everything below it.
+		auto removed = diff.Removed_;
+		std::sort (removed.begin (), removed.end (), byPath);
+		QString lastRemovedDir;
+		for (const auto& change : removed)
+		{
+			const QString path = QString::fromUtf8 (change.ID_);
+			if (!lastRemovedDir.isEmpty () &&
+					path.startsWith (lastRemovedDir + "/"))
+				continue;
+
+			if (change.Item_.IsDirectory_)
+				lastRemovedDir = path;
+
+			const auto& remotePath = ToRemotePath (path);
+			if (Id2Path_.right.count (remotePath))
+				DeleteRemotePath (remotePath.split ('/'));
+		}
 	}
 
 	void Syncer::start ()
@@ -221,17 +434,60 @@ namespace NetStoreManager
 		if (Started_)
 			return;
 
+		if (!SFLAccount_)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "account"
+					<< Account_->GetAccountName ()
+					<< "doesn't support file listings";
+			return;
+		}
+
 		Started_ = true;
 		QStringList path = RemotePath_.split ('/');
 		CreateRemotePath (path);
 
-		const auto& newSnapshot = CreateSnapshot ();
-		//TODO create diff
+		CreateSnapshot ();
+	}
+
+	void Syncer::handleHashingFinished ()
+	{
+		const auto algo = static_cast<int> (GetHashAlgorithm ());
+		for (const auto& result : HashWatcher_->future ().results ())
+		{
+			const auto key = result.RelativePath_.toUtf8 ();
+			if (!PendingSnapshot_.contains (key) || result.Hash_.isEmpty ())
+				continue;
+
+			auto& item = PendingSnapshot_ [key].Item_;
+			item.Hash_ = result.Hash_;
+			HashCache_->Set (LocalPath_ + "/" + result.RelativePath_,
+					item.Size_, item.ModifyDate_, algo, item.Hash_);
+		}
+
+		QSet<QString> alive;
+		for (auto i = PendingSnapshot_.begin (), end = PendingSnapshot_.end (); i != end; ++i)
+			if (!i->Item_.IsDirectory_)
+				alive << LocalPath_ + "/" + QString::fromUtf8 (i.key ());
+		HashCache_->Retain (alive);
+		HashCache_->Save ();
+
+		if (!Started_)
+		{
+			PendingSnapshot_.clear ();
+			return;
+		}
+
+		ApplyDiff (CreateDiffSnapshot (PendingSnapshot_, Snapshot_));
+
+		Snapshot_ = PendingSnapshot_;
+		PendingSnapshot_.clear ();
 	}
 
 	void Syncer::stop ()
 	{
 		CallsQueue_.clear ();
+		RequestedDirs_.clear ();
 		Started_ = false;
 	}
 
@@ -289,10 +545,12 @@ namespace NetStoreManager
 	void Syncer::handleGotNewItem (const StorageItem& item, const QByteArray& parentId)
 	{
 		Id2Item_ [item.ID_] = item;
-		Id2Path_.insert ({ item.ID_, (Id2Item_.contains (parentId) ?
+		const auto& path = (Id2Item_.contains (parentId) ?
 			(Id2Path_.left.at (parentId) + "/") :
 			QString ())
-				+ item.Name_ });
+				+ item.Name_;
+		Id2Path_.insert ({ item.ID_, path });
+		RequestedDirs_.remove (path);
 
 		if (!CallsQueue_.isEmpty ())
 			CallsQueue_.dequeue () ();
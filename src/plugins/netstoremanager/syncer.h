@@ -30,9 +30,12 @@
 #pragma once
 
 #include <functional>
+#include <memory>
 #include <boost/bimap.hpp>
 #include <QObject>
 #include <QQueue>
+#include <QSet>
+#include <QFutureWatcher>
 #include "interfaces/netstoremanager/isupportfilelistings.h"
 #include "syncmanager.h"
 
@@ -41,10 +44,32 @@ namespace LeechCraft
 namespace NetStoreManager
 {
 	class IStorageAccount;
+	class HashCache;
 
 	class Syncer : public QObject
 	{
 		Q_OBJECT
+	public:
+		struct SnapshotDiff
+		{
+			QList<Change> Created_;
+			QList<Change> Modified_;
+			QList<Change> Removed_;
+			QList<QPair<Change, Change>> Renamed_;
+		};
+
+		struct HashJob
+		{
+			QString RelativePath_;
+			QString AbsolutePath_;
+		};
+
+		struct HashResult
+		{
+			QString RelativePath_;
+			QByteArray Hash_;
+		};
+	private:
 
 		QString LocalPath_;
 		QString RemotePath_;
@@ -54,9 +79,14 @@ namespace NetStoreManager
 		QHash<QByteArray, StorageItem> Id2Item_;
 		boost::bimaps::bimap<QByteArray, QString> Id2Path_;
 		QQueue<std::function<void (void)>> CallsQueue_;
+		QSet<QString> RequestedDirs_;
 
 		Snapshot_t Snapshot_;
 
+		std::shared_ptr<HashCache> HashCache_;
+		QFutureWatcher<HashResult> *HashWatcher_;
+		Snapshot_t PendingSnapshot_;
+
 	public:
 		explicit Syncer (const QString& dirPath, const QString& remotePath,
 				IStorageAccount *isa, QObject *parent = 0);
@@ -73,14 +103,23 @@ namespace NetStoreManager
 		void CreateRemotePath (const QStringList& path);
 		void DeleteRemotePath (const QStringList& path);
 		void RenameItem (const StorageItem& item, const QString& path);
-		Snapshot_t CreateSnapshot ();
-		Snapshot_t CreateDiffSnapshot (const Snapshot_t& newSnapshot,
-				const Snapshot_t& oldSnapshot);
+		void WithRemoteDir (const QString& path, std::function<void (QByteArray)> func);
+
+		QString ToRemotePath (const QString& relativePath) const;
+		HashAlgorithm GetHashAlgorithm () const;
+
+		void CreateSnapshot ();
+		SnapshotDiff CreateDiffSnapshot (const Snapshot_t& newSnapshot,
+				const Snapshot_t& oldSnapshot) const;
+		void ApplyDiff (const SnapshotDiff& diff);
+		void UploadFile (const Change& change, bool update);
 
 	public slots:
 		void start ();
 		void stop ();
 
+		void handleHashingFinished ();
+
 		void handleGotItems (const QList<StorageItem>& items);
 		void handleGotNewItem (const StorageItem& item, const QByteArray& parentId);
 		void handleGotChanges (const QList<Change>& changes);
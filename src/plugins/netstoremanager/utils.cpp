@@ -28,6 +28,7 @@
  **********************************************************************/
 
 #include "utils.h"
+#include <QtDebug>
 
 namespace LeechCraft
 {
@@ -73,6 +74,36 @@ namespace Utils
 		return result;
 	}
 
+	QByteArray HashFile (const QString& path, QCryptographicHash::Algorithm algo)
+	{
+		QFile file (path);
+		if (!file.open (QIODevice::ReadOnly))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open file for hash calculation"
+					<< path
+					<< file.errorString ();
+			return QByteArray ();
+		}
+
+		const qint64 chunkSize = 1024 * 1024;
+		QCryptographicHash hash (algo);
+		while (!file.atEnd ())
+		{
+			const auto& chunk = file.read (chunkSize);
+			if (chunk.isEmpty () && file.error () != QFile::NoError)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "error reading"
+						<< path
+						<< file.errorString ();
+				return QByteArray ();
+			}
+			hash.addData (chunk);
+		}
+
+		return hash.result ();
+	}
 }
 }
 }
@@ -31,6 +31,7 @@
 
 #include <QString>
 #include <QDir>
+#include <QCryptographicHash>
 #include "interfaces/netstoremanager/isupportfilelistings.h"
 
 namespace LeechCraft
@@ -41,6 +42,12 @@ namespace Utils
 {
 	QStringList ScanDir (QDir::Filters filter, const QString& path, bool recursive = false);
 	bool RemoveDirectoryContent (const QString& dirPath);
+
+	/** Computes the checksum of the file at the given path reading it in
+	 * fixed-size chunks, so the whole file is never held in memory.
+	 * Returns an empty array if the file cannot be read.
+	 */
+	QByteArray HashFile (const QString& path, QCryptographicHash::Algorithm algo);
 }
 }
 }
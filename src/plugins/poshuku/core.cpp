@@ -42,6 +42,7 @@
 #include <QNetworkCookieJar>
 #include <QDir>
 #include <QMenu>
+#include <QTimer>
 #include <QInputDialog>
 #include <QNetworkReply>
 #include <QSslSocket>
@@ -152,6 +153,9 @@ namespace Poshuku
 				SIGNAL (added (const HistoryItem&)),
 				URLCompletionModel_.get (),
 				SLOT (handleItemAdded (const HistoryItem&)));
+		QTimer::singleShot (0,
+				URLCompletionModel_.get (),
+				SLOT (buildIndex ()));
 
 		FavoritesModel_.reset (new FavoritesModel (this));
 		connect (StorageBackend_.get (),
@@ -39,20 +39,56 @@ namespace Poshuku
 	{
 	}
 	
+	namespace
+	{
+		QString EscapeLike (QString text)
+		{
+			// Should match the ESCAPE clause of the storage backends.
+			return text.replace ('!', "!!")
+					.replace ('%', "!%")
+					.replace ('_', "!_");
+		}
+	}
+
+	void HistoryFilterModel::SetFilter (const QString& text,
+			QRegExp::PatternSyntax syntax, Qt::CaseSensitivity cs)
+	{
+		QString like;
+		switch (syntax)
+		{
+		case QRegExp::FixedString:
+			like = "%" + EscapeLike (text) + "%";
+			break;
+		case QRegExp::Wildcard:
+			like = "%" + EscapeLike (text)
+					.replace ('*', '%')
+					.replace ('?', '_') + "%";
+			break;
+		default:
+			// Regexps can't be expressed via LIKE, so they are applied
+			// only to the already loaded items.
+			break;
+		}
+
+		if (auto model = qobject_cast<HistoryModel*> (sourceModel ()))
+			model->SetFilter (text.isEmpty () ? QString () : like);
+
+		setFilterRegExp (QRegExp (text, cs, syntax));
+	}
+
 	bool HistoryFilterModel::filterAcceptsRow (int row, const QModelIndex& parent) const
 	{
-		if (sourceModel ()->rowCount (sourceModel ()->index (row, 0, parent)))
+		if (!parent.isValid ())
 			return true;
-		
-		const auto& filter = filterRegExp ().pattern ();
+
+		const auto& filter = filterRegExp ();
 		if (filter.isEmpty ())
 			return true;
-		
+
 		auto source = sourceModel ();
 		auto contains = [&filter, source, row, parent] (HistoryModel::Columns col)
 		{
-			return source->index (row, col, parent).data ()
-					.toString ().contains (filter, Qt::CaseInsensitive);
+			return filter.indexIn (source->index (row, col, parent).data ().toString ()) != -1;
 		};
 		return contains (HistoryModel::ColumnTitle) || contains (HistoryModel::ColumnURL);
 	}
@@ -30,6 +30,7 @@
 #ifndef PLUGINS_POSHUKU_HISTORYFILTERMODEL_H
 #define PLUGINS_POSHUKU_HISTORYFILTERMODEL_H
 #include <QSortFilterProxyModel>
+#include <QRegExp>
 
 namespace LeechCraft
 {
@@ -40,6 +41,12 @@ namespace Poshuku
 		Q_OBJECT
 	public:
 		HistoryFilterModel (QObject* = 0);
+
+		/** Sets the filter both on this proxy and, as an SQL LIKE pattern
+			* where possible, on the source HistoryModel, so that only
+			* matching items are loaded from the storage.
+			*/
+		void SetFilter (const QString&, QRegExp::PatternSyntax, Qt::CaseSensitivity);
 	protected:
 		virtual bool filterAcceptsRow (int, const QModelIndex&) const;
 	};
@@ -32,6 +32,8 @@
 #include <QTimer>
 #include <QVariant>
 #include <QAction>
+#include <QSet>
+#include <QRegExp>
 #include <QtDebug>
 #include <util/xpc/defaulthookproxy.h>
 #include <interfaces/core/icoreproxy.h>
@@ -46,7 +48,10 @@ namespace Poshuku
 {
 	namespace
 	{
-		/** Returns the number of the section for the given date.
+		const int PageSize = 200;
+
+		/** Returns the [from; to) date range of the section with the
+			* given number.
 			*
 			* - Today
 			* - Yesterday
@@ -59,29 +64,49 @@ namespace Poshuku
 			* - ...
 			* - Last N months
 			*/
-		int SectionNumber (const QDateTime& date, QDateTime current = QDateTime ())
+		QPair<QDateTime, QDateTime> SectionBounds (int number, const QDate& today)
 		{
-			if (!current.isValid ())
-				current = QDateTime::currentDateTime ();
-
-			QDate orig = current.date ();
-			if (date.daysTo (current) == 0)
-				return 0;
-			else if (date.daysTo (current) == 1)
-				return 1;
-			else if (date.daysTo (current) == 2)
-				return 2;
-			else if (date.daysTo (current) <= 7)
-				return 3;
-
-			int i = 0;
-			while (true)
+			switch (number)
 			{
-				current.setDate (orig.addMonths (--i));
+				case 0:
+					return { QDateTime (today), QDateTime (today).addYears (100) };
+				case 1:
+					return { QDateTime (today.addDays (-1)), QDateTime (today) };
+				case 2:
+					return { QDateTime (today.addDays (-2)), QDateTime (today.addDays (-1)) };
+				case 3:
+					return { QDateTime (today.addDays (-7)), QDateTime (today.addDays (-2)) };
+				case 4:
+					return { QDateTime (today.addMonths (-1)), QDateTime (today.addDays (-7)) };
+				default:
+					return
+					{
+						QDateTime (today.addMonths (-(number - 3))),
+						QDateTime (today.addMonths (-(number - 4)))
+					};
+			}
+		}
 
-				if (date.daysTo (current) <= 0)
-					return -i + 3;
+		/** Checks the text against the LIKE pattern the same way the
+			* history range query of the storage backends does, that is,
+			* case-insensitively and with '!' as the escape character.
+			*/
+		bool MatchesLike (const QString& text, const QString& like)
+		{
+			QString pattern;
+			for (int i = 0; i < like.size (); ++i)
+			{
+				const auto c = like.at (i);
+				if (c == '!' && i + 1 < like.size ())
+					pattern += QRegExp::escape (like.at (++i));
+				else if (c == '%')
+					pattern += ".*";
+				else if (c == '_')
+					pattern += '.';
+				else
+					pattern += QRegExp::escape (c);
 			}
+			return QRegExp (pattern, Qt::CaseInsensitive).exactMatch (text);
 		}
 
 		QString SectionName (int number)
@@ -105,9 +130,9 @@ namespace Poshuku
 	};
 
 	HistoryModel::HistoryModel (QObject *parent)
-	: QStandardItemModel { parent }
+	: QAbstractItemModel { parent }
+	, Filter_ { "%" }
 	{
-		setHorizontalHeaderLabels ({tr ("Title"), tr ("URL"), tr ("Date") });
 		QTimer::singleShot (0,
 				this,
 				SLOT (loadData ()));
@@ -120,6 +145,180 @@ namespace Poshuku
 				SLOT (collectGarbage ()));
 	}
 
+	QModelIndex HistoryModel::index (int row, int column, const QModelIndex& parent) const
+	{
+		if (!hasIndex (row, column, parent))
+			return {};
+
+		if (!parent.isValid ())
+			return createIndex (row, column, static_cast<quint32> (0));
+
+		return createIndex (row, column, static_cast<quint32> (parent.row () + 1));
+	}
+
+	QModelIndex HistoryModel::parent (const QModelIndex& index) const
+	{
+		if (!index.isValid () || !index.internalId ())
+			return {};
+
+		return createIndex (index.internalId () - 1, 0, static_cast<quint32> (0));
+	}
+
+	int HistoryModel::rowCount (const QModelIndex& parent) const
+	{
+		if (!parent.isValid ())
+			return Sections_.size ();
+
+		if (parent.internalId () || parent.column ())
+			return 0;
+
+		return Sections_.at (parent.row ()).Items_.size ();
+	}
+
+	int HistoryModel::columnCount (const QModelIndex&) const
+	{
+		return 3;
+	}
+
+	bool HistoryModel::hasChildren (const QModelIndex& parent) const
+	{
+		if (!parent.isValid ())
+			return !Sections_.isEmpty ();
+
+		if (parent.internalId () || parent.column ())
+			return false;
+
+		const auto& section = Sections_.at (parent.row ());
+		return section.CanFetchMore_ || !section.Items_.empty ();
+	}
+
+	QVariant HistoryModel::data (const QModelIndex& index, int role) const
+	{
+		if (!index.isValid ())
+			return {};
+
+		if (!index.internalId ())
+		{
+			if (index.column () != ColumnTitle)
+				return {};
+
+			switch (role)
+			{
+			case Qt::DisplayRole:
+				return SectionName (index.row ());
+			case Qt::DecorationRole:
+				return Core::Instance ().GetProxy ()->
+						GetIconThemeManager ()->GetIcon ("document-open-folder");
+			default:
+				return {};
+			}
+		}
+
+		const auto& item = Sections_.at (index.internalId () - 1).Items_.at (index.row ());
+		auto normalizeText = [] (QString text)
+		{
+			return text.trimmed ().replace ('\n', ' ');
+		};
+
+		switch (role)
+		{
+		case Qt::DisplayRole:
+			switch (index.column ())
+			{
+			case ColumnTitle:
+				return normalizeText (item.Title_);
+			case ColumnURL:
+				return normalizeText (item.URL_);
+			case ColumnDate:
+				return QLocale {}.toString (item.DateTime_, QLocale::ShortFormat);
+			}
+			return {};
+		case Qt::DecorationRole:
+			if (index.column () != ColumnTitle)
+				return {};
+			return Core::Instance ().GetIcon (QUrl { item.URL_ });
+		default:
+			return {};
+		}
+	}
+
+	QVariant HistoryModel::headerData (int section, Qt::Orientation orient, int role) const
+	{
+		if (orient != Qt::Horizontal || role != Qt::DisplayRole)
+			return {};
+
+		switch (section)
+		{
+		case ColumnTitle:
+			return tr ("Title");
+		case ColumnURL:
+			return tr ("URL");
+		case ColumnDate:
+			return tr ("Date");
+		default:
+			return {};
+		}
+	}
+
+	bool HistoryModel::canFetchMore (const QModelIndex& parent) const
+	{
+		if (!parent.isValid () || parent.internalId ())
+			return false;
+
+		return Sections_.at (parent.row ()).CanFetchMore_;
+	}
+
+	void HistoryModel::fetchMore (const QModelIndex& parent)
+	{
+		if (!canFetchMore (parent))
+			return;
+
+		auto& section = Sections_ [parent.row ()];
+
+		history_items_t page;
+		Core::Instance ().GetStorageBackend ()->LoadHistoryRange (section.From_, section.To_,
+				Filter_, section.Items_.size (), PageSize, page);
+		section.CanFetchMore_ = page.size () == PageSize;
+
+		if (page.empty ())
+		{
+			// Let the view drop the expansion arrow.
+			emit dataChanged (parent, parent);
+			return;
+		}
+
+		const int first = section.Items_.size ();
+		beginInsertRows (index (parent.row (), 0), first, first + page.size () - 1);
+		section.Items_ += page;
+		endInsertRows ();
+	}
+
+	void HistoryModel::ReleaseSection (int row)
+	{
+		if (row < 0 || row >= Sections_.size ())
+			return;
+
+		ClearSection (row);
+	}
+
+	void HistoryModel::SetFilter (const QString& filter)
+	{
+		const auto& newFilter = filter.isEmpty () ? QString ("%") : filter;
+		if (newFilter == Filter_)
+			return;
+
+		Filter_ = newFilter;
+
+		for (int i = 0; i < Sections_.size (); ++i)
+		{
+			const auto& section = Sections_.at (i);
+			const bool wasLoaded = !section.Items_.empty () || !section.CanFetchMore_;
+			ClearSection (i);
+			if (wasLoaded)
+				fetchMore (index (i, 0));
+		}
+	}
+
 	void HistoryModel::addItem (QString title, QString url,
 			QDateTime date, QObject *browserWidget)
 	{
@@ -148,9 +347,17 @@ namespace Poshuku
 
 	QList<QMap<QString, QVariant>> HistoryModel::getItemsMap () const
 	{
+		history_items_t items;
+		Core::Instance ().GetStorageBackend ()->LoadHistory (items);
+
 		QList<QMap<QString, QVariant>> result;
-		for (const auto& item : Items_)
+		QSet<QString> urls;
+		for (const auto& item : items)
 		{
+			if (urls.contains (item.URL_))
+				continue;
+			urls << item.URL_;
+
 			QMap<QString, QVariant> map;
 			map ["Title"] = item.Title_;
 			map ["DateTime"] = item.DateTime_;
@@ -160,72 +367,76 @@ namespace Poshuku
 		return result;
 	}
 
-	void HistoryModel::Add (const HistoryItem& histItem, int section)
+	void HistoryModel::RebuildSections ()
 	{
-		while (section >= rowCount ())
+		beginResetModel ();
+
+		Sections_.clear ();
+		SectionsDay_ = QDate::currentDate ();
+
+		const auto& oldest = Core::Instance ().GetStorageBackend ()->GetOldestHistoryDate ();
+		for (int i = 0; ; ++i)
 		{
-			const auto& folderIcon = Core::Instance ().GetProxy ()->
-					GetIconThemeManager ()->GetIcon ("document-open-folder");
+			const auto& bounds = SectionBounds (i, SectionsDay_);
+			Sections_.append ({ bounds.first, bounds.second, {}, true });
 
-			const QList<QStandardItem*> sectItems
-			{
-				new QStandardItem { folderIcon, SectionName (rowCount ()) },
-				new QStandardItem,
-				new QStandardItem
-			};
-			for (const auto item : sectItems)
-				item->setEditable (false);
-
-			appendRow (sectItems);
+			if (!oldest.isValid () || bounds.first <= oldest)
+				break;
 		}
 
-		const auto icon = Core::Instance ().GetIcon (QUrl { histItem.URL_ });
-		auto normalizeText = [] (QString text)
-		{
-			return text.trimmed ().replace ('\n', ' ');
-		};
-		const QList<QStandardItem*> items
+		endResetModel ();
+	}
+
+	void HistoryModel::ClearSection (int row)
+	{
+		auto& section = Sections_ [row];
+		if (!section.Items_.empty ())
 		{
-			new QStandardItem { icon, normalizeText (histItem.Title_) },
-			new QStandardItem { normalizeText (histItem.URL_) },
-			new QStandardItem { QLocale {}.toString (histItem.DateTime_, QLocale::ShortFormat) }
-		};
-		for (const auto item : items)
-			item->setEditable (false);
-		item (section)->appendRow (items);
+			beginRemoveRows (index (row, 0), 0, section.Items_.size () - 1);
+			section.Items_.clear ();
+			endRemoveRows ();
+		}
+		section.CanFetchMore_ = true;
 	}
 
 	void HistoryModel::loadData ()
 	{
 		collectGarbage ();
+		RebuildSections ();
+	}
+
+	void HistoryModel::handleItemAdded (const HistoryItem& item)
+	{
+		if (SectionsDay_ != QDate::currentDate ())
+		{
+			RebuildSections ();
+			return;
+		}
 
-		if (const auto rc = rowCount ())
-			removeRows (0, rc);
+		auto& today = Sections_ [0];
+		if (today.CanFetchMore_ && today.Items_.empty ())
+			return;
+
+		if (Filter_ != "%" &&
+				!MatchesLike (item.Title_, Filter_) &&
+				!MatchesLike (item.URL_, Filter_))
+			return;
 
-		Items_.clear ();
-		Core::Instance ().GetStorageBackend ()->LoadHistory (Items_);
+		const auto& parent = index (0, 0);
 
-		QSet<QString> urls;
-		for (auto i = Items_.begin (); i != Items_.end (); )
+		const auto pos = std::find_if (today.Items_.begin (), today.Items_.end (),
+				[&item] (const HistoryItem& other) { return other.URL_ == item.URL_; });
+		if (pos != today.Items_.end ())
 		{
-			if (urls.contains (i->URL_))
-				i = Items_.erase (i);
-			else
-			{
-				urls << i->URL_;
-				++i;
-			}
+			const int row = std::distance (today.Items_.begin (), pos);
+			beginRemoveRows (parent, row, row);
+			today.Items_.erase (pos);
+			endRemoveRows ();
 		}
 
-		const auto& now = QDateTime::currentDateTime ();
-		for (const auto& item : Items_)
-			Add (item, SectionNumber (item.DateTime_, now));
-	}
-
-	void HistoryModel::handleItemAdded (const HistoryItem& item)
-	{
-		Items_.push_back (item);
-		Add (item, SectionNumber (item.DateTime_));
+		beginInsertRows (parent, 0, 0);
+		today.Items_.prepend (item);
+		endInsertRows ();
 	}
 
 	void HistoryModel::collectGarbage ()
@@ -235,6 +446,9 @@ namespace Poshuku
 		int maxItems = XmlSettingsManager::Instance ()->
 			property ("HistoryKeepLessThan").toInt ();
 		Core::Instance ().GetStorageBackend ()->ClearOldHistory (age, maxItems);
+
+		if (SectionsDay_.isValid () && SectionsDay_ != QDate::currentDate ())
+			RebuildSections ();
 	}
 }
 }
@@ -29,11 +29,9 @@
 
 #pragma once
 
-#include <deque>
-#include <vector>
 #include <QStringList>
 #include <QDateTime>
-#include <QStandardItemModel>
+#include <QAbstractItemModel>
 #include <interfaces/core/ihookproxy.h>
 #include <interfaces/poshuku/poshukutypes.h>
 
@@ -44,12 +42,28 @@ namespace LeechCraft
 {
 namespace Poshuku
 {
-	class HistoryModel : public QStandardItemModel
+	/** Top-level rows are date sections (today, yesterday, ...), their
+		* children are history items. Items of a section are loaded from the
+		* storage backend page by page via canFetchMore()/fetchMore() and
+		* may be dropped via ReleaseSection() once they aren't shown.
+		*/
+	class HistoryModel : public QAbstractItemModel
 	{
 		Q_OBJECT
 
 		QTimer *GarbageTimer_;
-		history_items_t Items_;
+
+		struct Section
+		{
+			QDateTime From_;
+			QDateTime To_;
+			history_items_t Items_;
+			bool CanFetchMore_;
+		};
+		QList<Section> Sections_;
+		QDate SectionsDay_;
+
+		QString Filter_;
 	public:
 		enum Columns
 		{
@@ -59,12 +73,34 @@ namespace Poshuku
 		};
 
 		HistoryModel (QObject* = 0);
+
+		QModelIndex index (int, int, const QModelIndex& = QModelIndex ()) const;
+		QModelIndex parent (const QModelIndex&) const;
+		int rowCount (const QModelIndex& = QModelIndex ()) const;
+		int columnCount (const QModelIndex& = QModelIndex ()) const;
+		bool hasChildren (const QModelIndex& = QModelIndex ()) const;
+		QVariant data (const QModelIndex&, int = Qt::DisplayRole) const;
+		QVariant headerData (int, Qt::Orientation, int = Qt::DisplayRole) const;
+
+		bool canFetchMore (const QModelIndex&) const;
+		void fetchMore (const QModelIndex&);
+
+		/** Drops the loaded items of the given section, so that they are
+			* fetched again next time the section is expanded.
+			*/
+		void ReleaseSection (int);
+
+		/** Sets the SQL LIKE pattern the items' title or URL should match.
+			* Already loaded sections are reloaded with the new filter.
+			*/
+		void SetFilter (const QString&);
 	public slots:
 		void addItem (QString title, QString url,
 				QDateTime datetime, QObject *browserwidget = 0);
 		QList<QMap<QString, QVariant>> getItemsMap () const;
 	private:
-		void Add (const HistoryItem&, int section);
+		void RebuildSections ();
+		void ClearSection (int);
 	private slots:
 		void loadData ();
 		void collectGarbage ();
@@ -29,6 +29,7 @@
 
 #include "historywidget.h"
 #include <QDateTime>
+#include <QScrollBar>
 #include "core.h"
 #include "historymodel.h"
 
@@ -59,6 +60,15 @@ namespace Poshuku
 				this,
 				SLOT (updateHistoryFilter ()));
 
+		connect (Ui_.HistoryView_,
+				SIGNAL (collapsed (const QModelIndex&)),
+				this,
+				SLOT (handleCollapsed (const QModelIndex&)));
+		connect (Ui_.HistoryView_->verticalScrollBar (),
+				SIGNAL (valueChanged (int)),
+				this,
+				SLOT (handleScrolled (int)));
+
 		QHeaderView *itemsHeader = Ui_.HistoryView_->header ();
 		QFontMetrics fm = fontMetrics ();
 		itemsHeader->resizeSection (0,
@@ -83,24 +93,69 @@ namespace Poshuku
 	{
 		int section = Ui_.HistoryFilterType_->currentIndex ();
 		QString text = Ui_.HistoryFilterLine_->text ();
-	
+
+		QRegExp::PatternSyntax syntax = QRegExp::FixedString;
 		switch (section)
 		{
 			case 1:
-				HistoryFilterModel_->setFilterWildcard (text);
+				syntax = QRegExp::Wildcard;
 				break;
 			case 2:
-				HistoryFilterModel_->setFilterRegExp (text);
+				syntax = QRegExp::RegExp;
 				break;
 			default:
-				HistoryFilterModel_->setFilterFixedString (text);
 				break;
 		}
-	
-		HistoryFilterModel_->
-			setFilterCaseSensitivity ((Ui_.HistoryFilterCaseSensitivity_->
+
+		HistoryFilterModel_->SetFilter (text, syntax,
+				(Ui_.HistoryFilterCaseSensitivity_->
 						checkState () == Qt::Checked) ? Qt::CaseSensitive :
 					Qt::CaseInsensitive);
 	}
+
+	void HistoryWidget::handleCollapsed (const QModelIndex& index)
+	{
+		const auto& sourceIdx = HistoryFilterModel_->mapToSource (index);
+		if (sourceIdx.parent ().isValid ())
+			return;
+
+		Core::Instance ().GetHistoryModel ()->ReleaseSection (sourceIdx.row ());
+	}
+
+	void HistoryWidget::handleScrolled (int)
+	{
+		const auto view = Ui_.HistoryView_;
+		auto fetchSection = [this, view] (const QModelIndex& section)
+		{
+			if (view->isExpanded (section) &&
+					HistoryFilterModel_->canFetchMore (section))
+				HistoryFilterModel_->fetchMore (section);
+		};
+
+		// Fetch more for the section shown at the bottom of the view,
+		// once its last loaded items become visible.
+		const auto& bottom = view->indexAt ({ 1, view->viewport ()->height () - 1 });
+		if (bottom.isValid ())
+		{
+			const auto& section = bottom.parent ().isValid () ? bottom.parent () : bottom;
+			const auto threshold = 20;
+			if (section == bottom ||
+					bottom.row () >= HistoryFilterModel_->rowCount (section) - threshold)
+				fetchSection (section);
+			return;
+		}
+
+		// The items don't fill the whole view, so the last expanded
+		// section is the one that may need more items.
+		for (int i = HistoryFilterModel_->rowCount () - 1; i >= 0; --i)
+		{
+			const auto& index = HistoryFilterModel_->index (i, 0);
+			if (!view->isExpanded (index))
+				continue;
+
+			fetchSection (index);
+			break;
+		}
+	}
 }
 }
@@ -49,6 +49,8 @@ namespace Poshuku
 	private slots:
 		void on_HistoryView__activated (const QModelIndex&);
 		void updateHistoryFilter ();
+		void handleCollapsed (const QModelIndex&);
+		void handleScrolled (int);
 	};
 }
 }
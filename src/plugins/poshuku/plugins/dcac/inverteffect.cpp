@@ -31,6 +31,7 @@
 #include <QPainter>
 #include <QtDebug>
 #include <qwebview.h>
+#include "invertrow.h"
 
 namespace LeechCraft
 {
@@ -56,6 +57,8 @@ namespace DCAC
 	{
 		QPoint offset;
 
+		// The widget source is grabbed anew on each draw, since it's only
+		// redrawn when its contents change, so there is nothing to cache.
 		const auto& sourcePx = sourcePixmap (Qt::LogicalCoordinates, &offset, QGraphicsEffect::NoPad);
 		auto image = sourcePx.toImage ();
 		switch (image.format ())
@@ -67,28 +70,18 @@ namespace DCAC
 			image = image.convertToFormat (QImage::Format_ARGB32);
 			break;
 		}
-		image.detach ();
 
-		uint64_t sourceGraySumR = 0, sourceGraySumG = 0, sourceGraySumB = 0;
+		ChannelSums sums;
 
 		const auto height = image.height ();
 		const auto width = image.width ();
 		for (int y = 0; y < height; ++y)
-		{
-			const auto scanline = reinterpret_cast<QRgb*> (image.scanLine (y));
-			for (int x = 0; x < width; ++x)
-			{
-				auto& color = scanline [x];
-				sourceGraySumR += qRed (color);
-				sourceGraySumG += qGreen (color);
-				sourceGraySumB += qBlue (color);
-
-				color &= 0x00ffffff;
-				color = uint32_t { 0xffffffff } - color;
-			}
-		}
+			InvertRow (reinterpret_cast<QRgb*> (image.scanLine (y)), width, sums);
 
-		const auto sourceGraySum = (sourceGraySumR * 11 + sourceGraySumG * 16 + sourceGraySumB * 5) / (width * height * 32);
+		const auto pixelsCount = static_cast<uint64_t> (width) * height;
+		const auto sourceGraySum = pixelsCount ?
+				(sums.R_ * 11 + sums.G_ * 16 + sums.B_ * 5) / (pixelsCount * 32) :
+				0;
 
 		if (sourceGraySum >= static_cast<uint64_t> (Threshold_))
 			painter->drawImage (offset, image);
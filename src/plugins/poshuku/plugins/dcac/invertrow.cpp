@@ -0,0 +1,174 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "invertrow.h"
+
+#if defined (__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined (__GNUC__) && (defined (__x86_64__) || defined (__i386__))
+#include <immintrin.h>
+#define DCAC_HAS_AVX2
+#endif
+
+namespace LeechCraft
+{
+namespace Poshuku
+{
+namespace DCAC
+{
+	void InvertRowScalar (QRgb *pixels, int count, ChannelSums& sums)
+	{
+		for (int i = 0; i < count; ++i)
+		{
+			auto& color = pixels [i];
+			sums.R_ += qRed (color);
+			sums.G_ += qGreen (color);
+			sums.B_ += qBlue (color);
+
+			color = (color | 0xff000000) ^ 0x00ffffff;
+		}
+	}
+
+	namespace
+	{
+		/* The vector kernels below do the same as InvertRowScalar() for
+		 * the longest prefix of the row fitting into whole vectors and
+		 * return the length of that prefix.
+		 */
+#if defined (__SSE2__)
+		uint64_t HSum64 (__m128i vec)
+		{
+			return static_cast<uint64_t> (_mm_cvtsi128_si32 (vec)) +
+					static_cast<uint64_t> (_mm_cvtsi128_si32 (_mm_srli_si128 (vec, 8)));
+		}
+
+		int InvertSSE2 (QRgb *pixels, int count, ChannelSums& sums)
+		{
+			const auto byteMask = _mm_set1_epi32 (0xff);
+			const auto alphaMask = _mm_set1_epi32 (0xff000000);
+			const auto rgbMask = _mm_set1_epi32 (0x00ffffff);
+			const auto zero = _mm_setzero_si128 ();
+
+			auto sumR = _mm_setzero_si128 ();
+			auto sumG = _mm_setzero_si128 ();
+			auto sumB = _mm_setzero_si128 ();
+
+			int i = 0;
+			for (; i + 4 <= count; i += 4)
+			{
+				const auto ptr = reinterpret_cast<__m128i*> (pixels + i);
+				const auto px = _mm_loadu_si128 (ptr);
+
+				// Each channel is isolated into the low byte of its 32-bit
+				// lane, and _mm_sad_epu8 sums the bytes of each 64-bit half.
+				sumB = _mm_add_epi64 (sumB, _mm_sad_epu8 (_mm_and_si128 (px, byteMask), zero));
+				sumG = _mm_add_epi64 (sumG,
+						_mm_sad_epu8 (_mm_and_si128 (_mm_srli_epi32 (px, 8), byteMask), zero));
+				sumR = _mm_add_epi64 (sumR,
+						_mm_sad_epu8 (_mm_and_si128 (_mm_srli_epi32 (px, 16), byteMask), zero));
+
+				_mm_storeu_si128 (ptr, _mm_xor_si128 (_mm_or_si128 (px, alphaMask), rgbMask));
+			}
+
+			sums.R_ += HSum64 (sumR);
+			sums.G_ += HSum64 (sumG);
+			sums.B_ += HSum64 (sumB);
+
+			return i;
+		}
+#endif
+
+#ifdef DCAC_HAS_AVX2
+		__attribute__ ((target ("avx2")))
+		uint64_t HSum64 (__m256i vec)
+		{
+			alignas (32) uint64_t lanes [4];
+			_mm256_store_si256 (reinterpret_cast<__m256i*> (lanes), vec);
+			return lanes [0] + lanes [1] + lanes [2] + lanes [3];
+		}
+
+		__attribute__ ((target ("avx2")))
+		int InvertAVX2 (QRgb *pixels, int count, ChannelSums& sums)
+		{
+			const auto byteMask = _mm256_set1_epi32 (0xff);
+			const auto alphaMask = _mm256_set1_epi32 (0xff000000);
+			const auto rgbMask = _mm256_set1_epi32 (0x00ffffff);
+			const auto zero = _mm256_setzero_si256 ();
+
+			auto sumR = _mm256_setzero_si256 ();
+			auto sumG = _mm256_setzero_si256 ();
+			auto sumB = _mm256_setzero_si256 ();
+
+			int i = 0;
+			for (; i + 8 <= count; i += 8)
+			{
+				const auto ptr = reinterpret_cast<__m256i*> (pixels + i);
+				const auto px = _mm256_loadu_si256 (ptr);
+
+				sumB = _mm256_add_epi64 (sumB, _mm256_sad_epu8 (_mm256_and_si256 (px, byteMask), zero));
+				sumG = _mm256_add_epi64 (sumG,
+						_mm256_sad_epu8 (_mm256_and_si256 (_mm256_srli_epi32 (px, 8), byteMask), zero));
+				sumR = _mm256_add_epi64 (sumR,
+						_mm256_sad_epu8 (_mm256_and_si256 (_mm256_srli_epi32 (px, 16), byteMask), zero));
+
+				_mm256_storeu_si256 (ptr, _mm256_xor_si256 (_mm256_or_si256 (px, alphaMask), rgbMask));
+			}
+
+			sums.R_ += HSum64 (sumR);
+			sums.G_ += HSum64 (sumG);
+			sums.B_ += HSum64 (sumB);
+
+			return i;
+		}
+
+		bool HasAVX2 ()
+		{
+			static const bool hasAvx2 = __builtin_cpu_supports ("avx2");
+			return hasAvx2;
+		}
+#endif
+	}
+
+	void InvertRow (QRgb *pixels, int count, ChannelSums& sums)
+	{
+		int processed = 0;
+#ifdef DCAC_HAS_AVX2
+		if (HasAVX2 ())
+			processed = InvertAVX2 (pixels, count, sums);
+#endif
+#if defined (__SSE2__)
+		processed += InvertSSE2 (pixels + processed, count - processed, sums);
+#endif
+		InvertRowScalar (pixels + processed, count - processed, sums);
+	}
+}
+}
+}
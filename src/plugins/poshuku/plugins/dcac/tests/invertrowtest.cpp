@@ -0,0 +1,125 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "invertrowtest.h"
+#include <cstdlib>
+#include <QtTest>
+#include <QVector>
+#include "../invertrow.h"
+
+QTEST_MAIN (LeechCraft::Poshuku::DCAC::InvertRowTest)
+
+namespace LeechCraft
+{
+namespace Poshuku
+{
+namespace DCAC
+{
+	namespace
+	{
+		QVector<QRgb> MakeRow (int size)
+		{
+			QVector<QRgb> row (size);
+			for (auto& px : row)
+				px = (static_cast<QRgb> (qrand ()) << 16) ^ qrand ();
+			return row;
+		}
+
+		// A 1080p frame, the typical size of a web view.
+		const int FrameSize = 1920 * 1080;
+	}
+
+	void InvertRowTest::testEmptyRow ()
+	{
+		ChannelSums sums;
+		InvertRow (nullptr, 0, sums);
+		QCOMPARE (sums.R_ + sums.G_ + sums.B_, uint64_t { 0 });
+	}
+
+	void InvertRowTest::testMatchesScalar ()
+	{
+		// Covers the vector bodies along with all the tail lengths.
+		for (int size = 1; size < 100; ++size)
+		{
+			auto row = MakeRow (size);
+			auto reference = row;
+
+			ChannelSums sums;
+			InvertRow (row.data (), row.size (), sums);
+
+			ChannelSums refSums;
+			InvertRowScalar (reference.data (), reference.size (), refSums);
+
+			QCOMPARE (row, reference);
+			QCOMPARE (sums.R_, refSums.R_);
+			QCOMPARE (sums.G_, refSums.G_);
+			QCOMPARE (sums.B_, refSums.B_);
+		}
+	}
+
+	void InvertRowTest::testKnownValues ()
+	{
+		QVector<QRgb> row { 0x00000000, 0xffffffff, 0x80102030, 0x7fabcdef, 0, 0, 0, 0, 0 };
+
+		ChannelSums sums;
+		InvertRow (row.data (), row.size (), sums);
+
+		QCOMPARE (row [0], QRgb { 0xffffffff });
+		QCOMPARE (row [1], QRgb { 0xff000000 });
+		QCOMPARE (row [2], QRgb { 0xffefdfcf });
+		QCOMPARE (row [3], QRgb { 0xff543210 });
+		QCOMPARE (row [8], QRgb { 0xffffffff });
+
+		QCOMPARE (sums.R_, uint64_t { 0xff + 0x10 + 0xab });
+		QCOMPARE (sums.G_, uint64_t { 0xff + 0x20 + 0xcd });
+		QCOMPARE (sums.B_, uint64_t { 0xff + 0x30 + 0xef });
+	}
+
+	void InvertRowTest::benchScalar ()
+	{
+		auto frame = MakeRow (FrameSize);
+		ChannelSums sums;
+		QBENCHMARK
+		{
+			InvertRowScalar (frame.data (), frame.size (), sums);
+		}
+	}
+
+	void InvertRowTest::benchInvertRow ()
+	{
+		auto frame = MakeRow (FrameSize);
+		ChannelSums sums;
+		QBENCHMARK
+		{
+			InvertRow (frame.data (), frame.size (), sums);
+		}
+	}
+}
+}
+}
@@ -49,14 +49,6 @@ namespace Poshuku
 {
 namespace FatApe
 {
-	template<typename Iter, typename Pred, typename Func>
-	void apply_if (Iter first, Iter last, Pred pred, Func func)
-	{
-		for (; first != last; ++first)
-			if (pred (*first))
-				func (*first);
-	}
-
 	void WrapText (QString& text, int width = 80)
 	{
 		int curWidth = width;
@@ -89,6 +81,7 @@ namespace FatApe
 
 		Q_FOREACH (const QString& script, scriptsDir.entryList (filter, QDir::Files))
 			UserScripts_.append (UserScript (scriptsDir.absoluteFilePath (script)));
+		Matcher_.Rebuild (UserScripts_);
 
 		Model_.reset (new QStandardItemModel);
 		Model_->setHorizontalHeaderLabels (QStringList (tr ("Name"))
@@ -147,10 +140,8 @@ namespace FatApe
 	void Plugin::hookInitialLayoutCompleted (LeechCraft::IHookProxy_ptr,
 			QWebPage*, QWebFrame *frame)
 	{
-		auto match = [frame] (const UserScript& us) { return us.MatchToPage (frame->url ().toString ()); };
-		auto inject = [frame, this] (const UserScript& us) { us.Inject (frame, Proxy_); };
-
-		apply_if (UserScripts_.begin (), UserScripts_.end (), match, inject);
+		for (const auto idx : Matcher_.Match (frame->url ()))
+			UserScripts_.at (idx).Inject (frame, Proxy_);
 	}
 
 	void Plugin::initPlugin (QObject *proxy)
@@ -183,6 +174,7 @@ namespace FatApe
 	{
 		UserScripts_ [scriptIndex].Delete ();
 		UserScripts_.removeAt (scriptIndex);
+		Matcher_.Rebuild (UserScripts_);
 	}
 
 	void Plugin::SetScriptEnabled (int scriptIndex, bool value)
@@ -206,6 +198,7 @@ namespace FatApe
 			UserScripts_.append (UserScript (installer.TempScriptPath ()));
 			UserScripts_.last ().Install (CoreProxy_->GetNetworkAccessManager ());
 			AddScriptToManager (UserScripts_.last ());
+			Matcher_.Rebuild (UserScripts_);
 			break;
 		case UserScriptInstallerDialog::ShowSource:
 			Proxy_->OpenInNewTab (QUrl::fromLocalFile (installer.TempScriptPath ()));
@@ -30,6 +30,7 @@
 #ifndef PLUGINS_POSHUKU_PLUGINS_FATAPE_FATAPE_H
 #define PLUGINS_POSHUKU_PLUGINS_FATAPE_FATAPE_H
 #include "userscript.h"
+#include "scriptsmatcher.h"
 #include <QObject>
 #include <QList>
 #include <QStandardItemModel>
@@ -59,6 +60,7 @@ namespace FatApe
 
 		std::shared_ptr<QTranslator> Translator_;
 		QList<UserScript> UserScripts_;
+		ScriptsMatcher Matcher_;
 		IProxyObject *Proxy_;
 		ICoreProxy_ptr CoreProxy_;
 		Util::XmlSettingsDialog_ptr SettingsDialog_;
@@ -0,0 +1,168 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "scriptsmatcher.h"
+#include <algorithm>
+#include <QUrl>
+#include "userscript.h"
+
+namespace LeechCraft
+{
+namespace Poshuku
+{
+namespace FatApe
+{
+	namespace
+	{
+		const int MaxCachedHosts = 512;
+
+		QList<QRegExp> Compile (const QStringList& patterns)
+		{
+			QList<QRegExp> result;
+			for (const auto& pattern : patterns)
+				result << QRegExp (pattern, Qt::CaseInsensitive, QRegExp::Wildcard);
+			return result;
+		}
+
+		/** Returns the lowercased host the pattern is restricted to, or a
+			* null string if the pattern may match URLs on any host.
+			*
+			* Since wildcards may span across the host/path boundary, only
+			* hosts without any special characters are considered literal.
+			*/
+		QString GetLiteralHost (const QString& pattern)
+		{
+			const auto schemeEnd = pattern.indexOf ("://");
+			if (schemeEnd <= 0)
+				return {};
+
+			const auto& scheme = pattern.left (schemeEnd);
+			if (scheme.contains (QRegExp ("[*?\\[]")))
+				return {};
+
+			const auto hostStart = schemeEnd + 3;
+			const auto hostEnd = pattern.indexOf ('/', hostStart);
+			if (hostEnd == -1)
+				return {};
+
+			const auto& host = pattern.mid (hostStart, hostEnd - hostStart);
+			if (host.isEmpty () || host.contains (QRegExp ("[*?\\[\\]:@]")))
+				return {};
+
+			return host.toLower ();
+		}
+	}
+
+	void ScriptsMatcher::Rebuild (const QList<UserScript>& scripts)
+	{
+		Scripts_.clear ();
+		HostCandidates_.clear ();
+
+		for (const auto& script : scripts)
+		{
+			const auto& include = script.Include ();
+
+			CompiledScript compiled
+			{
+				Compile (include),
+				Compile (script.Exclude ()),
+				false,
+				{}
+			};
+
+			for (const auto& pattern : include)
+			{
+				const auto& host = GetLiteralHost (pattern);
+				if (host.isNull ())
+				{
+					compiled.AnyHost_ = true;
+					compiled.Hosts_.clear ();
+					break;
+				}
+
+				compiled.Hosts_ << host;
+			}
+
+			Scripts_ << compiled;
+		}
+	}
+
+	QList<int> ScriptsMatcher::Match (const QUrl& url) const
+	{
+		const auto& urlStr = url.toString ();
+		auto match = [&urlStr] (const QRegExp& rx)
+				{ return rx.indexIn (urlStr, 0, QRegExp::CaretAtZero) != -1; };
+
+		auto matchScript = [&match] (const CompiledScript& script)
+		{
+			return std::any_of (script.Include_.begin (), script.Include_.end (), match) &&
+					!std::any_of (script.Exclude_.begin (), script.Exclude_.end (), match);
+		};
+
+		QList<int> result;
+
+		// The patterns aren't anchored, so a literal host pattern also
+		// matches an URL embedded later in this one, like in a query.
+		const auto schemeEnd = urlStr.indexOf ("://");
+		if (schemeEnd != -1 && urlStr.indexOf ("://", schemeEnd + 3) != -1)
+		{
+			for (int i = 0; i < Scripts_.size (); ++i)
+				if (matchScript (Scripts_.at (i)))
+					result << i;
+			return result;
+		}
+
+		for (const auto idx : GetCandidates (url.host ().toLower ()))
+			if (matchScript (Scripts_.at (idx)))
+				result << idx;
+		return result;
+	}
+
+	const QList<int>& ScriptsMatcher::GetCandidates (const QString& host) const
+	{
+		const auto pos = HostCandidates_.constFind (host);
+		if (pos != HostCandidates_.constEnd ())
+			return *pos;
+
+		if (HostCandidates_.size () >= MaxCachedHosts)
+			HostCandidates_.clear ();
+
+		QList<int> candidates;
+		for (int i = 0; i < Scripts_.size (); ++i)
+		{
+			const auto& script = Scripts_.at (i);
+			if (script.AnyHost_ || script.Hosts_.contains (host))
+				candidates << i;
+		}
+
+		return *HostCandidates_.insert (host, candidates);
+	}
+}
+}
+}
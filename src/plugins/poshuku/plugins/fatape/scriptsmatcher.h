@@ -0,0 +1,81 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QRegExp>
+#include <QStringList>
+
+class QUrl;
+
+namespace LeechCraft
+{
+namespace Poshuku
+{
+namespace FatApe
+{
+	class UserScript;
+
+	/** Keeps the include/exclude patterns of all the user scripts
+		* compiled and returns the indexes of the scripts matching a given
+		* page URL.
+		*
+		* Scripts whose include patterns all name a literal host are only
+		* checked for pages on those hosts; the list of such candidate
+		* scripts is cached per host.
+		*
+		* Like UserScript::MatchToPage(), the patterns match anywhere in
+		* the URL, so a page whose URL has another URL embedded in it
+		* (for example, in the query) is checked against all the scripts.
+		*/
+	class ScriptsMatcher
+	{
+		struct CompiledScript
+		{
+			QList<QRegExp> Include_;
+			QList<QRegExp> Exclude_;
+
+			bool AnyHost_;
+			QStringList Hosts_;
+		};
+		QList<CompiledScript> Scripts_;
+
+		mutable QHash<QString, QList<int>> HostCandidates_;
+	public:
+		void Rebuild (const QList<UserScript>&);
+
+		QList<int> Match (const QUrl&) const;
+	private:
+		const QList<int>& GetCandidates (const QString&) const;
+	};
+}
+}
+}
@@ -177,6 +177,44 @@ namespace Poshuku
 				break;
 		}
 
+		HistoryRangeLoader_ = QSqlQuery (DB_);
+		switch (Type_)
+		{
+			case SBSQLite:
+				HistoryRangeLoader_.prepare ("SELECT "
+						"title, "
+						"MAX (date) AS maxdate, "
+						"url "
+						"FROM history "
+						"WHERE date >= :from AND date < :to "
+						"AND ( ( title LIKE :titlebase ESCAPE '!' ) "
+						"OR ( url LIKE :urlbase ESCAPE '!' ) ) "
+						"GROUP BY url "
+						"ORDER BY maxdate DESC "
+						"LIMIT :limit OFFSET :offset");
+				break;
+			case SBPostgres:
+				HistoryRangeLoader_.prepare ("SELECT "
+						"MAX (title) AS title, "
+						"MAX (date) AS maxdate, "
+						"url "
+						"FROM history "
+						"WHERE date >= :from AND date < :to "
+						"AND ( ( title ILIKE :titlebase ESCAPE '!' ) "
+						"OR ( url ILIKE :urlbase ESCAPE '!' ) ) "
+						"GROUP BY url "
+						"ORDER BY maxdate DESC "
+						"LIMIT :limit OFFSET :offset");
+				break;
+			case SBMysql:
+				qWarning () << Q_FUNC_INFO
+						<< "it's not MySQL";
+				break;
+		}
+
+		OldestHistoryDateLoader_ = QSqlQuery (DB_);
+		OldestHistoryDateLoader_.prepare ("SELECT MIN (date) FROM history");
+
 		HistoryAdder_ = QSqlQuery (DB_);
 		HistoryAdder_.prepare ("INSERT INTO history ("
 				"date, "
@@ -312,6 +350,11 @@ namespace Poshuku
 		HistoryLoader_.finish ();
 	}
 
+	void SQLStorageBackend::LoadHistoryConcurrently (history_items_t& items) const
+	{
+		LoadHistoryFromClone (DB_, items);
+	}
+
 	void SQLStorageBackend::LoadResemblingHistory (const QString& base,
 			history_items_t& items) const
 	{
@@ -339,6 +382,49 @@ namespace Poshuku
 		HistoryRatedLoader_.finish ();
 	}
 
+	void SQLStorageBackend::LoadHistoryRange (const QDateTime& from, const QDateTime& to,
+			const QString& filter, int offset, int limit, history_items_t& items) const
+	{
+		HistoryRangeLoader_.bindValue (":from", from);
+		HistoryRangeLoader_.bindValue (":to", to);
+		HistoryRangeLoader_.bindValue (":titlebase", filter);
+		HistoryRangeLoader_.bindValue (":urlbase", filter);
+		HistoryRangeLoader_.bindValue (":limit", limit);
+		HistoryRangeLoader_.bindValue (":offset", offset);
+		if (!HistoryRangeLoader_.exec ())
+		{
+			LeechCraft::Util::DBLock::DumpError (HistoryRangeLoader_);
+			return;
+		}
+
+		while (HistoryRangeLoader_.next ())
+		{
+			HistoryItem item =
+			{
+				HistoryRangeLoader_.value (0).toString (),
+				HistoryRangeLoader_.value (1).toDateTime (),
+				HistoryRangeLoader_.value (2).toString ()
+			};
+			items.push_back (item);
+		}
+		HistoryRangeLoader_.finish ();
+	}
+
+	QDateTime SQLStorageBackend::GetOldestHistoryDate () const
+	{
+		if (!OldestHistoryDateLoader_.exec ())
+		{
+			LeechCraft::Util::DBLock::DumpError (OldestHistoryDateLoader_);
+			return QDateTime ();
+		}
+
+		QDateTime result;
+		if (OldestHistoryDateLoader_.next ())
+			result = OldestHistoryDateLoader_.value (0).toDateTime ();
+		OldestHistoryDateLoader_.finish ();
+		return result;
+	}
+
 	void SQLStorageBackend::AddToHistory (const HistoryItem& item)
 	{
 		HistoryAdder_.bindValue (":title", item.Title_);
@@ -98,6 +98,22 @@ namespace Poshuku
 				"ORDER BY rating ASC "
 				"LIMIT 100");
 
+		HistoryRangeLoader_ = QSqlQuery (DB_);
+		HistoryRangeLoader_.prepare ("SELECT "
+				"MAX(title) AS title, "
+				"MAX(date) AS maxdate, "
+				"url "
+				"FROM history "
+				"WHERE date >= ? AND date < ? "
+				"AND ( ( title LIKE ? ESCAPE '!' ) "
+				"OR ( url LIKE ? ESCAPE '!' ) ) "
+				"GROUP BY url "
+				"ORDER BY maxdate DESC "
+				"LIMIT ? OFFSET ?");
+
+		OldestHistoryDateLoader_ = QSqlQuery (DB_);
+		OldestHistoryDateLoader_.prepare ("SELECT MIN(date) FROM history");
+
 		HistoryAdder_ = QSqlQuery (DB_);
 		HistoryAdder_.prepare ("INSERT INTO history ("
 				"date, "
@@ -188,6 +204,11 @@ namespace Poshuku
 		HistoryLoader_.finish ();
 	}
 
+	void SQLStorageBackendMysql::LoadHistoryConcurrently (history_items_t& items) const
+	{
+		LoadHistoryFromClone (DB_, items);
+	}
+
 	void SQLStorageBackendMysql::LoadResemblingHistory (const QString& base,
 			history_items_t& items) const
 	{
@@ -215,6 +236,49 @@ namespace Poshuku
 		HistoryRatedLoader_.finish ();
 	}
 
+	void SQLStorageBackendMysql::LoadHistoryRange (const QDateTime& from, const QDateTime& to,
+			const QString& filter, int offset, int limit, history_items_t& items) const
+	{
+		HistoryRangeLoader_.bindValue (0, from);
+		HistoryRangeLoader_.bindValue (1, to);
+		HistoryRangeLoader_.bindValue (2, filter);
+		HistoryRangeLoader_.bindValue (3, filter);
+		HistoryRangeLoader_.bindValue (4, limit);
+		HistoryRangeLoader_.bindValue (5, offset);
+		if (!HistoryRangeLoader_.exec ())
+		{
+			LeechCraft::Util::DBLock::DumpError (HistoryRangeLoader_);
+			return;
+		}
+
+		while (HistoryRangeLoader_.next ())
+		{
+			HistoryItem item =
+			{
+				HistoryRangeLoader_.value (0).toString (),
+				HistoryRangeLoader_.value (1).toDateTime (),
+				HistoryRangeLoader_.value (2).toString ()
+			};
+			items.push_back (item);
+		}
+		HistoryRangeLoader_.finish ();
+	}
+
+	QDateTime SQLStorageBackendMysql::GetOldestHistoryDate () const
+	{
+		if (!OldestHistoryDateLoader_.exec ())
+		{
+			LeechCraft::Util::DBLock::DumpError (OldestHistoryDateLoader_);
+			return QDateTime ();
+		}
+
+		QDateTime result;
+		if (OldestHistoryDateLoader_.next ())
+			result = OldestHistoryDateLoader_.value (0).toDateTime ();
+		OldestHistoryDateLoader_.finish ();
+		return result;
+	}
+
 	void SQLStorageBackendMysql::AddToHistory (const HistoryItem& item)
 	{
 		HistoryAdder_.bindValue (0, item.Title_);
@@ -59,6 +59,24 @@ namespace Poshuku
 					* - url
 					*/
 				HistoryRatedLoader_,
+				/** Binds:
+					* - from
+					* - to
+					* - titlebase
+					* - urlbase
+					* - limit
+					* - offset
+					*
+					* Returns:
+					* - title
+					* - date
+					* - url
+					*/
+				HistoryRangeLoader_,
+				/** Returns:
+					* - date
+					*/
+				OldestHistoryDateLoader_,
 				/** Binds:
 					* - date
 					* - title
@@ -114,8 +132,12 @@ namespace Poshuku
 		void Prepare ();
 
 		virtual void LoadHistory (history_items_t&) const;
+		virtual void LoadHistoryConcurrently (history_items_t&) const;
 		virtual void LoadResemblingHistory (const QString&,
 				history_items_t&) const;
+		virtual void LoadHistoryRange (const QDateTime&, const QDateTime&,
+				const QString&, int, int, history_items_t&) const;
+		virtual QDateTime GetOldestHistoryDate () const;
 		virtual void AddToHistory (const HistoryItem&);
 		virtual void ClearOldHistory (int, int);
 		virtual void LoadFavorites (FavoritesModel::items_t&) const;
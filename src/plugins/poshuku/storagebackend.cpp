@@ -29,6 +29,12 @@
 
 #include "storagebackend.h"
 #include <stdexcept>
+#include <QThread>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <util/db/dblock.h>
+#include <util/util.h>
 #include "sqlstoragebackend.h"
 #include "sqlstoragebackend_mysql.h"
 #include "xmlsettingsmanager.h"
@@ -46,6 +52,54 @@ namespace Poshuku
 	{
 	}
 
+	void StorageBackend::LoadHistoryFromClone (const QSqlDatabase& origDB, history_items_t& items)
+	{
+		const auto& connName = QString ("PoshukuHistoryReader_%1")
+				.arg (Util::Handle2Num (QThread::currentThreadId ()));
+
+		QString error;
+		{
+			auto db = QSqlDatabase::cloneDatabase (origDB, connName);
+			if (db.open ())
+			{
+				QSqlQuery query (db);
+				if (query.exec ("SELECT "
+							"title, "
+							"date, "
+							"url "
+							"FROM history "
+							"ORDER BY date DESC"))
+				{
+					while (query.next ())
+					{
+						HistoryItem item =
+						{
+							query.value (0).toString (),
+							query.value (1).toDateTime (),
+							query.value (2).toString ()
+						};
+						items.push_back (item);
+					}
+				}
+				else
+				{
+					Util::DBLock::DumpError (query);
+					error = "Could not load history: " + query.lastError ().text ();
+				}
+			}
+			else
+			{
+				Util::DBLock::DumpError (db.lastError ());
+				error = "Could not open history reader connection: " + db.lastError ().text ();
+			}
+		}
+
+		QSqlDatabase::removeDatabase (connName);
+
+		if (!error.isEmpty ())
+			throw std::runtime_error (qPrintable (error));
+	}
+
 	std::shared_ptr<StorageBackend> StorageBackend::Create (Type type)
 	{
 		std::shared_ptr<StorageBackend> result;
@@ -36,6 +36,8 @@
 #include "favoritesmodel.h"
 #include "pageformsdata.h"
 
+class QSqlDatabase;
+
 namespace LeechCraft
 {
 namespace Poshuku
@@ -50,6 +52,8 @@ namespace Poshuku
 	{
 		Q_OBJECT
 		Q_INTERFACES (LeechCraft::Poshuku::IStorageBackend)
+	protected:
+		static void LoadHistoryFromClone (const QSqlDatabase&, history_items_t&);
 	public:
 		enum Type
 		{
@@ -85,6 +89,48 @@ namespace Poshuku
 		virtual void LoadResemblingHistory (const QString& base,
 				history_items_t& items) const = 0;
 
+		/** @brief Get a page of history items from the given time range.
+			*
+			* Puts history items whose date lies in [from; to) into the passed
+			* container. Items are grouped by URL, each URL appearing once with
+			* the date of its latest visit, and sorted by that date in
+			* descending order. Only items whose title or URL matches the
+			* filter pattern are returned.
+			*
+			* @param[in] from The beginning of the range, inclusive.
+			* @param[in] to The end of the range, exclusive.
+			* @param[in] filter The SQL LIKE pattern, "%" matches everything.
+			* The "!" character escapes the following "%", "_" or "!".
+			* @param[in] offset How much items should be skipped.
+			* @param[in] limit How much items should be loaded at most.
+			* @param[out] items The container with items. They would be
+			* appended to the container.
+			*/
+		virtual void LoadHistoryRange (const QDateTime& from, const QDateTime& to,
+				const QString& filter, int offset, int limit,
+				history_items_t& items) const = 0;
+
+		/** @brief Get all history items using a separate connection.
+			*
+			* This function is similar to LoadHistory(), but it opens a
+			* new database connection for the calling thread and thus may
+			* be called from any thread.
+			*
+			* @param[out] items The container with items. They would be
+			* appended to the container.
+			*
+			* @exception std::runtime_error If the connection can't be
+			* opened or the history can't be loaded.
+			*/
+		virtual void LoadHistoryConcurrently (history_items_t& items) const = 0;
+
+		/** @brief Returns the date of the oldest history item.
+			*
+			* @return The date of the oldest item or null QDateTime if the
+			* history is empty.
+			*/
+		virtual QDateTime GetOldestHistoryDate () const = 0;
+
 		/** @brief Add an item to history.
 			*
 			* Adds the passed item to the storage and emits the added() signal
@@ -0,0 +1,292 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "urlcompletionindex.h"
+#include <algorithm>
+#include <QSet>
+#include <QStringList>
+
+namespace LeechCraft
+{
+namespace Poshuku
+{
+	namespace
+	{
+		QStringList GetWords (const QString& text)
+		{
+			QStringList result;
+
+			const auto size = text.size ();
+			int start = -1;
+			for (int i = 0; i <= size; ++i)
+			{
+				const bool isWordChar = i < size && text.at (i).isLetterOrNumber ();
+				if (isWordChar && start < 0)
+					start = i;
+				else if (!isWordChar && start >= 0)
+				{
+					result << text.mid (start, i - start).toLower ();
+					start = -1;
+				}
+			}
+
+			return result;
+		}
+
+		bool IsStopWord (const QString& word)
+		{
+			// These are present in almost every URL and would only make
+			// the posting lists huge.
+			return word == "http" || word == "https" || word == "www";
+		}
+
+		QSet<quint64> GetTrigrams (const QString& text)
+		{
+			// Case folding is what QString::contains() uses for
+			// Qt::CaseInsensitive.
+			const auto& folded = text.toCaseFolded ();
+
+			QSet<quint64> result;
+			for (int i = 0; i + 3 <= folded.size (); ++i)
+				result << ((static_cast<quint64> (folded.at (i).unicode ()) << 32) |
+						(static_cast<quint64> (folded.at (i + 1).unicode ()) << 16) |
+						folded.at (i + 2).unicode ());
+			return result;
+		}
+
+		double GetVisitWeight (const QDateTime& date, const QDateTime& now)
+		{
+			const auto days = date.daysTo (now);
+			if (days <= 4)
+				return 100;
+			else if (days <= 14)
+				return 70;
+			else if (days <= 31)
+				return 50;
+			else if (days <= 90)
+				return 30;
+			else
+				return 10;
+		}
+	}
+
+	URLCompletionIndex_ptr URLCompletionIndex::Build (const history_items_t& items)
+	{
+		const auto& index = std::make_shared<URLCompletionIndex> ();
+
+		const auto& now = QDateTime::currentDateTime ();
+		for (const auto& item : items)
+			index->AddVisit (item, now);
+
+		return index;
+	}
+
+	void URLCompletionIndex::AddVisit (const HistoryItem& item)
+	{
+		AddVisit (item, QDateTime::currentDateTime ());
+	}
+
+	history_items_t URLCompletionIndex::Query (const QString& origBase, int limit) const
+	{
+		const auto& base = origBase.trimmed ();
+		if (base.isEmpty ())
+			return {};
+
+		const auto& allWords = GetWords (base);
+		const bool isSingleTerm = !base.contains (' ');
+		auto matches = [&base, &allWords, isSingleTerm] (const Entry& entry) -> bool
+		{
+			auto contains = [&entry] (const QString& str)
+			{
+				return entry.URL_.contains (str, Qt::CaseInsensitive) ||
+						entry.Title_.contains (str, Qt::CaseInsensitive);
+			};
+
+			if (isSingleTerm)
+				return contains (base);
+
+			return std::all_of (allWords.begin (), allWords.end (), contains);
+		};
+
+		QString driver;
+		for (const auto& word : allWords)
+			if (!IsStopWord (word) && word.size () > driver.size ())
+				driver = word;
+
+		QVector<quint32> prefixHits;
+		if (!driver.isEmpty ())
+		{
+			for (auto i = Words_.lowerBound (driver);
+					i != Words_.end () && i.key ().startsWith (driver); ++i)
+				prefixHits += *i;
+
+			std::sort (prefixHits.begin (), prefixHits.end ());
+			prefixHits.erase (std::unique (prefixHits.begin (), prefixHits.end ()), prefixHits.end ());
+			prefixHits.erase (std::remove_if (prefixHits.begin (), prefixHits.end (),
+						[this, &matches] (quint32 id) { return !matches (Entries_.at (id)); }),
+					prefixHits.end ());
+		}
+
+		history_items_t result;
+		auto appendBest = [this, &result, limit] (QVector<quint32> candidates)
+		{
+			const auto count = std::min (limit - static_cast<int> (result.size ()), candidates.size ());
+			if (count <= 0)
+				return;
+
+			std::partial_sort (candidates.begin (), candidates.begin () + count, candidates.end (),
+					[this] (quint32 left, quint32 right)
+						{ return Entries_.at (left).Frecency_ > Entries_.at (right).Frecency_; });
+
+			for (int i = 0; i < count; ++i)
+			{
+				const auto& entry = Entries_.at (candidates.at (i));
+				result.push_back ({ entry.Title_, entry.LastVisit_, entry.URL_ });
+			}
+		};
+
+		appendBest (prefixHits);
+		if (static_cast<int> (result.size ()) >= limit)
+			return result;
+
+		// Plain substring matches ("book" in "facebook.com") go after
+		// the word prefix ones.
+		QString term = isSingleTerm ? base : QString {};
+		if (!isSingleTerm)
+			for (const auto& word : allWords)
+				if (word.size () > term.size ())
+					term = word;
+
+		auto isSubstringHit = [this, &prefixHits, &matches] (quint32 id)
+		{
+			return !std::binary_search (prefixHits.begin (), prefixHits.end (), id) &&
+					matches (Entries_.at (id));
+		};
+
+		QVector<quint32> substringHits;
+		if (term.size () >= 3)
+		{
+			for (const auto id : GetSubstringCandidates (term))
+				if (isSubstringHit (id))
+					substringHits << id;
+		}
+		else
+		{
+			// Too short to have trigrams, and such terms are contained
+			// in almost anything, so just take the first ones.
+			const auto needed = limit - static_cast<int> (result.size ());
+			for (quint32 i = 0, size = Entries_.size ();
+					i < size && substringHits.size () < needed; ++i)
+				if (isSubstringHit (i))
+					substringHits << i;
+		}
+		appendBest (substringHits);
+
+		return result;
+	}
+
+	void URLCompletionIndex::AddVisit (const HistoryItem& item, const QDateTime& now)
+	{
+		const auto weight = GetVisitWeight (item.DateTime_, now);
+
+		const auto pos = URL2Entry_.find (item.URL_);
+		if (pos == URL2Entry_.end ())
+		{
+			const quint32 id = Entries_.size ();
+			Entries_.append ({ item.URL_, item.Title_, item.DateTime_, weight });
+			URL2Entry_.insert (item.URL_, id);
+			AddWords (id, item.URL_ + ' ' + item.Title_, {});
+			AddTrigrams (id, item.URL_ + '\n' + item.Title_, {});
+			return;
+		}
+
+		auto& entry = Entries_ [*pos];
+		entry.Frecency_ += weight;
+
+		if (item.DateTime_ <= entry.LastVisit_)
+			return;
+
+		entry.LastVisit_ = item.DateTime_;
+		if (!item.Title_.isEmpty () && item.Title_ != entry.Title_)
+		{
+			AddWords (*pos, item.Title_, entry.URL_ + ' ' + entry.Title_);
+			AddTrigrams (*pos, item.Title_, entry.URL_ + '\n' + entry.Title_);
+			entry.Title_ = item.Title_;
+		}
+	}
+
+	void URLCompletionIndex::AddWords (quint32 id, const QString& text, const QString& known)
+	{
+		const auto& knownWords = GetWords (known).toSet ();
+		for (const auto& word : GetWords (text).toSet ())
+			if (!IsStopWord (word) && !knownWords.contains (word))
+				Words_ [word] << id;
+	}
+
+	void URLCompletionIndex::AddTrigrams (quint32 id, const QString& text, const QString& known)
+	{
+		const auto& knownTrigrams = GetTrigrams (known);
+		for (const auto trigram : GetTrigrams (text))
+		{
+			if (knownTrigrams.contains (trigram))
+				continue;
+
+			// Titles of already known entries may change, so the ids
+			// don't necessarily come in the ascending order.
+			auto& ids = Trigrams_ [trigram];
+			const auto pos = std::lower_bound (ids.begin (), ids.end (), id);
+			if (pos == ids.end () || *pos != id)
+				ids.insert (pos, id);
+		}
+	}
+
+	QVector<quint32> URLCompletionIndex::GetSubstringCandidates (const QString& term) const
+	{
+		QList<const QVector<quint32>*> lists;
+		for (const auto trigram : GetTrigrams (term))
+		{
+			const auto pos = Trigrams_.find (trigram);
+			if (pos == Trigrams_.end ())
+				return {};
+			lists << &*pos;
+		}
+
+		std::sort (lists.begin (), lists.end (),
+				[] (const QVector<quint32> *left, const QVector<quint32> *right)
+					{ return left->size () < right->size (); });
+
+		auto result = *lists.takeFirst ();
+		for (const auto list : lists)
+			result.erase (std::remove_if (result.begin (), result.end (),
+						[list] (quint32 id) { return !std::binary_search (list->begin (), list->end (), id); }),
+					result.end ());
+		return result;
+	}
+}
+}
@@ -0,0 +1,96 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <QVector>
+#include <QHash>
+#include <QMap>
+#include <QDateTime>
+#include <interfaces/poshuku/poshukutypes.h>
+
+namespace LeechCraft
+{
+namespace Poshuku
+{
+	/** In-memory index of the history used for URL completion.
+	 *
+	 * Each distinct URL is stored once together with its precomputed
+	 * frecency, which combines the number of visits with how recent
+	 * they are. Words of URLs and titles are kept in a sorted map, so
+	 * word prefix queries don't need to touch every entry, and their
+	 * trigrams are kept in a hash for the plain substring queries.
+	 */
+	class URLCompletionIndex
+	{
+		struct Entry
+		{
+			QString URL_;
+			QString Title_;
+			QDateTime LastVisit_;
+			double Frecency_;
+		};
+		QVector<Entry> Entries_;
+		QHash<QString, quint32> URL2Entry_;
+
+		QMap<QString, QVector<quint32>> Words_;
+		QHash<quint64, QVector<quint32>> Trigrams_;
+	public:
+		/** Builds the index from the given history items.
+		 *
+		 * Each item is a single visit. This can be called from any
+		 * thread.
+		 */
+		static std::shared_ptr<URLCompletionIndex> Build (const history_items_t&);
+
+		void AddVisit (const HistoryItem&);
+
+		/** Returns at most limit items whose URL or title contain the
+		 * base, ordered by frecency.
+		 *
+		 * Items having a word starting with the longest word of base
+		 * are looked up in the word map and go first. If there are
+		 * less than limit of them, they are followed by the items
+		 * containing base only as a plain substring. These are looked
+		 * up via the trigrams of the longest term of base, or, if it
+		 * is shorter than three characters, only the first matches
+		 * are taken.
+		 */
+		history_items_t Query (const QString& base, int limit) const;
+	private:
+		void AddVisit (const HistoryItem&, const QDateTime& now);
+		void AddWords (quint32, const QString&, const QString&);
+		void AddTrigrams (quint32, const QString&, const QString&);
+		QVector<quint32> GetSubstringCandidates (const QString&) const;
+	};
+
+	typedef std::shared_ptr<URLCompletionIndex> URLCompletionIndex_ptr;
+}
+}
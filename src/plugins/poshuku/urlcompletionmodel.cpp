@@ -30,6 +30,8 @@
 #include "urlcompletionmodel.h"
 #include <stdexcept>
 #include <QUrl>
+#include <QFutureWatcher>
+#include <QtConcurrentRun>
 #include <QtDebug>
 #include <util/xpc/defaulthookproxy.h>
 #include <interfaces/core/icoreproxy.h>
@@ -144,9 +146,63 @@ namespace Poshuku
 		}
 	}
 
-	void URLCompletionModel::handleItemAdded (const HistoryItem&)
+	void URLCompletionModel::handleItemAdded (const HistoryItem& item)
 	{
 		Valid_ = false;
+
+		if (Index_)
+			Index_->AddVisit (item);
+		else if (IsBuildingIndex_)
+			PendingVisits_ << item;
+	}
+
+	void URLCompletionModel::buildIndex ()
+	{
+		if (Index_ || IsBuildingIndex_)
+			return;
+
+		IsBuildingIndex_ = true;
+
+		// The history may be huge, so it's loaded in the worker thread
+		// via its own connection as well.
+		const auto sb = Core::Instance ().GetStorageBackend ();
+		auto watcher = new QFutureWatcher<URLCompletionIndex_ptr> (this);
+		connect (watcher,
+				SIGNAL (finished ()),
+				this,
+				SLOT (handleIndexBuilt ()));
+		watcher->setFuture (QtConcurrent::run ([sb] () -> URLCompletionIndex_ptr
+				{
+					history_items_t items;
+					try
+					{
+						sb->LoadHistoryConcurrently (items);
+					}
+					catch (const std::exception& e)
+					{
+						qWarning () << Q_FUNC_INFO
+								<< "unable to load history:"
+								<< e.what ();
+						return {};
+					}
+					return URLCompletionIndex::Build (items);
+				}));
+	}
+
+	void URLCompletionModel::handleIndexBuilt ()
+	{
+		auto watcher = dynamic_cast<QFutureWatcher<URLCompletionIndex_ptr>*> (sender ());
+		watcher->deleteLater ();
+
+		IsBuildingIndex_ = false;
+		Index_ = watcher->result ();
+
+		if (Index_)
+			for (const auto& item : PendingVisits_)
+				Index_->AddVisit (item);
+		PendingVisits_.clear ();
+
+		Valid_ = false;
 	}
 
 	void URLCompletionModel::Populate ()
@@ -182,7 +238,11 @@ namespace Poshuku
 			{
 				try
 				{
-					Core::Instance ().GetStorageBackend ()->LoadResemblingHistory (Base_, Items_);
+					// The database is only queried until the index is built.
+					if (Index_)
+						Items_ = Index_->Query (Base_, 100);
+					else
+						Core::Instance ().GetStorageBackend ()->LoadResemblingHistory (Base_, Items_);
 				}
 				catch (const std::runtime_error& e)
 				{
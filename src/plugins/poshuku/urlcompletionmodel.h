@@ -33,6 +33,7 @@
 #include <interfaces/core/ihookproxy.h>
 #include <interfaces/poshuku/iurlcompletionmodel.h>
 #include "historymodel.h"
+#include "urlcompletionindex.h"
 
 namespace LeechCraft
 {
@@ -47,6 +48,10 @@ namespace Poshuku
 		mutable bool Valid_;
 		mutable history_items_t Items_;
 		QString Base_;
+
+		URLCompletionIndex_ptr Index_;
+		bool IsBuildingIndex_ = false;
+		history_items_t PendingVisits_;
 	public:
 		enum
 		{
@@ -69,6 +74,10 @@ namespace Poshuku
 	public slots:
 		void setBase (const QString&);
 		void handleItemAdded (const HistoryItem&);
+
+		void buildIndex ();
+	private slots:
+		void handleIndexBuilt ();
 	signals:
 		// Plugin API
 		void hookURLCompletionNewStringRequested (LeechCraft::IHookProxy_ptr proxy,
@@ -29,6 +29,7 @@
 
 #include "account.h"
 #include <stdexcept>
+#include <algorithm>
 #include <QUuid>
 #include <QDataStream>
 #include <QInputDialog>
@@ -46,6 +47,8 @@
 #include "taskqueuemanager.h"
 #include "foldersmodel.h"
 #include "mailmodelsmanager.h"
+#include "folder.h"
+#include "xmlsettingsmanager.h"
 
 Q_DECLARE_METATYPE (QList<QStringList>)
 Q_DECLARE_METATYPE (QList<QByteArray>)
@@ -58,6 +61,7 @@ namespace Snails
 	: QObject (parent)
 	, Thread_ (new AccountThread (true, this))
 	, MessageFetchThread_ (new AccountThread (false, this))
+	, SyncQueue_ (std::make_shared<TaskQueue> ())
 	, AccMutex_ (new QMutex (QMutex::Recursive))
 	, ID_ (QUuid::createUuid ().toByteArray ())
 	, UseSASL_ (false)
@@ -77,6 +81,15 @@ namespace Snails
 		Thread_->start (QThread::IdlePriority);
 		MessageFetchThread_->start (QThread::LowPriority);
 
+		const auto syncConnections = std::max (1,
+				XmlSettingsManager::Instance ().property ("IMAPSyncConnections").toInt ());
+		for (int i = 0; i < syncConnections; ++i)
+		{
+			const auto thread = new AccountThread (false, this, SyncQueue_);
+			thread->start (QThread::IdlePriority);
+			SyncThreads_ << thread;
+		}
+
 		connect (FolderManager_,
 				SIGNAL (foldersUpdated ()),
 				this,
@@ -137,24 +150,44 @@ namespace Snails
 		if (folders.isEmpty ())
 			folders << QStringList ("INBOX");
 
+		if (InType_ != InType::IMAP)
+		{
+			Thread_->AddTask ({
+					"synchronize",
+					{
+						{ folders },
+						QByteArray {}
+					}
+				});
+			return;
+		}
+
 		Thread_->AddTask ({
-				"synchronize",
-				{
-					{ folders },
-					QByteArray {}
-				}
+				"synchronizeFolderList",
+				{},
+				"synchronizeFolderList"
 			});
+
+		for (const auto& folder : folders)
+			Synchronize (folder, {});
 	}
 
 	void Account::Synchronize (const QStringList& path, const QByteArray& last)
 	{
-		Thread_->AddTask ({
-				"synchronize",
+		const auto priority = MailModelsManager_->IsFolderShown (path) ?
+				TaskQueueItem::Priority::High :
+				TaskQueueItem::Priority::Normal;
+
+		SyncQueue_->AddTasks ({
 				{
-					QList<QStringList> { path },
-					last
-				},
-				"syncFolder"
+					priority,
+					"synchronize",
+					{
+						QList<QStringList> { path },
+						last
+					},
+					"syncFolder/" + path.join ("/").toUtf8 ()
+				}
 			});
 	}
 
@@ -592,10 +625,7 @@ namespace Snails
 	void Account::handleGotOtherMessages (const QList<QByteArray>& ids, const QStringList& folder)
 	{
 		qDebug () << Q_FUNC_INFO << ids.size () << folder;
-		QList<Message_ptr> msgs;
-		for (const auto& id : ids)
-			msgs << Core::Instance ().GetStorage ()->LoadMessage (this, folder, id);
-
+		const auto& msgs = Core::Instance ().GetStorage ()->LoadMessageHeaders (this, folder, ids);
 		MailModelsManager_->Append (msgs);
 
 		UpdateFolderCount (folder);
@@ -627,6 +657,11 @@ namespace Snails
 			});
 	}
 
+	void Account::handleFolderSyncState (const QStringList& folder, const FolderSyncState& state)
+	{
+		Core::Instance ().GetStorage ()->SetFolderSyncState (this, folder, state);
+	}
+
 	void Account::handleMessageCountFetched (int count, int unread, const QStringList& folder)
 	{
 		const auto storedCount = Core::Instance ().GetStorage ()->GetNumMessages (this, folder);
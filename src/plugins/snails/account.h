@@ -55,6 +55,10 @@ namespace Snails
 	class FoldersModel;
 	class MailModelsManager;
 	struct Folder;
+	struct FolderSyncState;
+
+	class TaskQueue;
+	typedef std::shared_ptr<TaskQueue> TaskQueue_ptr;
 
 	class Account : public QObject
 	{
@@ -63,6 +67,10 @@ namespace Snails
 		friend class AccountThreadWorker;
 		AccountThread * const Thread_;
 		AccountThread * const MessageFetchThread_;
+
+		const TaskQueue_ptr SyncQueue_;
+		QList<AccountThread*> SyncThreads_;
+
 		QMutex * const AccMutex_;
 
 		QByteArray ID_;
@@ -181,6 +189,7 @@ namespace Snails
 		void handleMessagesRemoved (const QList<QByteArray>&, const QStringList&);
 
 		void handleFolderSyncFinished (const QStringList&, const QByteArray&);
+		void handleFolderSyncState (const QStringList&, const LeechCraft::Snails::FolderSyncState&);
 		void handleMessageCountFetched (int, int, const QStringList&);
 
 		void handleGotFolders (const QList<LeechCraft::Snails::Folder>&);
@@ -29,6 +29,7 @@
 
 #include "accountdatabase.h"
 #include <QDir>
+#include <QMutexLocker>
 #include <QSqlDatabase>
 #include <QSqlError>
 #include <QSqlQuery>
@@ -36,6 +37,7 @@
 #include <util/db/dblock.h>
 #include <util/sll/qtutil.h>
 #include "account.h"
+#include "folder.h"
 
 bool operator< (const QStringList& left, const QStringList& right)
 {
@@ -78,6 +80,8 @@ namespace Snails
 
 	QList<QByteArray> AccountDatabase::GetIDs (const QStringList& folder)
 	{
+		QMutexLocker locker { &DBMutex_ };
+
 		QueryGetIds_.bindValue (":path", folder.join ("/"));
 		Util::DBLock::Execute (QueryGetIds_);
 
@@ -88,6 +92,20 @@ namespace Snails
 		return result;
 	}
 
+	QHash<QByteArray, bool> AccountDatabase::GetReadStatuses (const QStringList& folder)
+	{
+		QMutexLocker locker { &DBMutex_ };
+
+		QueryGetReadStatuses_.bindValue (":path", folder.join ("/"));
+		Util::DBLock::Execute (QueryGetReadStatuses_);
+
+		QHash<QByteArray, bool> result;
+		while (QueryGetReadStatuses_.next ())
+			result [QueryGetReadStatuses_.value (0).toByteArray ()] = QueryGetReadStatuses_.value (1).toBool ();
+		QueryGetReadStatuses_.finish ();
+		return result;
+	}
+
 	namespace
 	{
 		int GetCount (QSqlQuery& query, const QStringList& folder)
@@ -109,16 +127,22 @@ namespace Snails
 
 	int AccountDatabase::GetMessageCount (const QStringList& folder)
 	{
+		QMutexLocker locker { &DBMutex_ };
+
 		return GetCount (QueryGetCount_, folder);
 	}
 
 	int AccountDatabase::GetUnreadMessageCount (const QStringList& folder)
 	{
+		QMutexLocker locker { &DBMutex_ };
+
 		return GetCount (QueryGetUnreadCount_, folder);
 	}
 
 	int AccountDatabase::GetMessageCount ()
 	{
+		QMutexLocker locker { &DBMutex_ };
+
 		Util::DBLock::Execute (QueryGetTotalCount_);
 		if (!QueryGetTotalCount_.next ())
 		{
@@ -134,6 +158,8 @@ namespace Snails
 
 	boost::optional<int> AccountDatabase::GetMsgTableId (const QByteArray& uniqueId)
 	{
+		QMutexLocker locker { &DBMutex_ };
+
 		if (uniqueId.isEmpty ())
 			return {};
 
@@ -154,6 +180,8 @@ namespace Snails
 
 	boost::optional<int> AccountDatabase::GetMsgTableId (const QByteArray& msgId, const QStringList& folder)
 	{
+		QMutexLocker locker { &DBMutex_ };
+
 		QueryGetMsgTableIdByFolder_.bindValue (":msgId", msgId);
 		QueryGetMsgTableIdByFolder_.bindValue (":path", folder.join ("/"));
 		Util::DBLock::Execute (QueryGetMsgTableIdByFolder_);
@@ -164,8 +192,45 @@ namespace Snails
 			return {};
 	}
 
+	boost::optional<FolderSyncState> AccountDatabase::GetFolderSyncState (const QStringList& folder)
+	{
+		QMutexLocker locker { &DBMutex_ };
+
+		QueryGetSyncState_.bindValue (":path", folder.join ("/"));
+		Util::DBLock::Execute (QueryGetSyncState_);
+
+		const std::shared_ptr<void> finishGuard
+		{
+			nullptr,
+			[this] (void*) { QueryGetSyncState_.finish (); }
+		};
+
+		if (!QueryGetSyncState_.next ())
+			return {};
+
+		return FolderSyncState
+		{
+			QueryGetSyncState_.value (0).toUInt (),
+			QueryGetSyncState_.value (1).toUInt (),
+			QueryGetSyncState_.value (2).toULongLong ()
+		};
+	}
+
+	void AccountDatabase::SetFolderSyncState (const QStringList& folder, const FolderSyncState& state)
+	{
+		QMutexLocker locker { &DBMutex_ };
+
+		QuerySetSyncState_.bindValue (":folderId", AddFolder (folder));
+		QuerySetSyncState_.bindValue (":uidValidity", state.UIDValidity_);
+		QuerySetSyncState_.bindValue (":uidNext", state.UIDNext_);
+		QuerySetSyncState_.bindValue (":highestModSeq", static_cast<qulonglong> (state.HighestModSeq_));
+		Util::DBLock::Execute (QuerySetSyncState_);
+	}
+
 	void AccountDatabase::AddMessage (const Message_ptr& msg)
 	{
+		QMutexLocker locker { &DBMutex_ };
+
 		for (const auto& folder : msg->GetFolders ())
 			AddFolder (folder);
 
@@ -193,6 +258,8 @@ namespace Snails
 	void AccountDatabase::RemoveMessage (const QByteArray& msgId, const QStringList& folder,
 			const std::function<void ()>& continuation)
 	{
+		QMutexLocker locker { &DBMutex_ };
+
 		Util::DBLock lock { *DB_ };
 		lock.Init ();
 
@@ -265,6 +332,15 @@ namespace Snails
 					FolderMessageId TEXT NOT NULL
 					)
 				)d";
+		table2queries ["folder_sync_state"] <<
+				R"d(
+					CREATE TABLE folder_sync_state (
+					FolderId INTEGER PRIMARY KEY REFERENCES folders (Id) ON DELETE CASCADE,
+					UIDValidity INTEGER NOT NULL,
+					UIDNext INTEGER NOT NULL,
+					HighestModSeq INTEGER NOT NULL
+					)
+				)d";
 
 		QSqlQuery query { *DB_ };
 		for (const auto& pair : Util::Stlize (table2queries))
@@ -358,6 +434,30 @@ namespace Snails
 					VALUES
 					(:msgTableId, :folderId, :msgId)
 				)d");
+
+		QueryGetReadStatuses_ = QSqlQuery { *DB_ };
+		QueryGetReadStatuses_.prepare (R"d(
+					SELECT msg2folder.FolderMessageId, messages.IsRead FROM msg2folder, folders, messages
+					WHERE folders.FolderPath = :path
+					AND folders.Id = msg2folder.FolderId
+					AND messages.Id = msg2folder.MsgId
+				)d");
+
+		QueryGetSyncState_ = QSqlQuery { *DB_ };
+		QueryGetSyncState_.prepare (R"d(
+					SELECT folder_sync_state.UIDValidity, folder_sync_state.UIDNext, folder_sync_state.HighestModSeq
+					FROM folder_sync_state, folders
+					WHERE folders.FolderPath = :path
+					AND folders.Id = folder_sync_state.FolderId
+				)d");
+
+		QuerySetSyncState_ = QSqlQuery { *DB_ };
+		QuerySetSyncState_.prepare (R"d(
+					INSERT OR REPLACE INTO folder_sync_state
+					(FolderId, UIDValidity, UIDNext, HighestModSeq)
+					VALUES
+					(:folderId, :uidValidity, :uidNext, :highestModSeq)
+				)d");
 	}
 
 	int AccountDatabase::AddFolder (const QStringList& folder)
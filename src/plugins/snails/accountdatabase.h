@@ -35,6 +35,8 @@
 #include <QSqlQuery>
 #include <QStringList>
 #include <QMap>
+#include <QMutex>
+#include <QHash>
 
 class QSqlDatabase;
 typedef std::shared_ptr<QSqlDatabase> QSqlDatabase_ptr;
@@ -50,6 +52,8 @@ namespace Snails
 	class Message;
 	typedef std::shared_ptr<Message> Message_ptr;
 
+	struct FolderSyncState;
+
 	class AccountDatabase : public QObject
 	{
 		const QSqlDatabase_ptr DB_;
@@ -76,11 +80,23 @@ namespace Snails
 		QSqlQuery QueryAddMsgUnfoldered_;
 		QSqlQuery QueryAddMsgToFolder_;
 
+		QSqlQuery QueryGetReadStatuses_;
+
+		QSqlQuery QueryGetSyncState_;
+		QSqlQuery QuerySetSyncState_;
+
 		QMap<QStringList, int> KnownFolders_;
+
+		/* The database is accessed both from the GUI thread and from
+		 * the account threads, and neither the connection nor the
+		 * prepared queries above are thread-safe.
+		 */
+		QMutex DBMutex_ { QMutex::Recursive };
 	public:
 		AccountDatabase (const QDir&, Account*, QObject* = nullptr);
 
 		QList<QByteArray> GetIDs (const QStringList& folder);
+		QHash<QByteArray, bool> GetReadStatuses (const QStringList& folder);
 		int GetMessageCount (const QStringList& folder);
 		int GetUnreadMessageCount (const QStringList& folder);
 		int GetMessageCount ();
@@ -91,6 +107,9 @@ namespace Snails
 
 		boost::optional<int> GetMsgTableId (const QByteArray& uniqueId);
 		boost::optional<int> GetMsgTableId (const QByteArray& msgId, const QStringList& folder);
+
+		boost::optional<FolderSyncState> GetFolderSyncState (const QStringList& folder);
+		void SetFolderSyncState (const QStringList& folder, const FolderSyncState&);
 	private:
 		int AddMessageUnfoldered (const Message_ptr&);
 		void UpdateMessage (int, const Message_ptr&);
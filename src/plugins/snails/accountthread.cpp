@@ -28,7 +28,6 @@
  **********************************************************************/
 
 #include "accountthread.h"
-#include <QMutexLocker>
 #include <QtDebug>
 #include "account.h"
 #include "accountthreadworker.h"
@@ -39,21 +38,16 @@ namespace LeechCraft
 {
 namespace Snails
 {
-	AccountThread::AccountThread (bool isListening, Account *parent)
+	AccountThread::AccountThread (bool isListening, Account *parent, const TaskQueue_ptr& queue)
 	: A_ { parent }
 	, IsListening_ { isListening }
+	, Queue_ { queue }
 	{
 	}
 
 	QFuture<void> AccountThread::AddTask (const TaskQueueItem& item)
 	{
-		QMutexLocker guard { &QueueMutex_ };
-
-		if (QueueManager_)
-			QueueManager_->AddTasks ({ item });
-		else
-			PendingQueue_ << item;
-
+		Queue_->AddTasks ({ item });
 		return item.Promise_->future ();
 	}
 
@@ -62,12 +56,7 @@ namespace Snails
 		W_ = new AccountThreadWorker { IsListening_, A_ };
 		ConnectSignals ();
 
-		{
-			QMutexLocker guard { &QueueMutex_ };
-			QueueManager_ = new TaskQueueManager { W_ };
-			QueueManager_->AddTasks (PendingQueue_);
-			PendingQueue_.clear ();
-		}
+		QueueManager_ = new TaskQueueManager { W_, Queue_ };
 
 		QThread::run ();
 
@@ -111,6 +100,10 @@ namespace Snails
 				SIGNAL (folderSyncFinished (QStringList, QByteArray)),
 				A_,
 				SLOT (handleFolderSyncFinished (QStringList, QByteArray)));
+		connect (W_,
+				SIGNAL (folderSyncStateChanged (QStringList, LeechCraft::Snails::FolderSyncState)),
+				A_,
+				SLOT (handleFolderSyncState (QStringList, LeechCraft::Snails::FolderSyncState)));
 
 		connect (W_,
 				SIGNAL (gotEntity (LeechCraft::Entity)),
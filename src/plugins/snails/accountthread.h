@@ -50,11 +50,11 @@ namespace Snails
 
 		AccountThreadWorker *W_;
 
-		QMutex QueueMutex_;
-		QList<TaskQueueItem> PendingQueue_;
+		const TaskQueue_ptr Queue_;
 		TaskQueueManager *QueueManager_ = nullptr;
 	public:
-		AccountThread (bool isListening, Account*);
+		AccountThread (bool isListening, Account*,
+				const TaskQueue_ptr& = std::make_shared<TaskQueue> ());
 
 		QFuture<void> AddTask (const TaskQueueItem&);
 	protected:
@@ -35,12 +35,16 @@
 #include <QSslSocket>
 #include <QtDebug>
 #include <QTimer>
+#include <QElapsedTimer>
+#include <QSet>
+#include <boost/optional.hpp>
 #include <vmime/security/defaultAuthenticator.hpp>
 #include <vmime/security/cert/defaultCertificateVerifier.hpp>
 #include <vmime/security/cert/X509Certificate.hpp>
 #include <vmime/net/transport.hpp>
 #include <vmime/net/store.hpp>
 #include <vmime/net/message.hpp>
+#include <vmime/net/imap/IMAPFolderStatus.hpp>
 #include <vmime/utility/datetimeUtils.hpp>
 #include <vmime/dateTime.hpp>
 #include <vmime/messageParser.hpp>
@@ -638,7 +642,8 @@ namespace Snails
 
 		try
 		{
-			const auto& context = tr ("Fetching headers for %1")
+			const auto& context = tr ("Fetching headers for %1 of %2")
+					.arg (folderName.join ("/"))
 					.arg (A_->GetName ());
 
 			folder->fetchMessages (messages, desiredFlags, MkPgListener (context));
@@ -669,6 +674,38 @@ namespace Snails
 		return newMessages;
 	}
 
+	namespace
+	{
+		boost::optional<FolderSyncState> GetServerSyncState (const VmimeFolder_ptr& folder)
+		{
+			try
+			{
+				const auto& status = vmime::dynamicCast<vmime::net::imap::IMAPFolderStatus> (folder->getStatus ());
+				if (!status || !status->getUIDValidity ())
+					return {};
+
+				return FolderSyncState
+				{
+					status->getUIDValidity (),
+					status->getUIDNext (),
+					status->getHighestModSeq ()
+				};
+			}
+			catch (const std::exception& e)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "cannot get folder status:"
+						<< e.what ();
+				return {};
+			}
+		}
+
+		QByteArray GetUID (const vmime::shared_ptr<vmime::net::message>& msg)
+		{
+			return static_cast<vmime::string> (msg->getUID ()).c_str ();
+		}
+	}
+
 	void AccountThreadWorker::FetchMessagesInFolder (const QStringList& folderName,
 			const VmimeFolder_ptr& folder, const QByteArray& lastId)
 	{
@@ -683,9 +720,90 @@ namespace Snails
 
 		qDebug () << Q_FUNC_INFO << folderName << folder.get () << lastId;
 
+		const auto& context = tr ("Synchronizing %1 of %2")
+				.arg (folderName.join ("/"))
+				.arg (A_->GetName ());
+		// Not MkPgListener(): the task queue doesn't return to the event
+		// loop between tasks, so deleteLater() would fire too late.
+		const auto pl = new ProgressListener (context);
+		emit gotProgressListener (ProgressListener_g_ptr (pl));
+
+		QElapsedTimer timer;
+		timer.start ();
+		const std::shared_ptr<void> timingGuard
+		{
+			nullptr,
+			[pl, &timer, &folderName] (void*)
+			{
+				qDebug () << Q_FUNC_INFO
+						<< folderName
+						<< "synchronized in"
+						<< timer.elapsed ()
+						<< "ms";
+				delete pl;
+			}
+		};
+
+		const auto& serverState = lastId.isEmpty () ?
+				GetServerSyncState (folder) :
+				boost::optional<FolderSyncState> {};
+		if (!serverState)
+		{
+			SyncFolderFully (folderName, folder, lastId, false);
+			return;
+		}
+
+		bool synced = false;
+
+		const auto& storedState = Core::Instance ().GetStorage ()->GetFolderSyncState (A_, folderName);
+		if (storedState && storedState->UIDValidity_ == serverState->UIDValidity_)
+			synced = SyncFolderIncrementally (folderName, folder, *storedState, *serverState);
+		else
+		{
+			if (storedState)
+				qDebug () << Q_FUNC_INFO
+						<< "UIDVALIDITY changed for"
+						<< folderName
+						<< storedState->UIDValidity_
+						<< "->"
+						<< serverState->UIDValidity_
+						<< "; doing full resync";
+			synced = SyncFolderFully (folderName, folder, lastId, static_cast<bool> (storedState));
+		}
+
+		if (synced)
+			emit folderSyncStateChanged (folderName, *serverState);
+	}
+
+	bool AccountThreadWorker::SyncFolderFully (const QStringList& folderName,
+			const VmimeFolder_ptr& folder, const QByteArray& lastId, bool dropExisting)
+	{
 		auto messages = GetMessagesInFolder (folder, lastId);
+		if (messages.empty () && folder->getMessageCount () > 0)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "cannot get messages in"
+					<< folderName;
+			return false;
+		}
+
 		auto newMessages = FetchVmimeMessages (messages, folder, folderName);
+		const bool fetched = newMessages.size () == static_cast<int> (messages.size ());
+
+		/* The stored messages are only dropped once the whole folder has
+		 * been fetched, otherwise they'd be lost until the next full
+		 * resync. Mixing them with the new ones isn't an option either,
+		 * since their UIDs aren't valid anymore.
+		 */
+		if (dropExisting && !fetched)
+			return false;
+
 		auto existing = Core::Instance ().GetStorage ()->LoadIDs (A_, folderName);
+		if (dropExisting)
+		{
+			emit gotMessagesRemoved (existing, folderName);
+			existing.clear ();
+		}
 
 		QList<QByteArray> ids;
 
@@ -730,8 +848,137 @@ namespace Snails
 		emit gotMsgHeaders (newMessages, folderName);
 		emit gotUpdatedMessages (updatedMessages, folderName);
 
-		if (lastId.isEmpty ())
+		if (lastId.isEmpty () && fetched)
 			emit gotMessagesRemoved (existing, folderName);
+
+		return fetched;
+	}
+
+	bool AccountThreadWorker::SyncFolderIncrementally (const QStringList& folderName,
+			const VmimeFolder_ptr& folder, const FolderSyncState& stored, const FolderSyncState& server)
+	{
+		const auto& readStatuses = Core::Instance ().GetStorage ()->LoadReadStatuses (A_, folderName);
+
+		QList<Message_ptr> newMessages;
+		if (server.UIDNext_ != stored.UIDNext_)
+		{
+			auto messages = GetMessagesInFolder (folder, QByteArray::number (stored.UIDNext_));
+
+			// "UID n:*" always returns at least the last message, even if its UID is below n.
+			messages.erase (std::remove_if (messages.begin (), messages.end (),
+						[&stored, &readStatuses] (const vmime::shared_ptr<vmime::net::message>& msg)
+						{
+							const auto& uid = GetUID (msg);
+							return uid.toULongLong () < stored.UIDNext_ || readStatuses.contains (uid);
+						}),
+					messages.end ());
+
+			newMessages = FetchVmimeMessages (messages, folder, folderName);
+			if (newMessages.size () != static_cast<int> (messages.size ()))
+				return false;
+		}
+
+		const auto expectedCount = readStatuses.size () + newMessages.size ();
+		if (server.HighestModSeq_ &&
+				server.HighestModSeq_ == stored.HighestModSeq_ &&
+				folder->getMessageCount () == expectedCount)
+		{
+			qDebug () << Q_FUNC_INFO
+					<< folderName
+					<< "is unchanged since modseq"
+					<< stored.HighestModSeq_
+					<< "; got"
+					<< newMessages.size ()
+					<< "new messages";
+			emit gotMsgHeaders (newMessages, folderName);
+			return true;
+		}
+
+		/* Either the server doesn't support CONDSTORE, some flags have
+		 * changed or some messages have been expunged, so refetch just
+		 * the flags and UIDs of the whole folder, which is still way
+		 * cheaper than refetching all the headers.
+		 */
+		auto allMessages = GetMessagesInFolder (folder, {});
+		if (allMessages.empty () && folder->getMessageCount ())
+		{
+			emit gotMsgHeaders (newMessages, folderName);
+			return false;
+		}
+
+		if (!allMessages.empty ())
+			try
+			{
+				const auto& context = tr ("Synchronizing flags for %1 of %2")
+						.arg (folderName.join ("/"))
+						.arg (A_->GetName ());
+				folder->fetchMessages (allMessages,
+						vmime::net::fetchAttributes::FLAGS | vmime::net::fetchAttributes::UID,
+						MkPgListener (context));
+			}
+			catch (const std::exception& e)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "cannot fetch flags:"
+						<< e.what ();
+				emit gotMsgHeaders (newMessages, folderName);
+				return false;
+			}
+
+		QSet<QByteArray> serverIds;
+		QList<Message_ptr> updatedMessages;
+		MessageVector_t missingMessages;
+		for (const auto& msg : allMessages)
+		{
+			const auto& uid = GetUID (msg);
+			serverIds << uid;
+
+			const auto pos = readStatuses.find (uid);
+			if (pos == readStatuses.end ())
+				continue;
+
+			const bool isRead = msg->getFlags () & vmime::net::message::FLAG_SEEN;
+			if (*pos == isRead)
+				continue;
+
+			try
+			{
+				const auto& updated = Core::Instance ().GetStorage ()->LoadMessage (A_, folderName, uid);
+				updated->SetRead (isRead);
+				updatedMessages << updated;
+			}
+			catch (const std::exception& e)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "cannot load stored message"
+						<< uid
+						<< e.what ()
+						<< "; refetching it";
+				missingMessages.push_back (msg);
+			}
+		}
+
+		if (!missingMessages.empty ())
+			newMessages += FetchVmimeMessages (missingMessages, folder, folderName);
+
+		QList<QByteArray> removedIds;
+		for (auto i = readStatuses.begin (); i != readStatuses.end (); ++i)
+			if (!serverIds.contains (i.key ()))
+				removedIds << i.key ();
+
+		qDebug () << Q_FUNC_INFO
+				<< folderName
+				<< "new:"
+				<< newMessages.size ()
+				<< "updated:"
+				<< updatedMessages.size ()
+				<< "removed:"
+				<< removedIds.size ();
+
+		emit gotMsgHeaders (newMessages, folderName);
+		emit gotUpdatedMessages (updatedMessages, folderName);
+		emit gotMessagesRemoved (removedIds, folderName);
+		return true;
 	}
 
 	namespace
@@ -902,17 +1149,19 @@ namespace Snails
 			FetchMessagesPOP3 ();
 			break;
 		case Account::InType::IMAP:
-		{
-			const auto& store = MakeStore ();
-			SyncIMAPFolders (store);
 			FetchMessagesIMAP (folders, last);
 			break;
-		}
 		case Account::InType::Maildir:
 			break;
 		}
 	}
 
+	void AccountThreadWorker::synchronizeFolderList ()
+	{
+		if (A_->InType_ == Account::InType::IMAP)
+			SyncIMAPFolders (MakeStore ());
+	}
+
 	void AccountThreadWorker::getMessageCount (const QStringList& folder, QObject *handler, const QByteArray& slot)
 	{
 		const auto& netFolder = GetFolder (folder, FolderMode::NoChange);
@@ -49,6 +49,7 @@ namespace Snails
 	class MessageChangeListener;
 
 	struct Folder;
+	struct FolderSyncState;
 
 	typedef std::vector<vmime::shared_ptr<vmime::net::message>> MessageVector_t;
 	typedef vmime::shared_ptr<vmime::net::folder> VmimeFolder_ptr;
@@ -91,6 +92,9 @@ namespace Snails
 		void FetchMessagesIMAP (const QList<QStringList>&, const QByteArray&);
 		QList<Message_ptr> FetchVmimeMessages (MessageVector_t, const VmimeFolder_ptr&, const QStringList&);
 		void FetchMessagesInFolder (const QStringList&, const VmimeFolder_ptr&, const QByteArray&);
+		bool SyncFolderFully (const QStringList&, const VmimeFolder_ptr&, const QByteArray&, bool dropExisting);
+		bool SyncFolderIncrementally (const QStringList&, const VmimeFolder_ptr&,
+				const FolderSyncState& stored, const FolderSyncState& server);
 
 		void SyncIMAPFolders (vmime::shared_ptr<vmime::net::store>);
 		QList<Message_ptr> FetchFullMessages (const std::vector<vmime::shared_ptr<vmime::net::message>>&);
@@ -103,6 +107,7 @@ namespace Snails
 		void flushSockets ();
 
 		void synchronize (const QList<QStringList>&, const QByteArray& last);
+		void synchronizeFolderList ();
 
 		void getMessageCount (const QStringList& folder, QObject *handler, const QByteArray& slot);
 
@@ -129,6 +134,7 @@ namespace Snails
 		void gotFolders (const QList<LeechCraft::Snails::Folder>&);
 
 		void folderSyncFinished (const QStringList& folder, const QByteArray& lastRequestedId);
+		void folderSyncStateChanged (const QStringList& folder, const LeechCraft::Snails::FolderSyncState& state);
 	};
 }
 }
@@ -78,6 +78,7 @@ namespace Snails
 		qRegisterMetaType<QList<QByteArray>> ("QList<QByteArray>");
 		qRegisterMetaType<Folder> ("LeechCraft::Snails::Folder");
 		qRegisterMetaType<QList<Folder>> ("QList<LeechCraft::Snails::Folder>");
+		qRegisterMetaType<FolderSyncState> ("LeechCraft::Snails::FolderSyncState");
 
 		qRegisterMetaTypeStreamOperators<AttDescr> ();
 		qRegisterMetaTypeStreamOperators<Folder> ();
@@ -56,11 +56,23 @@ namespace Snails
 	};
 
 	bool operator== (const Folder&, const Folder&);
+
+	/** Per-folder IMAP synchronization checkpoint.
+	 *
+	 * HighestModSeq_ is zero if the server doesn't support CONDSTORE.
+	 */
+	struct FolderSyncState
+	{
+		quint32 UIDValidity_;
+		quint32 UIDNext_;
+		quint64 HighestModSeq_;
+	};
 }
 }
 
 Q_DECLARE_METATYPE (LeechCraft::Snails::Folder)
 Q_DECLARE_METATYPE (QList<LeechCraft::Snails::Folder>)
+Q_DECLARE_METATYPE (LeechCraft::Snails::FolderSyncState)
 
 QDataStream& operator<< (QDataStream&, const LeechCraft::Snails::Folder&);
 QDataStream& operator>> (QDataStream&, LeechCraft::Snails::Folder&);
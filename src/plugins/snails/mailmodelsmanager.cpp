@@ -28,6 +28,7 @@
  **********************************************************************/
 
 #include "mailmodelsmanager.h"
+#include <algorithm>
 #include "account.h"
 #include "mailmodel.h"
 #include "core.h"
@@ -41,6 +42,10 @@ namespace Snails
 	: QObject { acc }
 	, Acc_ { acc }
 	{
+		connect (Core::Instance ().GetStorage (),
+				SIGNAL (accountMigrated (Account*)),
+				this,
+				SLOT (handleAccountMigrated (Account*)));
 	}
 
 	MailModel* MailModelsManager::CreateModel ()
@@ -75,16 +80,19 @@ namespace Snails
 
 		mailModel->SetFolder (path);
 
-		QList<Message_ptr> messages;
-		const auto& ids = Core::Instance ().GetStorage ()->LoadIDs (Acc_, path);
-		for (const auto& id : ids)
-			messages << Core::Instance ().GetStorage ()->LoadMessage (Acc_, path, id);
-
-		mailModel->Append (messages);
+		const auto storage = Core::Instance ().GetStorage ();
+		const auto& ids = storage->LoadIDs (Acc_, path);
+		mailModel->Append (storage->LoadMessageHeaders (Acc_, path, ids));
 
 		Acc_->Synchronize (path, ids.isEmpty () ? QByteArray {} : ids.last ());
 	}
 
+	bool MailModelsManager::IsFolderShown (const QStringList& path) const
+	{
+		return std::any_of (Models_.begin (), Models_.end (),
+				[&path] (MailModel *model) { return model->GetCurrentFolder () == path; });
+	}
+
 	void MailModelsManager::Append (const QList<Message_ptr>& messages)
 	{
 		for (const auto model : Models_)
@@ -109,5 +117,19 @@ namespace Snails
 	{
 		Models_.removeAll (static_cast<MailModel*> (modelObj));
 	}
+
+	void MailModelsManager::handleAccountMigrated (Account *acc)
+	{
+		if (acc != Acc_)
+			return;
+
+		// The folders shown before the migration finished might be incomplete.
+		for (const auto model : Models_)
+		{
+			const auto& folder = model->GetCurrentFolder ();
+			if (!folder.isEmpty ())
+				ShowFolder (folder, model);
+		}
+	}
 }
 }
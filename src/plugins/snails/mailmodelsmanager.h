@@ -55,12 +55,14 @@ namespace Snails
 		MailModel* CreateModel ();
 
 		void ShowFolder (const QStringList&, MailModel*);
+		bool IsFolderShown (const QStringList&) const;
 
 		void Append (const QList<Message_ptr>&);
 		void Update (const QList<Message_ptr>&);
 		void Remove (const QList<QByteArray>&);
 	private slots:
 		void handleModelDestroyed (QObject*);
+		void handleAccountMigrated (Account*);
 	};
 }
 }
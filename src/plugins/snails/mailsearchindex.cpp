@@ -0,0 +1,415 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "mailsearchindex.h"
+#include <stdexcept>
+#include <exception>
+#include <QDir>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QFutureInterface>
+#include <QRegExp>
+#include <QtDebug>
+#include <util/db/dblock.h>
+#include "account.h"
+
+namespace LeechCraft
+{
+namespace Snails
+{
+	namespace
+	{
+		class FunctionRunnable : public QRunnable
+		{
+			const std::function<void ()> Func_;
+		public:
+			FunctionRunnable (const std::function<void ()>& func)
+			: Func_ { func }
+			{
+			}
+
+			void run ()
+			{
+				Func_ ();
+			}
+		};
+	}
+
+	MailSearchIndex::MailSearchIndex (const QDir& dir, Account *acc)
+	: ConnName_ { "SnailsSearch_" + acc->GetID () }
+	{
+		// A single never expiring thread, so that the connection is
+		// always used from the thread it's been created in.
+		Thread_.setMaxThreadCount (1);
+		Thread_.setExpiryTimeout (-1);
+
+		const auto& path = dir.filePath ("search.db");
+		Run ([this, path] { Open (path); });
+	}
+
+	MailSearchIndex::~MailSearchIndex ()
+	{
+		Run ([this] { Close (); });
+	}
+
+	bool MailSearchIndex::IsBackfilled ()
+	{
+		bool result = false;
+		Run ([this, &result]
+				{
+					QSqlQuery query { *DB_ };
+					if (!query.exec ("PRAGMA user_version;"))
+					{
+						Util::DBLock::DumpError (query);
+						throw std::runtime_error ("Unable to get search index version.");
+					}
+					result = query.next () && query.value (0).toInt () >= 1;
+				});
+		return result;
+	}
+
+	void MailSearchIndex::SetBackfilled ()
+	{
+		Run ([this]
+				{
+					QSqlQuery query { *DB_ };
+					if (!query.exec ("PRAGMA user_version = 1;"))
+					{
+						Util::DBLock::DumpError (query);
+						throw std::runtime_error ("Unable to set search index version.");
+					}
+				});
+	}
+
+	void MailSearchIndex::Index (const QStringList& folder, const QList<Message_ptr>& msgs)
+	{
+		const auto& path = folder.join ("/");
+		Run ([this, &path, &msgs]
+				{
+					Util::DBLock lock { *DB_ };
+					lock.Init ();
+
+					for (const auto& msg : msgs)
+						if (!msg->GetFolderID ().isEmpty ())
+							IndexMessage (path, msg);
+
+					lock.Good ();
+				});
+	}
+
+	void MailSearchIndex::Remove (const QStringList& folder, const QByteArray& id)
+	{
+		const auto& path = folder.join ("/");
+		Post ([this, path, id]
+				{
+					try
+					{
+						RemoveMessage (path, id);
+					}
+					catch (const std::exception& e)
+					{
+						qWarning () << Q_FUNC_INFO
+								<< "unable to remove"
+								<< id.toHex ()
+								<< "from"
+								<< path
+								<< e.what ();
+					}
+				});
+	}
+
+	void MailSearchIndex::RemoveMessage (const QString& path, const QByteArray& id)
+	{
+		QueryGetDoc_.bindValue (":path", path);
+		QueryGetDoc_.bindValue (":msgId", id);
+		Util::DBLock::Execute (QueryGetDoc_);
+		if (!QueryGetDoc_.next ())
+		{
+			QueryGetDoc_.finish ();
+			return;
+		}
+
+		const auto docId = QueryGetDoc_.value (0).toLongLong ();
+		QueryGetDoc_.finish ();
+
+		Util::DBLock lock { *DB_ };
+		lock.Init ();
+
+		QueryRemoveFts_.bindValue (":docId", docId);
+		Util::DBLock::Execute (QueryRemoveFts_);
+
+		QueryRemoveDoc_.bindValue (":docId", docId);
+		Util::DBLock::Execute (QueryRemoveDoc_);
+
+		lock.Good ();
+	}
+
+	namespace
+	{
+		QString MakeMatchQuery (const QString& text)
+		{
+			// Only plain word prefixes are passed to FTS, so that the
+			// user input can't be interpreted as FTS query syntax.
+			QStringList terms;
+			for (const auto& word : text.split (QRegExp ("\\W+"), QString::SkipEmptyParts))
+				terms << word + '*';
+			return terms.join (" ");
+		}
+	}
+
+	QList<QByteArray> MailSearchIndex::Search (const QStringList& folder, const QString& text)
+	{
+		const auto& query = MakeMatchQuery (text);
+		if (query.isEmpty ())
+			return {};
+
+		QList<QByteArray> result;
+		Run ([this, &folder, &query, &result]
+				{
+					QuerySearch_.bindValue (":path", folder.join ("/"));
+					QuerySearch_.bindValue (":query", query);
+					Util::DBLock::Execute (QuerySearch_);
+
+					while (QuerySearch_.next ())
+						result << QuerySearch_.value (0).toByteArray ();
+					QuerySearch_.finish ();
+				});
+		return result;
+	}
+
+	void MailSearchIndex::Post (const std::function<void ()>& func)
+	{
+		Thread_.start (new FunctionRunnable { func });
+	}
+
+	void MailSearchIndex::Run (const std::function<void ()>& func)
+	{
+		std::exception_ptr error;
+
+		QFutureInterface<void> iface;
+		iface.reportStarted ();
+		Post ([func, iface, &error] () mutable
+				{
+					try
+					{
+						func ();
+					}
+					catch (...)
+					{
+						error = std::current_exception ();
+					}
+					iface.reportFinished ();
+				});
+		iface.future ().waitForFinished ();
+
+		if (error)
+			std::rethrow_exception (error);
+	}
+
+	void MailSearchIndex::Open (const QString& path)
+	{
+		DB_ = std::make_shared<QSqlDatabase> (QSqlDatabase::addDatabase ("QSQLITE", ConnName_));
+		try
+		{
+			if (!DB_->isValid ())
+			{
+				Util::DBLock::DumpError (DB_->lastError ());
+				throw std::runtime_error ("Unable to add database connection.");
+			}
+
+			DB_->setDatabaseName (path);
+			if (!DB_->open ())
+			{
+				Util::DBLock::DumpError (DB_->lastError ());
+				throw std::runtime_error (qPrintable (QString ("Could not initialize search database: %1")
+							.arg (DB_->lastError ().text ())));
+			}
+
+			InitTables ();
+			PrepareQueries ();
+		}
+		catch (const std::exception&)
+		{
+			Close ();
+			throw;
+		}
+	}
+
+	void MailSearchIndex::Close ()
+	{
+		if (!DB_)
+			return;
+
+		for (auto query : { &QueryGetDoc_, &QueryAddDoc_, &QuerySetDocHasBody_, &QueryRemoveDoc_,
+				&QueryAddFts_, &QueryUpdateFts_, &QueryRemoveFts_, &QuerySearch_ })
+			*query = QSqlQuery {};
+
+		DB_->close ();
+		DB_.reset ();
+		QSqlDatabase::removeDatabase (ConnName_);
+	}
+
+	namespace
+	{
+		QString GetAddressesText (const Message_ptr& msg)
+		{
+			QStringList result;
+			for (auto type : { Message::Address::From, Message::Address::To,
+					Message::Address::Cc, Message::Address::Bcc })
+				for (const auto& address : msg->GetAddresses (type))
+					result << address.first << address.second;
+			return result.join (" ");
+		}
+
+		QString GetBodyText (const Message_ptr& msg)
+		{
+			const auto& body = msg->GetBody ();
+			if (!body.isEmpty ())
+				return body;
+
+			auto html = msg->GetHTMLBody ();
+			return html.remove (QRegExp ("<[^>]*>"));
+		}
+	}
+
+	void MailSearchIndex::IndexMessage (const QString& path, const Message_ptr& msg)
+	{
+		const auto& body = GetBodyText (msg);
+
+		QueryGetDoc_.bindValue (":path", path);
+		QueryGetDoc_.bindValue (":msgId", msg->GetFolderID ());
+		Util::DBLock::Execute (QueryGetDoc_);
+
+		if (QueryGetDoc_.next ())
+		{
+			const auto docId = QueryGetDoc_.value (0).toLongLong ();
+			const auto hasBody = QueryGetDoc_.value (1).toBool ();
+			QueryGetDoc_.finish ();
+
+			// Headers don't change for a given folder ID, so the only
+			// thing worth reindexing is a newly fetched body.
+			if (hasBody || body.isEmpty ())
+				return;
+
+			QueryUpdateFts_.bindValue (":docId", docId);
+			QueryUpdateFts_.bindValue (":body", body);
+			Util::DBLock::Execute (QueryUpdateFts_);
+
+			QuerySetDocHasBody_.bindValue (":docId", docId);
+			Util::DBLock::Execute (QuerySetDocHasBody_);
+			return;
+		}
+		QueryGetDoc_.finish ();
+
+		QueryAddDoc_.bindValue (":path", path);
+		QueryAddDoc_.bindValue (":msgId", msg->GetFolderID ());
+		QueryAddDoc_.bindValue (":hasBody", !body.isEmpty ());
+		Util::DBLock::Execute (QueryAddDoc_);
+
+		QueryAddFts_.bindValue (":docId", QueryAddDoc_.lastInsertId ());
+		QueryAddFts_.bindValue (":subject", msg->GetSubject ());
+		QueryAddFts_.bindValue (":addresses", GetAddressesText (msg));
+		QueryAddFts_.bindValue (":body", body);
+		Util::DBLock::Execute (QueryAddFts_);
+	}
+
+	void MailSearchIndex::InitTables ()
+	{
+		QSqlQuery query { *DB_ };
+
+		const auto& tables = DB_->tables ();
+		if (!tables.contains ("docs"))
+			if (!query.exec (R"d(
+						CREATE TABLE docs (
+						DocId INTEGER PRIMARY KEY AUTOINCREMENT,
+						FolderPath TEXT NOT NULL,
+						MsgId TEXT NOT NULL,
+						HasBody BOOL NOT NULL,
+						UNIQUE (FolderPath, MsgId)
+						);
+					)d"))
+			{
+				Util::DBLock::DumpError (query);
+				throw std::runtime_error ("Query execution failed for search index creation.");
+			}
+
+		if (!tables.contains ("docs_fts"))
+			if (!query.exec ("CREATE VIRTUAL TABLE docs_fts USING fts4 (Subject, Addresses, Body);"))
+			{
+				Util::DBLock::DumpError (query);
+				throw std::runtime_error ("Unable to create FTS table, is SQLite built with FTS support?");
+			}
+
+		query.exec ("PRAGMA synchronous = OFF;");
+	}
+
+	void MailSearchIndex::PrepareQueries ()
+	{
+		QueryGetDoc_ = QSqlQuery { *DB_ };
+		QueryGetDoc_.prepare ("SELECT DocId, HasBody FROM docs WHERE FolderPath = :path AND MsgId = :msgId");
+
+		QueryAddDoc_ = QSqlQuery { *DB_ };
+		QueryAddDoc_.prepare (R"d(
+					INSERT INTO docs
+					(FolderPath, MsgId, HasBody)
+					VALUES
+					(:path, :msgId, :hasBody)
+				)d");
+
+		QuerySetDocHasBody_ = QSqlQuery { *DB_ };
+		QuerySetDocHasBody_.prepare ("UPDATE docs SET HasBody = 1 WHERE DocId = :docId");
+
+		QueryRemoveDoc_ = QSqlQuery { *DB_ };
+		QueryRemoveDoc_.prepare ("DELETE FROM docs WHERE DocId = :docId");
+
+		QueryAddFts_ = QSqlQuery { *DB_ };
+		QueryAddFts_.prepare (R"d(
+					INSERT INTO docs_fts
+					(docid, Subject, Addresses, Body)
+					VALUES
+					(:docId, :subject, :addresses, :body)
+				)d");
+
+		QueryUpdateFts_ = QSqlQuery { *DB_ };
+		QueryUpdateFts_.prepare ("UPDATE docs_fts SET Body = :body WHERE docid = :docId");
+
+		QueryRemoveFts_ = QSqlQuery { *DB_ };
+		QueryRemoveFts_.prepare ("DELETE FROM docs_fts WHERE docid = :docId");
+
+		QuerySearch_ = QSqlQuery { *DB_ };
+		QuerySearch_.prepare (R"d(
+					SELECT docs.MsgId FROM docs_fts, docs
+					WHERE docs_fts MATCH :query
+					AND docs.DocId = docs_fts.docid
+					AND docs.FolderPath = :path
+					ORDER BY docs.DocId DESC
+				)d");
+	}
+}
+}
@@ -0,0 +1,113 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <functional>
+#include <QThreadPool>
+#include <QSqlQuery>
+#include <QStringList>
+#include "message.h"
+
+class QDir;
+class QSqlDatabase;
+
+namespace LeechCraft
+{
+namespace Snails
+{
+	class Account;
+
+	/* Per-account local full-text index of messages.
+	 *
+	 * Subjects, addresses and plain text bodies are stored in an SQLite
+	 * FTS4 table. Messages are indexed once when first seen, and then
+	 * once again when their body becomes known.
+	 *
+	 * The database connection lives in a dedicated thread, and all the
+	 * queries are executed there, so all the methods are thread-safe.
+	 */
+	class MailSearchIndex
+	{
+		QThreadPool Thread_;
+
+		const QString ConnName_;
+		std::shared_ptr<QSqlDatabase> DB_;
+
+		QSqlQuery QueryGetDoc_;
+		QSqlQuery QueryAddDoc_;
+		QSqlQuery QuerySetDocHasBody_;
+		QSqlQuery QueryRemoveDoc_;
+		QSqlQuery QueryAddFts_;
+		QSqlQuery QueryUpdateFts_;
+		QSqlQuery QueryRemoveFts_;
+		QSqlQuery QuerySearch_;
+	public:
+		MailSearchIndex (const QDir&, Account*);
+		~MailSearchIndex ();
+
+		/** Returns whether the index has been filled with the messages
+		 * that were stored before the index was created.
+		 */
+		bool IsBackfilled ();
+
+		/** Marks the index as filled with the previously stored
+		 * messages.
+		 */
+		void SetBackfilled ();
+
+		void Index (const QStringList& folder, const QList<Message_ptr>&);
+
+		/** Schedules removing the message from the index and returns
+		 * immediately.
+		 */
+		void Remove (const QStringList& folder, const QByteArray& id);
+
+		/** Returns the folder IDs of messages in the given folder
+		 * matching all the words in the text, most recent first.
+		 */
+		QList<QByteArray> Search (const QStringList& folder, const QString& text);
+	private:
+		void Post (const std::function<void ()>&);
+		void Run (const std::function<void ()>&);
+
+		void Open (const QString& path);
+		void Close ();
+
+		void RemoveMessage (const QString& folder, const QByteArray& id);
+		void IndexMessage (const QString& folder, const Message_ptr&);
+
+		void InitTables ();
+		void PrepareQueries ();
+	};
+
+	typedef std::shared_ptr<MailSearchIndex> MailSearchIndex_ptr;
+}
+}
@@ -35,6 +35,7 @@
 #include <QMenu>
 #include <QFileDialog>
 #include <QToolButton>
+#include <QFutureWatcher>
 #include <util/util.h>
 #include <util/tags/categoryselector.h>
 #include <util/sys/extensionsdata.h>
@@ -116,6 +117,11 @@ namespace Snails
 				this,
 				SLOT (handleMailSelected ()));
 
+		connect (Ui_.SearchEdit_,
+				SIGNAL (returnPressed ()),
+				this,
+				SLOT (handleSearch ()));
+
 		FillTabToolbarActions ();
 	}
 
@@ -291,6 +297,9 @@ namespace Snails
 
 	void MailTab::handleCurrentAccountChanged (const QModelIndex& idx)
 	{
+		CancelSearch ();
+		Ui_.SearchEdit_->clear ();
+
 		if (CurrAcc_)
 		{
 			disconnect (CurrAcc_.get (),
@@ -372,6 +381,9 @@ namespace Snails
 
 	void MailTab::handleCurrentTagChanged (const QModelIndex& sidx)
 	{
+		CancelSearch ();
+		Ui_.SearchEdit_->clear ();
+
 		const auto& folder = sidx.data (FoldersModel::Role::FolderPath).toStringList ();
 		CurrAcc_->GetMailModelsManager ()->ShowFolder (folder, MailModel_.get ());
 		Ui_.MailTree_->setCurrentIndex ({});
@@ -828,5 +840,56 @@ namespace Snails
 
 		handleMailSelected ();
 	}
+
+	void MailTab::CancelSearch ()
+	{
+		if (!SearchWatcher_)
+			return;
+
+		disconnect (SearchWatcher_,
+				0,
+				this,
+				0);
+		SearchWatcher_->cancel ();
+		SearchWatcher_->deleteLater ();
+		SearchWatcher_ = nullptr;
+	}
+
+	void MailTab::handleSearch ()
+	{
+		if (!CurrAcc_)
+			return;
+
+		CancelSearch ();
+
+		const auto& folder = MailModel_->GetCurrentFolder ();
+		const auto& text = Ui_.SearchEdit_->text ().trimmed ();
+		if (text.isEmpty ())
+		{
+			CurrAcc_->GetMailModelsManager ()->ShowFolder (folder, MailModel_.get ());
+			return;
+		}
+
+		MailModel_->Clear ();
+		MailModel_->SetFolder (folder);
+		Ui_.MailTree_->setCurrentIndex ({});
+		handleMailSelected ();
+
+		SearchWatcher_ = new QFutureWatcher<QList<Message_ptr>> (this);
+		connect (SearchWatcher_,
+				SIGNAL (resultsReadyAt (int, int)),
+				this,
+				SLOT (handleSearchResults (int, int)));
+		SearchWatcher_->setFuture (Core::Instance ().GetStorage ()->Search (CurrAcc_.get (), folder, text));
+	}
+
+	void MailTab::handleSearchResults (int from, int to)
+	{
+		if (sender () != SearchWatcher_)
+			return;
+
+		for (int i = from; i < to; ++i)
+			MailModel_->Append (SearchWatcher_->resultAt (i));
+	}
 }
 }
@@ -40,6 +40,9 @@ class QStandardItem;
 class QSortFilterProxyModel;
 class QToolButton;
 
+template<typename T>
+class QFutureWatcher;
+
 namespace LeechCraft
 {
 namespace Snails
@@ -70,6 +73,8 @@ namespace Snails
 		QSortFilterProxyModel *MailSortFilterModel_;
 		Account_ptr CurrAcc_;
 		Message_ptr CurrMsg_;
+
+		QFutureWatcher<QList<Message_ptr>> *SearchWatcher_ = nullptr;
 	public:
 		MailTab (const ICoreProxy_ptr&, const TabClassInfo&, QObject*, QWidget* = 0);
 
@@ -85,6 +90,8 @@ namespace Snails
 
 		void SetMsgActionsEnabled (bool);
 		QList<Folder> GetActualFolders () const;
+
+		void CancelSearch ();
 	private slots:
 		void handleCurrentAccountChanged (const QModelIndex&);
 		void handleCurrentTagChanged (const QModelIndex&);
@@ -107,6 +114,9 @@ namespace Snails
 		void handleRefreshFolder ();
 
 		void handleMessageBodyFetched (Message_ptr);
+
+		void handleSearch ();
+		void handleSearchResults (int, int);
 	signals:
 		void removeTab (QWidget*);
 
@@ -270,6 +270,40 @@ namespace Snails
 	}
 
 	QByteArray Message::Serialize () const
+	{
+		return Serialize (true);
+	}
+
+	QByteArray Message::SerializeHeaders () const
+	{
+		return Serialize (false);
+	}
+
+	QByteArray Message::SerializeBody () const
+	{
+		QByteArray result;
+
+		QDataStream str (&result, QIODevice::WriteOnly);
+		str << static_cast<quint8> (1)
+			<< Body_
+			<< HTMLBody_;
+
+		return result;
+	}
+
+	void Message::DeserializeBody (const QByteArray& data)
+	{
+		QDataStream str (data);
+		quint8 version = 0;
+		str >> version;
+		if (version != 1)
+			throw std::runtime_error (qPrintable ("Failed to deserialize Message body: unknown version " + QString::number (version)));
+
+		str >> Body_
+			>> HTMLBody_;
+	}
+
+	QByteArray Message::Serialize (bool withBody) const
 	{
 		QByteArray result;
 
@@ -283,8 +317,8 @@ namespace Snails
 			<< Recipients_
 			<< Subject_
 			<< IsRead_
-			<< Body_
-			<< HTMLBody_
+			<< (withBody ? Body_ : QString {})
+			<< (withBody ? HTMLBody_ : QString {})
 			<< InReplyTo_
 			<< References_
 			<< Addresses_
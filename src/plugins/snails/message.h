@@ -144,6 +144,18 @@ namespace Snails
 
 		QByteArray Serialize () const;
 		void Deserialize (const QByteArray&);
+
+		/** @brief Serializes the message without its text bodies.
+		 *
+		 * The result can be passed to Deserialize(), which leaves the
+		 * message bodies empty in this case.
+		 */
+		QByteArray SerializeHeaders () const;
+
+		QByteArray SerializeBody () const;
+		void DeserializeBody (const QByteArray&);
+	private:
+		QByteArray Serialize (bool withBody) const;
 	signals:
 		void readStatusChanged (const QByteArray&, bool);
 	};
@@ -0,0 +1,460 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "messagestore.h"
+#include <stdexcept>
+#include <algorithm>
+#include <QDataStream>
+#include <QFileInfo>
+#include <QSet>
+#include <QtDebug>
+
+namespace LeechCraft
+{
+namespace Snails
+{
+	namespace
+	{
+		const int CompressionLevel = 1;
+		const qint64 MaxSegmentSize = 64 * 1024 * 1024;
+
+		enum class JournalOp : quint8
+		{
+			Put = 1,
+			Remove = 2
+		};
+
+		QByteArray MakeKey (const QStringList& folder, const QByteArray& id)
+		{
+			return folder.join ("/").toUtf8 () + '\n' + id;
+		}
+	}
+
+	MessageStore::MessageStore (const QDir& dir)
+	: Dir_ (dir)
+	, Journal_ (dir.filePath ("journal"))
+	, JournalRecords_ (0)
+	, CurrentSegment_ (0)
+	{
+		for (const auto& name : Dir_.entryList ({ "segment_*.dat" }, QDir::Files))
+		{
+			const auto num = name.section ('_', 1).section ('.', 0, 0).toUInt ();
+			CurrentSegment_ = std::max (CurrentSegment_, num);
+		}
+
+		if (!Journal_.open (QIODevice::ReadWrite))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open journal"
+					<< Journal_.fileName ()
+					<< Journal_.errorString ();
+			throw std::runtime_error ("Unable to open message store journal.");
+		}
+
+		ReplayJournal ();
+		OpenCurrentSegment ();
+
+		CompactSegments ();
+		if (JournalRecords_ > 2 * Index_.size () + 1024)
+			CompactJournal ();
+	}
+
+	void MessageStore::Save (const QStringList& folder, const QList<Message_ptr>& msgs)
+	{
+		QMutexLocker locker (&Mutex_);
+
+		QByteArray journal;
+		QDataStream jstr (&journal, QIODevice::WriteOnly);
+
+		for (const auto& msg : msgs)
+		{
+			if (msg->GetFolderID ().isEmpty ())
+				continue;
+
+			const auto& key = MakeKey (folder, msg->GetFolderID ());
+
+			Entry entry {};
+			const auto pos = Index_.find (key);
+			if (pos != Index_.end ())
+			{
+				entry = *pos;
+				SegmentLiveSizes_ [entry.Header_.Segment_] -= entry.Header_.Length_;
+			}
+
+			entry.Header_ = Append (qCompress (msg->SerializeHeaders (), CompressionLevel));
+
+			// Messages without bodies keep the body saved previously.
+			if (msg->IsFullyFetched ())
+			{
+				if (entry.Body_.Length_)
+					SegmentLiveSizes_ [entry.Body_.Segment_] -= entry.Body_.Length_;
+				entry.Body_ = Append (qCompress (msg->SerializeBody (), CompressionLevel));
+			}
+
+			Index_ [key] = entry;
+
+			jstr << static_cast<quint8> (JournalOp::Put)
+					<< key
+					<< entry.Header_.Segment_ << entry.Header_.Offset_ << entry.Header_.Length_
+					<< entry.Body_.Segment_ << entry.Body_.Offset_ << entry.Body_.Length_;
+			++JournalRecords_;
+		}
+
+		CurrentSegmentFile_.flush ();
+		WriteJournal (journal);
+	}
+
+	Message_ptr MessageStore::Load (const QStringList& folder, const QByteArray& id, bool withBody) const
+	{
+		QMutexLocker locker (&Mutex_);
+
+		const auto pos = Index_.find (MakeKey (folder, id));
+		if (pos == Index_.end ())
+			return {};
+
+		return LoadEntry (*pos, withBody);
+	}
+
+	QList<Message_ptr> MessageStore::LoadAll (bool withBody) const
+	{
+		QMutexLocker locker (&Mutex_);
+
+		QList<Message_ptr> result;
+		result.reserve (Index_.size ());
+		for (const auto& entry : Index_)
+			if (const auto& msg = LoadEntry (entry, withBody))
+				result << msg;
+		return result;
+	}
+
+	void MessageStore::Remove (const QStringList& folder, const QByteArray& id)
+	{
+		QMutexLocker locker (&Mutex_);
+
+		const auto& key = MakeKey (folder, id);
+		const auto pos = Index_.find (key);
+		if (pos == Index_.end ())
+			return;
+
+		SegmentLiveSizes_ [pos->Header_.Segment_] -= pos->Header_.Length_;
+		if (pos->Body_.Length_)
+			SegmentLiveSizes_ [pos->Body_.Segment_] -= pos->Body_.Length_;
+		Index_.erase (pos);
+
+		QByteArray journal;
+		QDataStream jstr (&journal, QIODevice::WriteOnly);
+		jstr << static_cast<quint8> (JournalOp::Remove)
+				<< key;
+		++JournalRecords_;
+		WriteJournal (journal);
+	}
+
+	bool MessageStore::Contains (const QStringList& folder, const QByteArray& id) const
+	{
+		QMutexLocker locker (&Mutex_);
+		return Index_.contains (MakeKey (folder, id));
+	}
+
+	int MessageStore::GetCount () const
+	{
+		QMutexLocker locker (&Mutex_);
+		return Index_.size ();
+	}
+
+	Message_ptr MessageStore::LoadEntry (const Entry& entry, bool withBody) const
+	{
+		const auto& msg = std::make_shared<Message> ();
+		try
+		{
+			msg->Deserialize (qUncompress (Read (entry.Header_)));
+			if (withBody && entry.Body_.Length_)
+				msg->DeserializeBody (qUncompress (Read (entry.Body_)));
+		}
+		catch (const std::exception& e)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "error deserializing the message from segment"
+					<< entry.Header_.Segment_
+					<< e.what ();
+			return {};
+		}
+		return msg;
+	}
+
+	auto MessageStore::Append (const QByteArray& data) -> RecordLocation
+	{
+		if (CurrentSegmentFile_.size () >= MaxSegmentSize)
+		{
+			CurrentSegmentFile_.close ();
+			++CurrentSegment_;
+			OpenCurrentSegment ();
+		}
+
+		const auto offset = CurrentSegmentFile_.size ();
+		if (CurrentSegmentFile_.write (data) != data.size ())
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to write to"
+					<< CurrentSegmentFile_.fileName ()
+					<< CurrentSegmentFile_.errorString ();
+			throw std::runtime_error ("Unable to write message data.");
+		}
+
+		SegmentLiveSizes_ [CurrentSegment_] += data.size ();
+		return { CurrentSegment_, offset, data.size () };
+	}
+
+	QByteArray MessageStore::Read (const RecordLocation& loc) const
+	{
+		auto& file = ReadSegments_ [loc.Segment_];
+		if (!file)
+		{
+			file = std::make_shared<QFile> (GetSegmentPath (loc.Segment_));
+			if (!file->open (QIODevice::ReadOnly))
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unable to open"
+						<< file->fileName ()
+						<< file->errorString ();
+				ReadSegments_.remove (loc.Segment_);
+				throw std::runtime_error ("Unable to open message store segment.");
+			}
+		}
+
+		if (!file->seek (loc.Offset_))
+			throw std::runtime_error ("Unable to seek in message store segment.");
+
+		const auto& data = file->read (loc.Length_);
+		if (data.size () != loc.Length_)
+			throw std::runtime_error ("Truncated message store record.");
+		return data;
+	}
+
+	QString MessageStore::GetSegmentPath (quint32 num) const
+	{
+		return Dir_.filePath (QString ("segment_%1.dat").arg (num, 6, 10, QChar ('0')));
+	}
+
+	void MessageStore::OpenCurrentSegment ()
+	{
+		CurrentSegmentFile_.setFileName (GetSegmentPath (CurrentSegment_));
+		if (!CurrentSegmentFile_.open (QIODevice::WriteOnly | QIODevice::Append))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< CurrentSegmentFile_.fileName ()
+					<< CurrentSegmentFile_.errorString ();
+			throw std::runtime_error ("Unable to open message store segment.");
+		}
+	}
+
+	void MessageStore::ReplayJournal ()
+	{
+		QDataStream jstr (&Journal_);
+
+		qint64 lastGoodPos = 0;
+		while (!jstr.atEnd ())
+		{
+			quint8 op = 0;
+			QByteArray key;
+			jstr >> op >> key;
+
+			switch (static_cast<JournalOp> (op))
+			{
+			case JournalOp::Put:
+			{
+				Entry entry;
+				jstr >> entry.Header_.Segment_ >> entry.Header_.Offset_ >> entry.Header_.Length_
+						>> entry.Body_.Segment_ >> entry.Body_.Offset_ >> entry.Body_.Length_;
+				if (jstr.status () != QDataStream::Ok)
+					break;
+
+				const auto pos = Index_.find (key);
+				if (pos != Index_.end ())
+				{
+					SegmentLiveSizes_ [pos->Header_.Segment_] -= pos->Header_.Length_;
+					SegmentLiveSizes_ [pos->Body_.Segment_] -= pos->Body_.Length_;
+				}
+				SegmentLiveSizes_ [entry.Header_.Segment_] += entry.Header_.Length_;
+				SegmentLiveSizes_ [entry.Body_.Segment_] += entry.Body_.Length_;
+				Index_ [key] = entry;
+				break;
+			}
+			case JournalOp::Remove:
+			{
+				if (jstr.status () != QDataStream::Ok)
+					break;
+
+				const auto pos = Index_.find (key);
+				if (pos != Index_.end ())
+				{
+					SegmentLiveSizes_ [pos->Header_.Segment_] -= pos->Header_.Length_;
+					SegmentLiveSizes_ [pos->Body_.Segment_] -= pos->Body_.Length_;
+					Index_.erase (pos);
+				}
+				break;
+			}
+			default:
+				jstr.setStatus (QDataStream::ReadCorruptData);
+				break;
+			}
+
+			if (jstr.status () != QDataStream::Ok)
+				break;
+
+			lastGoodPos = Journal_.pos ();
+			++JournalRecords_;
+		}
+
+		if (lastGoodPos != Journal_.size ())
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "dropping incomplete journal tail at"
+					<< lastGoodPos
+					<< "of"
+					<< Journal_.size ();
+			Journal_.resize (lastGoodPos);
+		}
+		Journal_.seek (lastGoodPos);
+	}
+
+	void MessageStore::WriteJournal (const QByteArray& data)
+	{
+		Journal_.seek (Journal_.size ());
+		if (Journal_.write (data) != data.size ())
+			qWarning () << Q_FUNC_INFO
+					<< "unable to write journal"
+					<< Journal_.errorString ();
+		Journal_.flush ();
+	}
+
+	void MessageStore::CompactJournal ()
+	{
+		QFile newJournal (Journal_.fileName () + ".new");
+		if (!newJournal.open (QIODevice::WriteOnly | QIODevice::Truncate))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< newJournal.fileName ()
+					<< newJournal.errorString ();
+			return;
+		}
+
+		QDataStream jstr (&newJournal);
+		for (auto i = Index_.begin (); i != Index_.end (); ++i)
+			jstr << static_cast<quint8> (JournalOp::Put)
+					<< i.key ()
+					<< i->Header_.Segment_ << i->Header_.Offset_ << i->Header_.Length_
+					<< i->Body_.Segment_ << i->Body_.Offset_ << i->Body_.Length_;
+		newJournal.close ();
+
+		Journal_.close ();
+		QFile::remove (Journal_.fileName ());
+		newJournal.rename (Journal_.fileName ());
+		if (!Journal_.open (QIODevice::ReadWrite))
+			throw std::runtime_error ("Unable to reopen message store journal.");
+
+		JournalRecords_ = Index_.size ();
+	}
+
+	void MessageStore::CompactSegments ()
+	{
+		QSet<quint32> sparse;
+		for (const auto& name : Dir_.entryList ({ "segment_*.dat" }, QDir::Files))
+		{
+			const auto num = name.section ('_', 1).section ('.', 0, 0).toUInt ();
+			if (num == CurrentSegment_)
+				continue;
+
+			const auto size = QFileInfo (Dir_.filePath (name)).size ();
+			if (SegmentLiveSizes_.value (num) * 4 < size)
+				sparse << num;
+		}
+
+		if (sparse.isEmpty ())
+			return;
+
+		qDebug () << Q_FUNC_INFO
+				<< "compacting segments"
+				<< sparse
+				<< "in"
+				<< Dir_.path ();
+
+		QByteArray journal;
+		QDataStream jstr (&journal, QIODevice::WriteOnly);
+
+		auto relocate = [this, &sparse] (RecordLocation& loc) -> bool
+		{
+			if (!loc.Length_ || !sparse.contains (loc.Segment_))
+				return false;
+
+			const auto& data = Read (loc);
+			SegmentLiveSizes_ [loc.Segment_] -= loc.Length_;
+			loc = Append (data);
+			return true;
+		};
+
+		for (auto i = Index_.begin (); i != Index_.end (); ++i)
+		{
+			try
+			{
+				const bool headerMoved = relocate (i->Header_);
+				const bool bodyMoved = relocate (i->Body_);
+				if (!headerMoved && !bodyMoved)
+					continue;
+			}
+			catch (const std::exception& e)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unable to move record, aborting compaction:"
+						<< e.what ();
+				CurrentSegmentFile_.flush ();
+				WriteJournal (journal);
+				return;
+			}
+
+			jstr << static_cast<quint8> (JournalOp::Put)
+					<< i.key ()
+					<< i->Header_.Segment_ << i->Header_.Offset_ << i->Header_.Length_
+					<< i->Body_.Segment_ << i->Body_.Offset_ << i->Body_.Length_;
+			++JournalRecords_;
+		}
+
+		CurrentSegmentFile_.flush ();
+		WriteJournal (journal);
+
+		for (const auto num : sparse)
+		{
+			ReadSegments_.remove (num);
+			SegmentLiveSizes_.remove (num);
+			QFile::remove (GetSegmentPath (num));
+		}
+	}
+}
+}
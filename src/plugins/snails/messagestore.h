@@ -0,0 +1,106 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <QHash>
+#include <QDir>
+#include <QFile>
+#include <QMutex>
+#include <QStringList>
+#include "message.h"
+
+namespace LeechCraft
+{
+namespace Snails
+{
+	/* Log-structured per-account message store.
+	 *
+	 * Message headers and bodies are appended as separate compressed
+	 * records to a sequence of segment files. The location of each
+	 * (folder, folder-local ID) pair is written to an append-only
+	 * journal which is replayed into an in-memory index on startup.
+	 *
+	 * All the methods are thread-safe.
+	 */
+	class MessageStore
+	{
+		const QDir Dir_;
+
+		mutable QMutex Mutex_;
+
+		struct RecordLocation
+		{
+			quint32 Segment_;
+			qint64 Offset_;
+			qint32 Length_;
+		};
+
+		struct Entry
+		{
+			RecordLocation Header_;
+			RecordLocation Body_;
+		};
+		QHash<QByteArray, Entry> Index_;
+		QHash<quint32, qint64> SegmentLiveSizes_;
+
+		QFile Journal_;
+		qint64 JournalRecords_;
+
+		quint32 CurrentSegment_;
+		QFile CurrentSegmentFile_;
+		mutable QHash<quint32, std::shared_ptr<QFile>> ReadSegments_;
+	public:
+		MessageStore (const QDir&);
+
+		void Save (const QStringList& folder, const QList<Message_ptr>&);
+		Message_ptr Load (const QStringList& folder, const QByteArray& id, bool withBody) const;
+		QList<Message_ptr> LoadAll (bool withBody) const;
+		void Remove (const QStringList& folder, const QByteArray& id);
+
+		bool Contains (const QStringList& folder, const QByteArray& id) const;
+		int GetCount () const;
+	private:
+		Message_ptr LoadEntry (const Entry&, bool withBody) const;
+
+		RecordLocation Append (const QByteArray&);
+		QByteArray Read (const RecordLocation&) const;
+		QString GetSegmentPath (quint32) const;
+		void OpenCurrentSegment ();
+
+		void ReplayJournal ();
+		void WriteJournal (const QByteArray&);
+		void CompactJournal ();
+		void CompactSegments ();
+	};
+
+	typedef std::shared_ptr<MessageStore> MessageStore_ptr;
+}
+}
@@ -29,6 +29,7 @@
 
 #include "progressmanager.h"
 #include <QStandardItemModel>
+#include <QTimer>
 #include <QtDebug>
 #include "account.h"
 
@@ -39,8 +40,15 @@ namespace Snails
 	ProgressManager::ProgressManager (QObject *parent)
 	: QObject (parent)
 	, Model_ (new QStandardItemModel)
+	, ElapsedUpdateTimer_ (new QTimer (this))
 	{
 		Model_->setColumnCount (3);
+
+		ElapsedUpdateTimer_->setInterval (1000);
+		connect (ElapsedUpdateTimer_,
+				SIGNAL (timeout ()),
+				this,
+				SLOT (updateElapsed ()));
 	}
 
 	QAbstractItemModel* ProgressManager::GetRepresentation () const
@@ -77,10 +85,29 @@ namespace Snails
 		Model_->appendRow (row);
 
 		Listener2Row_ [pl] = row.last ();
+
+		auto& info = Listener2Info_ [pl];
+		info.Context_ = pl->GetContext ();
+		info.StateItem_ = row.at (1);
+		info.Timer_.start ();
+
+		if (!ElapsedUpdateTimer_->isActive ())
+			ElapsedUpdateTimer_->start ();
 	}
 
 	void ProgressManager::handlePLDestroyed (QObject *obj)
 	{
+		const auto& info = Listener2Info_.take (obj);
+		if (info.StateItem_)
+			qDebug () << Q_FUNC_INFO
+					<< info.Context_
+					<< "took"
+					<< info.Timer_.elapsed ()
+					<< "ms";
+
+		if (Listener2Info_.isEmpty ())
+			ElapsedUpdateTimer_->stop ();
+
 		QStandardItem *item = Listener2Row_.take (obj);
 		if (!item)
 			return;
@@ -96,5 +123,12 @@ namespace Snails
 
 		item->setText (QString ("%1/%2").arg (done).arg (total));
 	}
+
+	void ProgressManager::updateElapsed ()
+	{
+		for (const auto& info : Listener2Info_)
+			info.StateItem_->setText (tr ("Running for %n second(s)...", 0,
+						static_cast<int> (info.Timer_.elapsed () / 1000)));
+	}
 }
 }
@@ -31,11 +31,13 @@
 
 #include <QObject>
 #include <QMap>
+#include <QElapsedTimer>
 #include "progresslistener.h"
 
 class QAbstractItemModel;
 class QStandardItemModel;
 class QStandardItem;
+class QTimer;
 
 namespace LeechCraft
 {
@@ -49,6 +51,16 @@ namespace Snails
 
 		QStandardItemModel *Model_;
 		QMap<QObject*, QStandardItem*> Listener2Row_;
+
+		struct RunningInfo
+		{
+			QString Context_;
+			QStandardItem *StateItem_ = nullptr;
+			QElapsedTimer Timer_;
+		};
+		QMap<QObject*, RunningInfo> Listener2Info_;
+
+		QTimer * const ElapsedUpdateTimer_;
 	public:
 		ProgressManager (QObject* = 0);
 
@@ -58,6 +70,7 @@ namespace Snails
 		void handlePL (ProgressListener_g_ptr);
 		void handlePLDestroyed (QObject*);
 		void handleProgress (size_t, size_t);
+		void updateElapsed ();
 	};
 }
 }
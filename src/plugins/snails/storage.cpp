@@ -36,11 +36,16 @@
 #include <QSqlError>
 #include <QtConcurrentRun>
 #include <QFutureWatcher>
+#include <QFutureInterface>
 #include <util/db/dblock.h>
 #include <util/sys/paths.h>
+#include <util/sll/slotclosure.h>
 #include "xmlsettingsmanager.h"
 #include "account.h"
 #include "accountdatabase.h"
+#include "messagestore.h"
+#include "mailsearchindex.h"
+#include "folder.h"
 
 namespace LeechCraft
 {
@@ -68,52 +73,40 @@ namespace Snails
 
 	namespace
 	{
-		QList<Message_ptr> MessageSaverProc (QList<Message_ptr> msgs, const QDir dir)
+		QList<Message_ptr> MessageSaverProc (QList<Message_ptr> msgs,
+				const QStringList& folder, const MessageStore_ptr& store, const MailSearchIndex_ptr& index)
 		{
-			for (const auto& msg : msgs)
+			try
 			{
-				if (msg->GetFolderID ().isEmpty ())
-					continue;
-
-				const QString dirName = msg->GetFolderID ().toHex ().right (3);
+				store->Save (folder, msgs);
+			}
+			catch (const std::exception& e)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unable to save messages:"
+						<< e.what ();
+			}
 
-				QDir msgDir = dir;
-				if (!dir.exists (dirName))
-					msgDir.mkdir (dirName);
-				if (!msgDir.cd (dirName))
+			if (index)
+				try
+				{
+					index->Index (folder, msgs);
+				}
+				catch (const std::exception& e)
 				{
 					qWarning () << Q_FUNC_INFO
-							<< "unable to cd into"
-							<< msgDir.filePath (dirName);
-					continue;
+							<< "unable to index messages:"
+							<< e.what ();
 				}
 
-				QFile file (msgDir.filePath (msg->GetFolderID ().toHex ()));
-				file.open (QIODevice::WriteOnly);
-				file.write (qCompress (msg->Serialize (), 9));
-			}
-
 			return msgs;
 		}
 	}
 
 	void Storage::SaveMessages (Account *acc, const QStringList& folder, const QList<Message_ptr>& msgs)
 	{
-		auto dir = DirForAccount (acc);
-		for (const auto& elem : folder)
-		{
-			const auto& subdir = elem.toUtf8 ().toHex ();
-			if (!dir.exists (subdir))
-				dir.mkdir (subdir);
-
-			if (!dir.cd (subdir))
-			{
-				qWarning () << Q_FUNC_INFO
-						<< "unable to cd to"
-						<< dir.filePath (subdir);
-				throw std::runtime_error ("Unable to cd to the directory");
-			}
-		}
+		const auto& store = StoreForAccount (acc);
+		const auto& index = IndexForAccount (acc);
 
 		for (const auto& msg : msgs)
 			PendingSaveMessages_ [acc] [msg->GetFolderID ()] = msg;
@@ -125,7 +118,7 @@ namespace Snails
 				SIGNAL (finished ()),
 				this,
 				SLOT (handleMessagesSaved ()));
-		auto future = QtConcurrent::run (MessageSaverProc, msgs, dir);
+		auto future = QtConcurrent::run (MessageSaverProc, msgs, folder, store, index);
 		watcher->setFuture (future);
 
 		for (const auto& msg : msgs)
@@ -142,46 +135,10 @@ namespace Snails
 	{
 		MessageSet result;
 
-		const QDir& dir = DirForAccount (acc);
-		for (const auto& str : dir.entryList (QDir::NoDotAndDotDot | QDir::Dirs))
+		for (const auto& msg : StoreForAccount (acc)->LoadAll (false))
 		{
-			QDir subdir = dir;
-			if (!subdir.cd (str))
-			{
-				qWarning () << Q_FUNC_INFO
-						<< "unable to cd to"
-						<< str;
-				continue;
-			}
-
-			for (const auto& str : subdir.entryList (QDir::NoDotAndDotDot | QDir::Files))
-			{
-				QFile file (subdir.filePath (str));
-				if (!file.open (QIODevice::ReadOnly))
-				{
-					qWarning () << Q_FUNC_INFO
-							<< "unable to open"
-							<< str
-							<< file.errorString ();
-					continue;
-				}
-
-				const auto& msg = std::make_shared<Message> ();
-				try
-				{
-					msg->Deserialize (qUncompress (file.readAll ()));
-				}
-				catch (const std::exception& e)
-				{
-					qWarning () << Q_FUNC_INFO
-							<< "error deserializing the message from"
-							<< file.fileName ()
-							<< e.what ();
-					continue;
-				}
-				result << msg;
-				UpdateCaches (msg);
-			}
+			result << msg;
+			UpdateCaches (msg);
 		}
 
 		for (const auto& msg : PendingSaveMessages_ [acc])
@@ -198,53 +155,44 @@ namespace Snails
 		if (PendingSaveMessages_ [acc].contains (id))
 			return PendingSaveMessages_ [acc] [id];
 
-		auto dir = DirForAccount (acc);
-		for (const auto& elem : folder)
-		{
-			const auto& subdir = elem.toUtf8 ().toHex ();
-			if (!dir.cd (subdir))
-			{
-				qWarning () << Q_FUNC_INFO
-						<< "unable to cd to"
-						<< dir.filePath (subdir);
-				throw std::runtime_error ("Unable to cd to the directory");
-			}
-		}
-
-		if (!dir.cd (id.toHex ().right (3)))
+		const auto& msg = StoreForAccount (acc)->Load (folder, id, true);
+		if (!msg)
 		{
 			qWarning () << Q_FUNC_INFO
-					<< "unable to cd to"
-					<< dir.filePath (id.toHex ().right (3));
-			throw std::runtime_error ("Unable to cd to the directory");
+					<< "unable to load message"
+					<< id.toHex ()
+					<< "from"
+					<< folder;
+			throw std::runtime_error ("Unable to load the message");
 		}
 
-		QFile file (dir.filePath (id.toHex ()));
-		if (!file.open (QIODevice::ReadOnly))
-		{
-			qWarning () << Q_FUNC_INFO
-					<< "unable to open"
-					<< file.fileName ()
-					<< file.errorString ();
-			throw std::runtime_error ("Unable to open the message file");
-		}
+		UpdateCaches (msg);
+		return msg;
+	}
 
-		Message_ptr msg (new Message);
-		try
-		{
-			msg->Deserialize (qUncompress (file.readAll ()));
-			UpdateCaches (msg);
-		}
-		catch (const std::exception& e)
+	QList<Message_ptr> Storage::LoadMessageHeaders (Account *acc,
+			const QStringList& folder, const QList<QByteArray>& ids)
+	{
+		const auto& pending = PendingSaveMessages_ [acc];
+		const auto& store = StoreForAccount (acc);
+
+		QList<Message_ptr> result;
+		result.reserve (ids.size ());
+		for (const auto& id : ids)
 		{
-			qWarning () << Q_FUNC_INFO
-					<< "error deserializing the message from"
-					<< file.fileName ()
-					<< e.what ();
-			throw;
-		}
+			if (pending.contains (id))
+			{
+				result << pending [id];
+				continue;
+			}
 
-		return msg;
+			if (const auto& msg = store->Load (folder, id, false))
+			{
+				result << msg;
+				UpdateCaches (msg);
+			}
+		}
+		return result;
 	}
 
 	QList<QByteArray> Storage::LoadIDs (Account *acc, const QStringList& folder)
@@ -252,34 +200,59 @@ namespace Snails
 		return BaseForAccount (acc)->GetIDs (folder);
 	}
 
+	QHash<QByteArray, bool> Storage::LoadReadStatuses (Account *acc, const QStringList& folder)
+	{
+		return BaseForAccount (acc)->GetReadStatuses (folder);
+	}
+
 	void Storage::RemoveMessage (Account *acc, const QStringList& folder, const QByteArray& id)
 	{
 		PendingSaveMessages_ [acc].remove (id);
 
+		const auto& store = StoreForAccount (acc);
 		BaseForAccount (acc)->RemoveMessage (id, folder,
-				[this, acc, folder, id] { RemoveMessageFile (acc, folder, id); });
+				[store, folder, id] { store->Remove (folder, id); });
+
+		if (const auto& index = IndexForAccount (acc))
+			index->Remove (folder, id);
 	}
 
-	int Storage::GetNumMessages (Account *acc) const
+	QFuture<QList<Message_ptr>> Storage::Search (Account *acc, const QStringList& folder, const QString& text)
 	{
-		int result = 0;
+		QFutureInterface<QList<Message_ptr>> iface;
+		iface.reportStarted ();
 
-		const QDir& dir = DirForAccount (acc);
-		for (const auto& str : dir.entryList (QDir::NoDotAndDotDot | QDir::Dirs))
+		const auto& index = IndexForAccount (acc);
+		if (!index)
 		{
-			QDir subdir = dir;
-			if (!subdir.cd (str))
-			{
-				qWarning () << Q_FUNC_INFO
-						<< "unable to cd to"
-						<< str;
-				continue;
-			}
-
-			result += subdir.entryList (QDir::NoDotAndDotDot | QDir::Files).size ();
+			iface.reportFinished ();
+			return iface.future ();
 		}
 
-		return result;
+		const auto& store = StoreForAccount (acc);
+		QtConcurrent::run ([iface, index, store, folder, text] () mutable
+				{
+					const auto& ids = index->Search (folder, text);
+
+					const auto chunkSize = 50;
+					int resultIdx = 0;
+					for (int i = 0; i < ids.size () && !iface.isCanceled (); i += chunkSize)
+					{
+						QList<Message_ptr> chunk;
+						for (const auto& id : ids.mid (i, chunkSize))
+							if (const auto& msg = store->Load (folder, id, false))
+								chunk << msg;
+						iface.reportResult (chunk, resultIdx++);
+					}
+
+					iface.reportFinished ();
+				});
+		return iface.future ();
+	}
+
+	int Storage::GetNumMessages (Account *acc)
+	{
+		return StoreForAccount (acc)->GetCount ();
 	}
 
 	int Storage::GetNumMessages (Account *acc, const QStringList& folder)
@@ -292,7 +265,7 @@ namespace Snails
 		return BaseForAccount (acc)->GetUnreadMessageCount (folder);
 	}
 
-	bool Storage::HasMessagesIn (Account *acc) const
+	bool Storage::HasMessagesIn (Account *acc)
 	{
 		return GetNumMessages (acc);
 	}
@@ -305,41 +278,14 @@ namespace Snails
 		return LoadMessage (acc, folder, id)->IsRead ();
 	}
 
-	void Storage::RemoveMessageFile (Account *acc, const QStringList& folder, const QByteArray& id)
+	boost::optional<FolderSyncState> Storage::GetFolderSyncState (Account *acc, const QStringList& folder)
 	{
-		auto dir = DirForAccount (acc);
-		for (const auto& elem : folder)
-		{
-			const auto& subdir = elem.toUtf8 ().toHex ();
-			if (!dir.cd (subdir))
-			{
-				qWarning () << Q_FUNC_INFO
-						<< "unable to cd to"
-						<< dir.filePath (subdir);
-				throw std::runtime_error ("Unable to cd to the directory");
-			}
-		}
-
-		if (!dir.cd (id.toHex ().right (3)))
-		{
-			qWarning () << Q_FUNC_INFO
-					<< "unable to cd to"
-					<< dir.filePath (id.toHex ().right (3));
-			throw std::runtime_error ("Unable to cd to the directory");
-		}
-
-		QFile file (dir.filePath (id.toHex ()));
-		if (!file.exists ())
-			return;
+		return BaseForAccount (acc)->GetFolderSyncState (folder);
+	}
 
-		qDebug () << "removing" << file.fileName () << file.size ();
-		if (!file.remove ())
-		{
-			qWarning () << Q_FUNC_INFO
-					<< "unable to remove the file:"
-					<< file.errorString ();
-			throw std::runtime_error ("Unable to remove the file");
-		}
+	void Storage::SetFolderSyncState (Account *acc, const QStringList& folder, const FolderSyncState& state)
+	{
+		BaseForAccount (acc)->SetFolderSyncState (folder, state);
 	}
 
 	QDir Storage::DirForAccount (Account *acc) const
@@ -362,6 +308,7 @@ namespace Snails
 
 	AccountDatabase_ptr Storage::BaseForAccount (Account *acc)
 	{
+		QMutexLocker locker (&AccountBasesMutex_);
 		if (AccountBases_.contains (acc))
 			return AccountBases_ [acc];
 
@@ -371,6 +318,309 @@ namespace Snails
 		return base;
 	}
 
+	namespace
+	{
+		const QString MigrationMarker = "legacy_migrated";
+
+		/* Legacy message buckets are named by the last three hex digits
+		 * of the message ID (or less for short IDs) and contain the
+		 * message files named by the full hex ID, while folder
+		 * directories contain only subdirectories.
+		 */
+		bool IsLegacyBucket (const QDir& dir, const QString& name)
+		{
+			for (const auto& file : dir.entryList (QDir::NoDotAndDotDot | QDir::Files))
+				if (file.endsWith (name, Qt::CaseInsensitive))
+					return true;
+			return false;
+		}
+
+		/* Returns whether all the messages in the bucket have been
+		 * migrated. The files that failed to import are kept, so that
+		 * the next run retries them.
+		 */
+		bool MigrateLegacyBucket (QDir dir, const QStringList& folder, MessageStore& store)
+		{
+			const auto& files = dir.entryList (QDir::NoDotAndDotDot | QDir::Files);
+
+			QStringList migrated;
+			QStringList imported;
+			QList<Message_ptr> msgs;
+			for (const auto& file : files)
+			{
+				// Already imported before an interrupted migration.
+				if (store.Contains (folder, QByteArray::fromHex (file.toLatin1 ())))
+				{
+					migrated << file;
+					continue;
+				}
+
+				QFile msgFile (dir.filePath (file));
+				if (!msgFile.open (QIODevice::ReadOnly))
+				{
+					qWarning () << Q_FUNC_INFO
+							<< "unable to open"
+							<< msgFile.fileName ()
+							<< msgFile.errorString ();
+					continue;
+				}
+
+				const auto& msg = std::make_shared<Message> ();
+				try
+				{
+					msg->Deserialize (qUncompress (msgFile.readAll ()));
+				}
+				catch (const std::exception& e)
+				{
+					qWarning () << Q_FUNC_INFO
+							<< "error deserializing the message from"
+							<< msgFile.fileName ()
+							<< e.what ();
+					continue;
+				}
+				msgs << msg;
+				imported << file;
+			}
+
+			store.Save (folder, msgs);
+			migrated += imported;
+
+			for (const auto& file : migrated)
+				dir.remove (file);
+
+			return migrated.size () == files.size ();
+		}
+
+		bool MigrateLegacyMessages (QDir dir, const QStringList& folder, MessageStore& store)
+		{
+			bool complete = true;
+			for (const auto& name : dir.entryList (QDir::NoDotAndDotDot | QDir::Dirs))
+			{
+				if (folder.isEmpty () && name == "store")
+					continue;
+
+				QDir subdir = dir;
+				if (!subdir.cd (name))
+				{
+					complete = false;
+					continue;
+				}
+
+				if (IsLegacyBucket (subdir, name))
+					complete = MigrateLegacyBucket (subdir, folder, store) && complete;
+				else
+				{
+					const auto& component = QString::fromUtf8 (QByteArray::fromHex (name.toLatin1 ()));
+					complete = MigrateLegacyMessages (subdir, folder + QStringList { component }, store) && complete;
+				}
+
+				dir.rmdir (name);
+			}
+			return complete;
+		}
+
+		void MigrateAccount (QDir dir, QDir storeDir, MessageStore_ptr store, const QString& accName)
+		{
+			try
+			{
+				if (!MigrateLegacyMessages (dir, {}, *store))
+				{
+					qWarning () << Q_FUNC_INFO
+							<< "some messages of"
+							<< accName
+							<< "failed to migrate, will retry on next start";
+					return;
+				}
+			}
+			catch (const std::exception& e)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unable to migrate messages of"
+						<< accName
+						<< e.what ();
+				return;
+			}
+
+			QFile marker (storeDir.filePath (MigrationMarker));
+			if (!marker.open (QIODevice::WriteOnly))
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unable to create migration marker"
+						<< marker.fileName ()
+						<< marker.errorString ();
+				return;
+			}
+
+			qDebug () << Q_FUNC_INFO
+					<< "migrated messages of"
+					<< accName;
+		}
+	}
+
+	MessageStore_ptr Storage::StoreForAccount (Account *acc)
+	{
+		QMutexLocker locker (&AccountStoresMutex_);
+		if (AccountStores_.contains (acc))
+			return AccountStores_ [acc];
+
+		auto dir = DirForAccount (acc);
+		if (!dir.exists ("store"))
+			dir.mkdir ("store");
+
+		QDir storeDir = dir;
+		if (!storeDir.cd ("store"))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to cd into"
+					<< dir.filePath ("store");
+			throw std::runtime_error ("Unable to cd to the dir");
+		}
+
+		const auto& store = std::make_shared<MessageStore> (storeDir);
+
+		// The marker is written only after the whole legacy layout has
+		// been imported, so an interrupted migration is resumed.
+		if (!storeDir.exists (MigrationMarker))
+		{
+			qDebug () << Q_FUNC_INFO
+					<< "migrating messages of"
+					<< acc->GetName ()
+					<< "to the packed storage";
+			AccountMigrations_ [acc] = QtConcurrent::run (MigrateAccount,
+					dir, storeDir, store, acc->GetName ());
+
+			// This might be called from the account threads, while the
+			// watcher should live in our thread.
+			QMetaObject::invokeMethod (this,
+					"watchMigration",
+					Qt::QueuedConnection,
+					Q_ARG (QObject*, acc));
+		}
+
+		AccountStores_ [acc] = store;
+		return store;
+	}
+
+	namespace
+	{
+		void BackfillSearchIndex (const MailSearchIndex_ptr& index,
+				const MessageStore_ptr& store, QFuture<void> migration)
+		{
+			// The messages being migrated from the legacy layout should
+			// be indexed as well.
+			migration.waitForFinished ();
+
+			QStringList batchFolder;
+			QList<Message_ptr> batch;
+			bool failed = false;
+
+			auto flush = [&]
+			{
+				if (batch.isEmpty ())
+					return;
+
+				try
+				{
+					index->Index (batchFolder, batch);
+				}
+				catch (const std::exception& e)
+				{
+					qWarning () << Q_FUNC_INFO
+							<< "unable to index messages:"
+							<< e.what ();
+					failed = true;
+				}
+				batch.clear ();
+			};
+
+			for (const auto& header : store->LoadAll (false))
+				for (const auto& folder : header->GetFolders ())
+				{
+					const auto& msg = store->Load (folder, header->GetFolderID (), true);
+					if (!msg)
+						continue;
+
+					if (folder != batchFolder || batch.size () >= 100)
+					{
+						flush ();
+						batchFolder = folder;
+					}
+					batch << msg;
+				}
+
+			flush ();
+
+			// Already indexed messages are skipped quickly, so an
+			// interrupted or failed backfill is just restarted later.
+			if (failed)
+				return;
+
+			try
+			{
+				index->SetBackfilled ();
+			}
+			catch (const std::exception& e)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unable to mark the index as complete:"
+						<< e.what ();
+			}
+		}
+	}
+
+	MailSearchIndex_ptr Storage::IndexForAccount (Account *acc)
+	{
+		QMutexLocker locker (&AccountIndexesMutex_);
+		if (AccountIndexes_.contains (acc))
+			return AccountIndexes_ [acc];
+
+		MailSearchIndex_ptr index;
+		try
+		{
+			index = std::make_shared<MailSearchIndex> (DirForAccount (acc), acc);
+		}
+		catch (const std::exception& e)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to create search index for"
+					<< acc->GetName ()
+					<< e.what ();
+		}
+
+		AccountIndexes_ [acc] = index;
+
+		bool backfilled = true;
+		if (index)
+			try
+			{
+				backfilled = index->IsBackfilled ();
+			}
+			catch (const std::exception& e)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< e.what ();
+			}
+
+		if (!backfilled)
+		{
+			qDebug () << Q_FUNC_INFO
+					<< "building search index for"
+					<< acc->GetName ();
+
+			const auto& store = StoreForAccount (acc);
+
+			QFuture<void> migration;
+			{
+				QMutexLocker storesLocker (&AccountStoresMutex_);
+				migration = AccountMigrations_.value (acc);
+			}
+
+			QtConcurrent::run (BackfillSearchIndex, index, store, migration);
+		}
+
+		return index;
+	}
+
 	void Storage::AddMessage (Message_ptr msg, Account *acc)
 	{
 		const auto& base = BaseForAccount (acc);
@@ -382,6 +632,31 @@ namespace Snails
 		IsMessageRead_ [msg->GetFolderID ()] = msg->IsRead ();
 	}
 
+	void Storage::watchMigration (QObject *accObj)
+	{
+		const auto acc = static_cast<Account*> (accObj);
+
+		QFuture<void> migration;
+		{
+			QMutexLocker storesLocker (&AccountStoresMutex_);
+			migration = AccountMigrations_.value (acc);
+		}
+
+		auto watcher = new QFutureWatcher<void> (this);
+		new Util::SlotClosure<Util::DeleteLaterPolicy>
+		{
+			[this, watcher, acc] () -> void
+			{
+				watcher->deleteLater ();
+				emit accountMigrated (acc);
+			},
+			watcher,
+			SIGNAL (finished ()),
+			watcher
+		};
+		watcher->setFuture (migration);
+	}
+
 	void Storage::handleMessagesSaved ()
 	{
 		auto watcher = dynamic_cast<QFutureWatcher<QList<Message_ptr>>*> (sender ());
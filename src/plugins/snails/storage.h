@@ -34,6 +34,9 @@
 #include <QSettings>
 #include <QHash>
 #include <QSet>
+#include <QMutex>
+#include <QFuture>
+#include <boost/optional.hpp>
 #include "message.h"
 
 namespace LeechCraft
@@ -41,10 +44,17 @@ namespace LeechCraft
 namespace Snails
 {
 	class Account;
+	struct FolderSyncState;
 
 	class AccountDatabase;
 	typedef std::shared_ptr<AccountDatabase> AccountDatabase_ptr;
 
+	class MessageStore;
+	typedef std::shared_ptr<MessageStore> MessageStore_ptr;
+
+	class MailSearchIndex;
+	typedef std::shared_ptr<MailSearchIndex> MailSearchIndex_ptr;
+
 	class Storage : public QObject
 	{
 		Q_OBJECT
@@ -53,8 +63,16 @@ namespace Snails
 		QSettings Settings_;
 		QHash<QByteArray, bool> IsMessageRead_;
 
+		QMutex AccountBasesMutex_;
 		QHash<Account*, AccountDatabase_ptr> AccountBases_;
+
+		QMutex AccountStoresMutex_;
+		QHash<Account*, MessageStore_ptr> AccountStores_;
 		QHash<Account*, QHash<QByteArray, Message_ptr>> PendingSaveMessages_;
+		QHash<Account*, QFuture<void>> AccountMigrations_;
+
+		QMutex AccountIndexesMutex_;
+		QHash<Account*, MailSearchIndex_ptr> AccountIndexes_;
 
 		QHash<QObject*, Account*> FutureWatcher2Account_;
 	public:
@@ -63,25 +81,44 @@ namespace Snails
 		void SaveMessages (Account*, const QStringList& folders, const QList<Message_ptr>&);
 		MessageSet LoadMessages (Account*);
 		Message_ptr LoadMessage (Account*, const QStringList& folder, const QByteArray& id);
+		QList<Message_ptr> LoadMessageHeaders (Account*, const QStringList& folder, const QList<QByteArray>& ids);
 		QList<QByteArray> LoadIDs (Account*, const QStringList& folder);
+		QHash<QByteArray, bool> LoadReadStatuses (Account*, const QStringList& folder);
 		void RemoveMessage (Account*, const QStringList&, const QByteArray&);
 
-		int GetNumMessages (Account*) const;
+		/** Searches the local full-text index of the given folder.
+		 *
+		 * Message headers are reported in chunks as they are loaded.
+		 */
+		QFuture<QList<Message_ptr>> Search (Account*, const QStringList& folder, const QString& text);
+
+		int GetNumMessages (Account*);
 		int GetNumMessages (Account*, const QStringList& folder);
 		int GetNumUnread (Account*, const QStringList& folder);
-		bool HasMessagesIn (Account*) const;
+		bool HasMessagesIn (Account*);
 
 		bool IsMessageRead (Account*, const QStringList& folder, const QByteArray&);
-	private:
-		void RemoveMessageFile (Account*, const QStringList&, const QByteArray&);
+
+		boost::optional<FolderSyncState> GetFolderSyncState (Account*, const QStringList& folder);
+		void SetFolderSyncState (Account*, const QStringList& folder, const FolderSyncState&);
 	private:
 		QDir DirForAccount (Account*) const;
 		AccountDatabase_ptr BaseForAccount (Account*);
+		MessageStore_ptr StoreForAccount (Account*);
+		MailSearchIndex_ptr IndexForAccount (Account*);
 
 		void AddMessage (Message_ptr, Account*);
 		void UpdateCaches (Message_ptr);
 	private slots:
+		void watchMigration (QObject*);
 		void handleMessagesSaved ();
+	signals:
+		/** Emitted when the messages of the given account have been
+		 * migrated from the legacy storage layout.
+		 *
+		 * The messages loaded before this signal might be incomplete.
+		 */
+		void accountMigrated (Account*);
 	};
 }
 }
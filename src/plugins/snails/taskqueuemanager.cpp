@@ -28,6 +28,7 @@
  **********************************************************************/
 
 #include "taskqueuemanager.h"
+#include <algorithm>
 #include <QMutexLocker>
 #include "accountthreadworker.h"
 #include "concurrentexceptions.h"
@@ -67,60 +68,109 @@ namespace Snails
 				left.Args_ == right.Args_;
 	}
 
-	TaskQueueManager::TaskQueueManager (AccountThreadWorker *worker)
-	: ATW_ { worker }
+	namespace
 	{
-		connect (this,
-				SIGNAL (gotTask ()),
-				this,
-				SLOT (rotateTaskQueue ()),
-				Qt::QueuedConnection);
+		bool PriorityLess (const TaskQueueItem& left, const TaskQueueItem& right)
+		{
+			return left.Priority_ < right.Priority_;
+		}
 	}
 
-	void TaskQueueManager::AddTasks (QList<TaskQueueItem> items)
+	void TaskQueue::AddTasks (QList<TaskQueueItem> items)
 	{
-		bool shouldRotateQueue = false;
 		{
 			QMutexLocker locker { &ItemsMutex_ };
 
-			shouldRotateQueue = Items_.isEmpty ();
-
 			for (const auto& item : items)
 			{
 				if (Items_.contains (item))
 					continue;
 
-				if (!item.ID_.isEmpty () &&
-						std::any_of (Items_.begin (), Items_.end (),
-								[&item] (const TaskQueueItem& other)
-									{ return item.ID_ == other.ID_; }))
-					continue;
+				if (!item.ID_.isEmpty ())
+				{
+					const auto sameId = std::find_if (Items_.begin (), Items_.end (),
+							[&item] (const TaskQueueItem& other)
+								{ return item.ID_ == other.ID_; });
+					if (sameId != Items_.end ())
+					{
+						if (sameId->Priority_ < item.Priority_)
+						{
+							auto boosted = *sameId;
+							boosted.Priority_ = item.Priority_;
+							Items_.erase (sameId);
+							Items_.insert (std::lower_bound (Items_.begin (), Items_.end (),
+										boosted, &PriorityLess),
+									boosted);
+						}
+						continue;
+					}
+				}
 
-				const auto pos = std::lower_bound (Items_.begin (), Items_.end (),
-						item,
-						[] (const TaskQueueItem& left, const TaskQueueItem& right)
-							{ return left.Priority_ < right.Priority_; });
-				Items_.insert (pos, item);
+				Items_.insert (std::lower_bound (Items_.begin (), Items_.end (), item, &PriorityLess), item);
 			}
 
 			if (Items_.isEmpty ())
 				return;
 		}
 
-		if (shouldRotateQueue)
-			emit gotTask ();
+		emit gotTask ();
 	}
 
-	bool TaskQueueManager::HasItems () const
+	bool TaskQueue::HasItems () const
 	{
 		QMutexLocker locker { &ItemsMutex_ };
 		return !Items_.isEmpty ();
 	}
 
-	TaskQueueItem TaskQueueManager::PopItem ()
+	TaskQueueItem TaskQueue::PopItem ()
 	{
 		QMutexLocker locker { &ItemsMutex_ };
-		return Items_.isEmpty () ? TaskQueueItem {} : Items_.takeLast ();
+
+		for (int i = Items_.size () - 1; i >= 0; --i)
+		{
+			const auto& id = Items_.at (i).ID_;
+			if (id.isEmpty ())
+				return Items_.takeAt (i);
+
+			if (RunningIDs_.contains (id))
+				continue;
+
+			RunningIDs_ << id;
+			return Items_.takeAt (i);
+		}
+
+		return {};
+	}
+
+	void TaskQueue::MarkFinished (const TaskQueueItem& item)
+	{
+		if (item.ID_.isEmpty ())
+			return;
+
+		bool hasItems = false;
+		{
+			QMutexLocker locker { &ItemsMutex_ };
+			RunningIDs_.remove (item.ID_);
+			hasItems = !Items_.isEmpty ();
+		}
+
+		// Some items might have been waiting for this one to finish.
+		if (hasItems)
+			emit gotTask ();
+	}
+
+	TaskQueueManager::TaskQueueManager (AccountThreadWorker *worker, const TaskQueue_ptr& queue)
+	: ATW_ { worker }
+	, Queue_ { queue }
+	{
+		connect (Queue_.get (),
+				SIGNAL (gotTask ()),
+				this,
+				SLOT (rotateTaskQueue ()),
+				Qt::QueuedConnection);
+
+		if (Queue_->HasItems ())
+			QMetaObject::invokeMethod (this, "rotateTaskQueue", Qt::QueuedConnection);
 	}
 
 	template<typename Ex>
@@ -239,13 +289,14 @@ namespace Snails
 	void TaskQueueManager::rotateTaskQueue ()
 	{
 		qDebug () << Q_FUNC_INFO << "start";
-		while (HasItems ())
+		while (Queue_->HasItems ())
 		{
-			const auto& item = PopItem ();
+			const auto& item = Queue_->PopItem ();
 			if (item.Method_.isEmpty ())
 				break;
 
 			HandleItem (item);
+			Queue_->MarkFinished (item);
 		}
 		qDebug () << Q_FUNC_INFO << "done";
 	}
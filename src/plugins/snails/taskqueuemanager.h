@@ -29,9 +29,11 @@
 
 #pragma once
 
+#include <memory>
 #include <QObject>
 #include <QString>
 #include <QMutex>
+#include <QSet>
 #include <QFutureInterface>
 #include "valuedmetaargument.h"
 
@@ -70,30 +72,48 @@ namespace Snails
 
 	bool operator== (const TaskQueueItem&, const TaskQueueItem&);
 
-	class AccountThreadWorker;
-
-	class TaskQueueManager : public QObject
+	/** A priority queue of tasks that may be shared between several
+	 * TaskQueueManagers, each one running in its own thread.
+	 *
+	 * Items with the same non-empty ID are never handed out
+	 * simultaneously, so, for example, the same folder is never
+	 * synchronized by two connections at once.
+	 */
+	class TaskQueue : public QObject
 	{
 		Q_OBJECT
 
-		AccountThreadWorker * const ATW_;
-
 		mutable QMutex ItemsMutex_;
 		QList<TaskQueueItem> Items_;
+		QSet<QByteArray> RunningIDs_;
 	public:
-		TaskQueueManager (AccountThreadWorker*);
-
 		void AddTasks (QList<TaskQueueItem>);
 		bool HasItems () const;
+
 		TaskQueueItem PopItem ();
+		void MarkFinished (const TaskQueueItem&);
+	signals:
+		void gotTask ();
+	};
+
+	typedef std::shared_ptr<TaskQueue> TaskQueue_ptr;
+
+	class AccountThreadWorker;
+
+	class TaskQueueManager : public QObject
+	{
+		Q_OBJECT
+
+		AccountThreadWorker * const ATW_;
+		const TaskQueue_ptr Queue_;
+	public:
+		TaskQueueManager (AccountThreadWorker*, const TaskQueue_ptr&);
 	private:
 		template<typename Ex>
 		bool HandleReconnect (const TaskQueueItem&, const Ex& ex, int recLevel);
 		void HandleItem (const TaskQueueItem&, int recLevel = 0);
 	private slots:
 		void rotateTaskQueue ();
-	signals:
-		void gotTask ();
 	};
 }
 }
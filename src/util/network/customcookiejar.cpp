@@ -28,20 +28,168 @@
  **********************************************************************/
 
 #include "customcookiejar.h"
+#include <algorithm>
 #include <memory>
 #include <QNetworkCookie>
+#include <QHostAddress>
 #include <QtDebug>
 #include <QDateTime>
+#include <QUrl>
 
 namespace LeechCraft
 {
 namespace Util
 {
+	namespace
+	{
+		const QByteArray AddedRecord = "+\t";
+		const QByteArray RemovedRecord = "-\t";
+
+		QString NormalizeDomain (QString domain)
+		{
+			if (domain.startsWith ('.'))
+				domain.remove (0, 1);
+			return domain.toLower ();
+		}
+
+		/* Returns the registrable domain (the public suffix and one more
+		 * label) for the given host, or an empty string if the host is a
+		 * public suffix itself.
+		 */
+		QString GetRegistrableDomain (const QString& rawHost)
+		{
+			const auto& host = NormalizeDomain (rawHost);
+			if (host.isEmpty () || QHostAddress ().setAddress (host))
+				return host;
+
+			QUrl url;
+			url.setScheme ("http");
+			url.setHost (host);
+			const auto& tld = url.topLevelDomain ();
+
+			if (tld.isEmpty ())
+			{
+				const int lastDot = host.lastIndexOf ('.');
+				return lastDot <= 0 ?
+						host :
+						host.mid (host.lastIndexOf ('.', lastDot - 1) + 1);
+			}
+
+			const int suffixPos = host.size () - tld.size ();
+			if (suffixPos <= 0)
+				return QString ();
+
+			return host.mid (host.lastIndexOf ('.', suffixPos - 1) + 1);
+		}
+
+		QByteArray GetCookieId (const QNetworkCookie& cookie)
+		{
+			return cookie.name () + ';' +
+					cookie.domain ().toLower ().toUtf8 () + ';' +
+					cookie.path ().toUtf8 ();
+		}
+
+		bool IsDomainMatch (const QString& host, const QString& cookieDomain)
+		{
+			if (!cookieDomain.startsWith ('.'))
+				return !host.compare (cookieDomain, Qt::CaseInsensitive);
+
+			return host.endsWith (cookieDomain, Qt::CaseInsensitive) ||
+					!host.compare (cookieDomain.mid (1), Qt::CaseInsensitive);
+		}
+
+		bool IsPathMatch (const QString& path, const QString& cookiePath)
+		{
+			if (!path.startsWith (cookiePath))
+				return false;
+
+			return path.size () == cookiePath.size () ||
+					cookiePath.endsWith ('/') ||
+					path.at (cookiePath.size ()) == '/';
+		}
+
+		QString GetDefaultPath (const QUrl& url)
+		{
+			const auto& path = url.path ();
+			const int lastSlash = path.lastIndexOf ('/');
+			return lastSlash <= 0 ? QString ("/") : path.left (lastSlash);
+		}
+
+		bool IsExpired (const QNetworkCookie& cookie, const QDateTime& now)
+		{
+			return !cookie.isSessionCookie () && cookie.expirationDate () < now;
+		}
+	}
+
+	void CustomCookieJar::DomainList::Set (const QList<QRegExp>& list)
+	{
+		Literals_.clear ();
+		Patterns_.clear ();
+		Cache_.clear ();
+
+		// Regexps of the same syntax and case sensitivity are merged into
+		// a single alternation so that a domain is matched in one pass.
+		QHash<QPair<int, int>, QStringList> mergeable;
+		const QRegExp backrefRx ("\\\\[1-9]");
+		for (const auto& rx : list)
+		{
+			const auto& pattern = rx.pattern ();
+			Literals_ << pattern;
+
+			if (!rx.isValid () ||
+					rx.patternSyntax () == QRegExp::FixedString ||
+					QRegExp::escape (pattern) == pattern)
+				continue;
+
+			const auto syntax = rx.patternSyntax ();
+			if ((syntax == QRegExp::RegExp || syntax == QRegExp::RegExp2) &&
+					!pattern.contains (backrefRx))
+				mergeable [{ syntax, rx.caseSensitivity () }] << "(?:" + pattern + ")";
+			else
+				Patterns_ << rx;
+		}
+
+		for (auto i = mergeable.begin (), end = mergeable.end (); i != end; ++i)
+			Patterns_ << QRegExp (i->join ("|"),
+					static_cast<Qt::CaseSensitivity> (i.key ().second),
+					static_cast<QRegExp::PatternSyntax> (i.key ().first));
+	}
+
+	bool CustomCookieJar::DomainList::Matches (const QString& domain) const
+	{
+		if (Literals_.contains (domain))
+			return true;
+
+		if (Patterns_.isEmpty ())
+			return false;
+
+		const auto pos = Cache_.find (domain);
+		if (pos != Cache_.end ())
+			return *pos;
+
+		bool result = false;
+		for (const auto& rx : Patterns_)
+			if (rx.exactMatch (domain))
+			{
+				result = true;
+				break;
+			}
+
+		if (Cache_.size () > 4096)
+			Cache_.clear ();
+		Cache_ [domain] = result;
+
+		return result;
+	}
+
 	CustomCookieJar::CustomCookieJar (QObject *parent)
 	: QNetworkCookieJar (parent)
 	, FilterTrackingCookies_ (false)
 	, Enabled_ (true)
 	, MatchDomainExactly_ (false)
+	, CookiesCount_ (0)
+	, JournalRecords_ (0)
+	, FullSaveRequired_ (false)
 	{
 	}
 
@@ -66,68 +214,136 @@ namespace Util
 
 	void CustomCookieJar::SetWhitelist (const QList<QRegExp>& list)
 	{
-		WL_ = list;
+		WL_.Set (list);
 	}
 
 	void CustomCookieJar::SetBlacklist (const QList<QRegExp>& list)
 	{
-		BL_ = list;
+		BL_.Set (list);
 	}
 
 	QByteArray CustomCookieJar::Save () const
 	{
-		QList<QNetworkCookie> cookies = allCookies ();
 		QByteArray result;
-		for (const auto& cookie : cookies)
-		{
-			if (cookie.isSessionCookie ())
-				continue;
+		for (const auto& bucket : Cookies_)
+			for (const auto& cookie : bucket)
+			{
+				if (cookie.isSessionCookie ())
+					continue;
+
+				result += cookie.toRawForm ();
+				result += "\n";
+			}
+
+		return result;
+	}
+
+	void CustomCookieJar::MarkSaved ()
+	{
+		Dirty_.clear ();
+		JournalRecords_ = 0;
+		FullSaveRequired_ = false;
+	}
 
-			result += cookie.toRawForm ();
+	QByteArray CustomCookieJar::SaveChanges () const
+	{
+		QByteArray result;
+		for (auto i = Dirty_.begin (), end = Dirty_.end (); i != end; ++i)
+		{
+			if (i->name ().isEmpty () || i->isSessionCookie ())
+			{
+				result += RemovedRecord;
+				result += i.key ();
+			}
+			else
+			{
+				result += AddedRecord;
+				result += i->toRawForm ();
+			}
 			result += "\n";
+			++JournalRecords_;
 		}
+
+		Dirty_.clear ();
 		return result;
 	}
 
+	bool CustomCookieJar::NeedsFullSave () const
+	{
+		return FullSaveRequired_ ||
+				JournalRecords_ > std::max (1024, CookiesCount_);
+	}
+
 	void CustomCookieJar::Load (const QByteArray& data)
 	{
-		QList<QNetworkCookie> cookies, filteredCookies;
-		for (const auto& ba : data.split ('\n'))
-			cookies << QNetworkCookie::parseCookies (ba);
+		ClearCookies ();
 
 		const auto& now = QDateTime::currentDateTime ();
-		for (const auto& cookie : cookies)
+		int records = 0;
+		for (const auto& line : data.split ('\n'))
 		{
-			if (FilterTrackingCookies_ &&
-					cookie.name ().startsWith ("__utm"))
-				continue;
+			if (line.startsWith (RemovedRecord))
+			{
+				const auto& id = line.mid (RemovedRecord.size ());
+				const auto firstSep = id.indexOf (';');
+				const auto secondSep = id.indexOf (';', firstSep + 1);
+				if (firstSep < 0 || secondSep < 0)
+					continue;
+
+				const auto& domain = GetRegistrableDomain (QString::fromUtf8 (id.mid (firstSep + 1,
+						secondSep - firstSep - 1)));
+				auto bucket = Cookies_.find (domain);
+				if (bucket != Cookies_.end () && bucket->remove (id))
+					--CookiesCount_;
 
-			if (cookie.expirationDate () < now)
+				++records;
 				continue;
+			}
+
+			const bool isRecord = line.startsWith (AddedRecord);
+			if (isRecord)
+				++records;
 
-			filteredCookies << cookie;
+			for (const auto& cookie : QNetworkCookie::parseCookies (isRecord ? line.mid (AddedRecord.size ()) : line))
+			{
+				if (FilterTrackingCookies_ &&
+						cookie.name ().startsWith ("__utm"))
+					continue;
+
+				if (IsExpired (cookie, now))
+					continue;
+
+				InsertCookie (cookie);
+			}
 		}
-		setAllCookies (filteredCookies);
+
+		Dirty_.clear ();
+		JournalRecords_ = records;
+		FullSaveRequired_ = false;
 	}
 
 	void CustomCookieJar::CollectGarbage ()
 	{
-		const auto& cookies = allCookies ();
-		QList<QNetworkCookie> result;
 		const auto& now = QDateTime::currentDateTime ();
-		for (const auto& cookie : cookies)
+		const auto prevCount = CookiesCount_;
+		for (auto bucket = Cookies_.begin (); bucket != Cookies_.end (); )
 		{
-			if (!cookie.isSessionCookie () &&
-					cookie.expirationDate () < now)
-				continue;
-
-			if (result.contains (cookie))
-				continue;
+			for (auto i = bucket->begin (); i != bucket->end (); )
+				if (IsExpired (*i, now))
+				{
+					Dirty_ [i.key ()] = QNetworkCookie (QByteArray ());
+					i = bucket->erase (i);
+					--CookiesCount_;
+				}
+				else
+					++i;
 
-			result << cookie;
+			if (bucket->isEmpty ())
+				bucket = Cookies_.erase (bucket);
+			else
+				++bucket;
 		}
-		qDebug () << Q_FUNC_INFO << cookies.size () << result.size ();
-		setAllCookies (result);
+		qDebug () << Q_FUNC_INFO << prevCount << CookiesCount_;
 	}
 
 	QList<QNetworkCookie> CustomCookieJar::cookiesForUrl (const QUrl& url) const
@@ -135,11 +351,36 @@ namespace Util
 		if (!Enabled_)
 			return {};
 
-		QList<QNetworkCookie> filtered;
-		for (const auto& cookie : QNetworkCookieJar::cookiesForUrl (url))
-			if (!filtered.contains (cookie))
-				filtered << cookie;
-		return filtered;
+		const auto& host = url.host ();
+		const auto bucket = Cookies_.find (GetRegistrableDomain (host));
+		if (bucket == Cookies_.end ())
+			return {};
+
+		const auto& path = url.path ().isEmpty () ? QString ("/") : url.path ();
+		const bool isSecure = url.scheme ().toLower () == "https";
+		const auto& now = QDateTime::currentDateTime ();
+
+		QList<QNetworkCookie> result;
+		for (const auto& cookie : *bucket)
+		{
+			if (!IsDomainMatch (host, cookie.domain ()) ||
+					!IsPathMatch (path, cookie.path ()))
+				continue;
+
+			if (cookie.isSecure () && !isSecure)
+				continue;
+
+			if (IsExpired (cookie, now))
+				continue;
+
+			result << cookie;
+		}
+
+		std::stable_sort (result.begin (), result.end (),
+				[] (const QNetworkCookie& left, const QNetworkCookie& right)
+					{ return left.path ().size () > right.path ().size (); });
+
+		return result;
 	}
 
 	namespace
@@ -160,15 +401,6 @@ namespace Util
 			const auto idx = domain.indexOf (cookieDomain);
 			return idx > 0 && domain.at (idx - 1) == '.';
 		}
-
-		bool Check (const QList<QRegExp>& list, const QString& str)
-		{
-			for (auto& rx : list)
-				if (str == rx.pattern () || rx.exactMatch (str))
-					return true;
-
-			return false;
-		}
 	}
 
 	bool CustomCookieJar::setCookiesFromUrl (const QList<QNetworkCookie>& cookieList, const QUrl& url)
@@ -186,7 +418,7 @@ namespace Util
 			bool checkWhitelist = false;
 			std::shared_ptr<void> wlGuard (nullptr, [&] (void*)
 					{
-						if (checkWhitelist && Check (WL_, cookie.domain ()))
+						if (checkWhitelist && WL_.Matches (cookie.domain ()))
 							filtered << cookie;
 					});
 
@@ -203,11 +435,82 @@ namespace Util
 				continue;
 			}
 
-			if (!Check (BL_, cookie.domain ()))
+			if (!BL_.Matches (cookie.domain ()))
 				filtered << cookie;
 		}
 
-		return QNetworkCookieJar::setCookiesFromUrl (filtered, url);
+		const auto& host = url.host ();
+		const auto& now = QDateTime::currentDateTime ();
+		bool changed = false;
+		for (auto cookie : filtered)
+		{
+			if (cookie.path ().isEmpty ())
+				cookie.setPath (GetDefaultPath (url));
+
+			if (!cookie.domain ().startsWith ('.'))
+				cookie.setDomain ('.' + cookie.domain ());
+
+			if (!IsDomainMatch (host, cookie.domain ()))
+				continue;
+
+			const auto& domain = GetRegistrableDomain (cookie.domain ());
+			if (domain.isEmpty ())
+				continue;
+
+			const auto& id = GetCookieId (cookie);
+			if (IsExpired (cookie, now))
+			{
+				auto bucket = Cookies_.find (domain);
+				if (bucket != Cookies_.end () && bucket->remove (id))
+				{
+					--CookiesCount_;
+					Dirty_ [id] = QNetworkCookie (QByteArray ());
+					changed = true;
+				}
+				continue;
+			}
+
+			InsertCookie (cookie);
+			Dirty_ [id] = cookie;
+			changed = true;
+		}
+
+		return changed;
+	}
+
+	QList<QNetworkCookie> CustomCookieJar::allCookies () const
+	{
+		QList<QNetworkCookie> result;
+		result.reserve (CookiesCount_);
+		for (const auto& bucket : Cookies_)
+			for (const auto& cookie : bucket)
+				result << cookie;
+		return result;
+	}
+
+	void CustomCookieJar::setAllCookies (const QList<QNetworkCookie>& cookies)
+	{
+		ClearCookies ();
+		for (const auto& cookie : cookies)
+			InsertCookie (cookie);
+
+		Dirty_.clear ();
+		FullSaveRequired_ = true;
+	}
+
+	void CustomCookieJar::InsertCookie (const QNetworkCookie& cookie)
+	{
+		auto& bucket = Cookies_ [GetRegistrableDomain (cookie.domain ())];
+		const auto& id = GetCookieId (cookie);
+		if (!bucket.contains (id))
+			++CookiesCount_;
+		bucket [id] = cookie;
+	}
+
+	void CustomCookieJar::ClearCookies ()
+	{
+		Cookies_.clear ();
+		CookiesCount_ = 0;
 	}
 }
 }
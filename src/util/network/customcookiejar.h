@@ -30,8 +30,11 @@
 #pragma once
 
 #include <QNetworkCookieJar>
+#include <QNetworkCookie>
 #include <QByteArray>
 #include <QRegExp>
+#include <QHash>
+#include <QSet>
 #include "networkconfig.h"
 
 namespace LeechCraft
@@ -43,18 +46,46 @@ namespace Util
 	 * Allows one to filter tracking cookies, filter duplicate cookies
 	 * and has unlimited storage period.
 	 *
+	 * Cookies are indexed by the registrable domain of the cookie (like
+	 * \em example.co.uk for \em www.example.co.uk), so looking up the
+	 * cookies for an URL only touches the cookies of its site. Cookies
+	 * with the same name, domain and path replace each other.
+	 *
+	 * The jar can be persisted either as a whole via Save() or
+	 * incrementally via SaveChanges(), which only writes the cookies that
+	 * have been changed since the last save as journal records. Load()
+	 * understands both forms.
+	 *
 	 * @ingroup NetworkUtil
 	 */
 	class UTIL_NETWORK_API CustomCookieJar : public QNetworkCookieJar
 	{
 		Q_OBJECT
 
+		class DomainList
+		{
+			QSet<QString> Literals_;
+			QList<QRegExp> Patterns_;
+			mutable QHash<QString, bool> Cache_;
+		public:
+			void Set (const QList<QRegExp>& list);
+			bool Matches (const QString& domain) const;
+		};
+
 		bool FilterTrackingCookies_;
 		bool Enabled_;
 		bool MatchDomainExactly_;
 
-		QList<QRegExp> WL_;
-		QList<QRegExp> BL_;
+		DomainList WL_;
+		DomainList BL_;
+
+		typedef QHash<QByteArray, QNetworkCookie> Bucket_t;
+		QHash<QString, Bucket_t> Cookies_;
+		int CookiesCount_;
+
+		mutable QHash<QByteArray, QNetworkCookie> Dirty_;
+		mutable int JournalRecords_;
+		mutable bool FullSaveRequired_;
 	public:
 		/** @brief Constructs the cookie jar.
 		 *
@@ -124,21 +155,57 @@ namespace Util
 		/** Serializes the cookie jar contents into a QByteArray
 		 * suitable for storage.
 		 *
+		 * This function doesn't affect the changes tracked for
+		 * SaveChanges(). If the result replaces the whole storage
+		 * SaveChanges() appends to, call MarkSaved() afterwards.
+		 *
 		 * @return The serialized cookies.
 		 *
-		 * @sa Load()
+		 * @sa Load(), SaveChanges(), MarkSaved()
 		 */
 		QByteArray Save () const;
 
+		/** @brief Marks the jar as fully persisted.
+		 *
+		 * Resets the changes tracked for SaveChanges() and the full save
+		 * request. This should be called after the result of Save() has
+		 * been written to the storage SaveChanges() appends to.
+		 *
+		 * @sa Save(), NeedsFullSave()
+		 */
+		void MarkSaved ();
+
+		/** @brief Serializes the changes since the last save.
+		 *
+		 * The returned journal records are supposed to be appended to
+		 * the data previously obtained from Save() and this function.
+		 *
+		 * @return The journal records for the changed cookies.
+		 *
+		 * @sa NeedsFullSave()
+		 */
+		QByteArray SaveChanges () const;
+
+		/** @brief Checks whether the whole jar should be saved.
+		 *
+		 * This function returns true if the changes can't be
+		 * represented by SaveChanges() (for example, after
+		 * setAllCookies()) or if the journal has grown large compared to
+		 * the jar itself.
+		 *
+		 * @return Whether Save() should be used instead of SaveChanges().
+		 */
+		bool NeedsFullSave () const;
+
 		/** Restores the cookies from the array previously obtained
-		 * from Save().
+		 * from Save() and, possibly, SaveChanges().
 		 *
 		 * @param[in] data Serialized cookies.
 		 * @sa Save()
 		 */
 		void Load (const QByteArray& data);
 
-		/** Removes duplicate cookies.
+		/** Removes expired cookies.
 		 */
 		void CollectGarbage ();
 
@@ -163,8 +230,20 @@ namespace Util
 		 */
 		bool setCookiesFromUrl (const QList<QNetworkCookie>& cookieList, const QUrl& url);
 
-		using QNetworkCookieJar::allCookies;
-		using QNetworkCookieJar::setAllCookies;
+		/** @brief Returns all the cookies in the jar.
+		 *
+		 * @return The list of all cookies.
+		 */
+		QList<QNetworkCookie> allCookies () const;
+
+		/** @brief Replaces the contents of the jar with the given cookies.
+		 *
+		 * @param[in] cookies The new cookies of the jar.
+		 */
+		void setAllCookies (const QList<QNetworkCookie>& cookies);
+	private:
+		void InsertCookie (const QNetworkCookie& cookie);
+		void ClearCookies ();
 	};
 }
 }
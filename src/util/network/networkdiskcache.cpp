@@ -28,6 +28,7 @@
  **********************************************************************/
 
 #include "networkdiskcache.h"
+#include <algorithm>
 #include <QtDebug>
 #include <QDateTime>
 #include <QDir>
@@ -36,31 +37,176 @@
 #include <QTimer>
 #include <QDirIterator>
 #include <QMutexLocker>
+#include <QTemporaryFile>
+#include <QBuffer>
+#include <QDataStream>
+#include <QCryptographicHash>
+#include <QSet>
 #include <util/sys/paths.h>
 
 namespace LeechCraft
 {
 namespace Util
 {
+	namespace
+	{
+		const quint32 EntryMagic = 0x4c43434e;
+		const quint8 EntryVersion = 1;
+		const quint8 IndexVersion = 1;
+
+		QByteArray GetKey (const QUrl& url)
+		{
+			return QCryptographicHash::hash (url.toEncoded (QUrl::RemoveFragment),
+					QCryptographicHash::Sha1);
+		}
+
+		qint64 Now ()
+		{
+			return QDateTime::currentMSecsSinceEpoch ();
+		}
+
+		bool WriteHeader (QIODevice *dev, const QNetworkCacheMetaData& meta)
+		{
+			QDataStream out (dev);
+			out.setVersion (QDataStream::Qt_4_6);
+			out << EntryMagic << EntryVersion << meta;
+			return out.status () == QDataStream::Ok;
+		}
+
+		bool ReadHeader (QIODevice *dev, QNetworkCacheMetaData& meta)
+		{
+			QDataStream in (dev);
+			in.setVersion (QDataStream::Qt_4_6);
+
+			quint32 magic = 0;
+			quint8 version = 0;
+			in >> magic >> version;
+			if (magic != EntryMagic || version != EntryVersion)
+				return false;
+
+			in >> meta;
+			return in.status () == QDataStream::Ok && meta.isValid ();
+		}
+
+		void RemoveRecursively (const QString& path)
+		{
+			QDir dir (path);
+			if (!dir.exists ())
+				return;
+
+			for (const auto& info : dir.entryInfoList (QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden))
+				if (info.isDir ())
+					RemoveRecursively (info.absoluteFilePath ());
+				else
+					QFile::remove (info.absoluteFilePath ());
+
+			dir.rmdir (path);
+		}
+
+		NetworkDiskCache::IndexEntries_t RebuildIndex (const QString& cacheDir, const QString& dataDir)
+		{
+			qDebug () << Q_FUNC_INFO << "rebuilding index for" << cacheDir;
+
+			// Leftovers of the QNetworkDiskCache-based implementation.
+			for (const auto& legacy : { "data7", "data8", "prepared" })
+				RemoveRecursively (cacheDir + '/' + legacy);
+
+			NetworkDiskCache::IndexEntries_t entries;
+
+			QDirIterator it (dataDir, QDir::Files, QDirIterator::Subdirectories);
+			while (it.hasNext ())
+			{
+				it.next ();
+				const auto& info = it.fileInfo ();
+				const auto& name = info.fileName ();
+				if (name.size () != 40 || info.dir ().dirName () != name.left (2))
+					continue;
+
+				const auto& key = QByteArray::fromHex (name.toLatin1 ());
+				const NetworkDiskCache::IndexEntry entry
+				{
+					info.size (),
+					info.lastModified ().toMSecsSinceEpoch ()
+				};
+				entries.append (qMakePair (key, entry));
+			}
+
+			qDebug () << "rebuilt index with" << entries.size () << "entries";
+
+			return entries;
+		}
+	}
+
 	NetworkDiskCache::NetworkDiskCache (const QString& subpath, QObject *parent)
-	: QNetworkDiskCache (parent)
-	, CurrentSize_ (-1)
-	, InsertRemoveMutex_ (QMutex::Recursive)
+	: QAbstractNetworkCache (parent)
+	, CacheDir_ (GetUserDir (UserDir::Cache, "network/" + subpath).absolutePath ())
+	, DataDir_ (CacheDir_ + "/lc1")
+	, CurrentSize_ (0)
+	, MaxSize_ (50 * 1024 * 1024)
 	, GarbageCollectorWatcher_ (nullptr)
+	, IndexRebuildWatcher_ (nullptr)
 	{
-		setCacheDirectory (GetUserDir (UserDir::Cache, "network/" + subpath).absolutePath ());
+		QDir ().mkpath (DataDir_ + "/prepared");
+		for (const auto& info : QDir (DataDir_ + "/prepared").entryInfoList (QDir::Files))
+			QFile::remove (info.absoluteFilePath ());
+
+		QFile marker (GetDirtyMarkerPath ());
+		const bool wasDirty = marker.exists ();
+		if (!wasDirty && !marker.open (QIODevice::WriteOnly))
+			qWarning () << Q_FUNC_INFO
+					<< "unable to create"
+					<< marker.fileName ()
+					<< marker.errorString ();
+
+		if (!LoadIndex () || wasDirty)
+		{
+			IndexRebuildWatcher_ = new QFutureWatcher<IndexEntries_t> (this);
+			connect (IndexRebuildWatcher_,
+					SIGNAL (finished ()),
+					this,
+					SLOT (handleIndexRebuilt ()));
+			IndexRebuildWatcher_->setFuture (QtConcurrent::run (RebuildIndex, CacheDir_, DataDir_));
+		}
+
 		auto timer = new QTimer (this);
 		timer->setInterval (60 * 60 * 1000);
 		connect (timer,
 				SIGNAL (timeout ()),
 				this,
 				SLOT (collectGarbage ()));
+		timer->start ();
 	}
 
 	NetworkDiskCache::~NetworkDiskCache ()
 	{
+		if (IndexRebuildWatcher_)
+		{
+			IndexRebuildWatcher_->waitForFinished ();
+			handleIndexRebuilt ();
+		}
+
 		if (GarbageCollectorWatcher_)
 			GarbageCollectorWatcher_->waitForFinished ();
+
+		if (SaveIndex ())
+			QFile::remove (GetDirtyMarkerPath ());
+	}
+
+	QString NetworkDiskCache::cacheDirectory () const
+	{
+		return CacheDir_;
+	}
+
+	qint64 NetworkDiskCache::maximumCacheSize () const
+	{
+		return MaxSize_;
+	}
+
+	void NetworkDiskCache::setMaximumCacheSize (qint64 size)
+	{
+		MaxSize_ = size;
+		if (CurrentSize_ > MaxSize_)
+			collectGarbage ();
 	}
 
 	qint64 NetworkDiskCache::cacheSize () const
@@ -70,136 +216,526 @@ namespace Util
 
 	QIODevice* NetworkDiskCache::data (const QUrl& url)
 	{
-		QMutexLocker lock (&InsertRemoveMutex_);
-		return QNetworkDiskCache::data (url);
+		const auto& key = GetKey (url);
+
+		QFile file (GetEntryPath (key));
+		{
+			auto& shard = GetShard (key);
+			QMutexLocker lock (&shard.Lock_);
+			const auto pos = shard.Entries_.find (key);
+			if (pos == shard.Entries_.end ())
+				return nullptr;
+
+			if (!file.open (QIODevice::ReadOnly))
+			{
+				CurrentSize_ -= pos->Size_;
+				shard.Entries_.erase (pos);
+				return nullptr;
+			}
+
+			pos->LastAccess_ = Now ();
+		}
+
+		QNetworkCacheMetaData meta;
+		if (!ReadHeader (&file, meta) ||
+				GetKey (meta.url ()) != key)
+		{
+			file.close ();
+			RemoveEntry (key);
+			return nullptr;
+		}
+
+		auto buffer = new QBuffer;
+		buffer->setData (file.readAll ());
+		buffer->open (QIODevice::ReadOnly);
+		return buffer;
 	}
 
 	void NetworkDiskCache::insert (QIODevice *device)
 	{
-		QMutexLocker lock (&InsertRemoveMutex_);
-		if (!PendingDev2Url_.contains (device))
+		QByteArray key;
 		{
-			qWarning () << Q_FUNC_INFO
-					<< "stall device detected";
-			return;
+			QMutexLocker lock (&PendingMutex_);
+			if (!PendingDev2Key_.contains (device))
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "stall device detected";
+				return;
+			}
+
+			key = PendingDev2Key_.take (device);
+			auto& devs = PendingKey2Devs_ [key];
+			devs.removeAll (device);
+			if (devs.isEmpty ())
+				PendingKey2Devs_.remove (key);
 		}
 
-		PendingUrl2Devs_ [PendingDev2Url_.take (device)].removeAll (device);
+		const auto file = static_cast<QTemporaryFile*> (device);
+		file->flush ();
+		file->setAutoRemove (false);
+		const auto size = file->size ();
+		const auto& tempPath = file->fileName ();
+		delete file;
+
+		const auto& path = GetEntryPath (key);
+		QDir ().mkpath (QFileInfo (path).absolutePath ());
+
+		{
+			auto& shard = GetShard (key);
+			QMutexLocker lock (&shard.Lock_);
+
+			QFile::remove (path);
+			if (!QFile::rename (tempPath, path))
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unable to move"
+						<< tempPath
+						<< "to"
+						<< path;
+				QFile::remove (tempPath);
+
+				const auto pos = shard.Entries_.find (key);
+				if (pos != shard.Entries_.end ())
+				{
+					CurrentSize_ -= pos->Size_;
+					shard.Entries_.erase (pos);
+				}
+				return;
+			}
+
+			const auto pos = shard.Entries_.find (key);
+			if (pos != shard.Entries_.end ())
+				CurrentSize_ -= pos->Size_;
+			shard.Entries_ [key] = { size, Now () };
+			CurrentSize_ += size;
+		}
 
-		CurrentSize_ += device->size ();
-		QNetworkDiskCache::insert (device);
+		if (CurrentSize_ > MaxSize_)
+			QMetaObject::invokeMethod (this,
+					"collectGarbage",
+					Qt::QueuedConnection);
 	}
 
 	QNetworkCacheMetaData NetworkDiskCache::metaData (const QUrl& url)
 	{
-		QMutexLocker lock (&InsertRemoveMutex_);
-		return QNetworkDiskCache::metaData (url);
+		const auto& key = GetKey (url);
+
+		QFile file (GetEntryPath (key));
+		{
+			auto& shard = GetShard (key);
+			QMutexLocker lock (&shard.Lock_);
+			if (!shard.Entries_.contains (key))
+				return QNetworkCacheMetaData ();
+
+			if (!file.open (QIODevice::ReadOnly))
+				return QNetworkCacheMetaData ();
+		}
+
+		QNetworkCacheMetaData meta;
+		if (!ReadHeader (&file, meta) ||
+				GetKey (meta.url ()) != key)
+		{
+			file.close ();
+			RemoveEntry (key);
+			return QNetworkCacheMetaData ();
+		}
+
+		return meta;
 	}
 
 	QIODevice* NetworkDiskCache::prepare (const QNetworkCacheMetaData& metadata)
 	{
-		QMutexLocker lock (&InsertRemoveMutex_);
-		const auto dev = QNetworkDiskCache::prepare (metadata);
-		PendingDev2Url_ [dev] = metadata.url ();
-		PendingUrl2Devs_ [metadata.url ()] << dev;
-		return dev;
+		if (!metadata.isValid () ||
+				!metadata.url ().isValid () ||
+				!metadata.saveToDisk ())
+			return nullptr;
+
+		const qint64 maxSize = MaxSize_;
+		for (const auto& header : metadata.rawHeaders ())
+			if (header.first.toLower () == "content-length" &&
+					header.second.toLongLong () > maxSize * 3 / 4)
+				return nullptr;
+
+		auto file = new QTemporaryFile (DataDir_ + "/prepared/entry.XXXXXX");
+		if (!file->open () || !WriteHeader (file, metadata))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to prepare cache file"
+					<< file->errorString ();
+			delete file;
+			return nullptr;
+		}
+
+		const auto& key = GetKey (metadata.url ());
+
+		QMutexLocker lock (&PendingMutex_);
+		PendingDev2Key_ [file] = key;
+		PendingKey2Devs_ [key] << file;
+		return file;
 	}
 
 	bool NetworkDiskCache::remove (const QUrl& url)
 	{
-		QMutexLocker lock (&InsertRemoveMutex_);
-		for (const auto dev : PendingUrl2Devs_.take (url))
-			PendingDev2Url_.remove (dev);
-		return QNetworkDiskCache::remove (url);
+		const auto& key = GetKey (url);
+
+		// Like in QNetworkDiskCache, remove() is also used to cancel
+		// pending insertions.
+		QIODevice *pending = nullptr;
+		{
+			QMutexLocker lock (&PendingMutex_);
+			const auto pos = PendingKey2Devs_.find (key);
+			if (pos != PendingKey2Devs_.end ())
+			{
+				pending = pos->takeFirst ();
+				if (pos->isEmpty ())
+					PendingKey2Devs_.erase (pos);
+				PendingDev2Key_.remove (pending);
+			}
+		}
+
+		if (pending)
+		{
+			delete pending;
+			return true;
+		}
+
+		{
+			auto& shard = GetShard (key);
+			QMutexLocker lock (&shard.Lock_);
+			if (!shard.Entries_.contains (key))
+				return false;
+		}
+
+		RemoveEntry (key);
+		return true;
 	}
 
 	void NetworkDiskCache::updateMetaData (const QNetworkCacheMetaData& metaData)
 	{
-		QMutexLocker lock (&InsertRemoveMutex_);
-		QNetworkDiskCache::updateMetaData (metaData);
-	}
+		const auto& key = GetKey (metaData.url ());
+		const auto& path = GetEntryPath (key);
 
-	qint64 NetworkDiskCache::expire ()
-	{
-		if (CurrentSize_ < 0)
+		QFile oldFile (path);
 		{
-			collectGarbage ();
-			return maximumCacheSize () * 8 / 10;
+			auto& shard = GetShard (key);
+			QMutexLocker lock (&shard.Lock_);
+			if (!shard.Entries_.contains (key) ||
+					!oldFile.open (QIODevice::ReadOnly))
+				return;
 		}
 
-		if (CurrentSize_ > maximumCacheSize ())
-			collectGarbage ();
+		QNetworkCacheMetaData oldMeta;
+		if (!ReadHeader (&oldFile, oldMeta))
+		{
+			oldFile.close ();
+			RemoveEntry (key);
+			return;
+		}
 
-		return CurrentSize_;
+		QTemporaryFile newFile (DataDir_ + "/prepared/entry.XXXXXX");
+		if (!newFile.open () || !WriteHeader (&newFile, metaData))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to create temporary file"
+					<< newFile.errorString ();
+			return;
+		}
+
+		const qint64 chunkSize = 256 * 1024;
+		while (!oldFile.atEnd ())
+			if (newFile.write (oldFile.read (chunkSize)) < 0)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unable to write metadata"
+						<< newFile.errorString ();
+				return;
+			}
+		oldFile.close ();
+
+		newFile.flush ();
+		const auto size = newFile.size ();
+		newFile.setAutoRemove (false);
+		newFile.close ();
+
+		auto& shard = GetShard (key);
+		QMutexLocker lock (&shard.Lock_);
+		const auto pos = shard.Entries_.find (key);
+		if (pos == shard.Entries_.end ())
+		{
+			QFile::remove (newFile.fileName ());
+			return;
+		}
+
+		QFile::remove (path);
+		if (!QFile::rename (newFile.fileName (), path))
+		{
+			QFile::remove (newFile.fileName ());
+			CurrentSize_ -= pos->Size_;
+			shard.Entries_.erase (pos);
+			return;
+		}
+
+		CurrentSize_ += size - pos->Size_;
+		pos->Size_ = size;
+		pos->LastAccess_ = Now ();
 	}
 
-	namespace
+	NetworkDiskCache::Shard& NetworkDiskCache::GetShard (const QByteArray& key)
+	{
+		return Shards_ [static_cast<uchar> (key.at (0)) % ShardsCount];
+	}
+
+	QString NetworkDiskCache::GetEntryPath (const QByteArray& key) const
+	{
+		const auto& hex = QString::fromLatin1 (key.toHex ());
+		return DataDir_ + '/' + hex.left (2) + '/' + hex;
+	}
+
+	void NetworkDiskCache::RemoveEntry (const QByteArray& key)
+	{
+		auto& shard = GetShard (key);
+		QMutexLocker lock (&shard.Lock_);
+		const auto pos = shard.Entries_.find (key);
+		if (pos == shard.Entries_.end ())
+			return;
+
+		CurrentSize_ -= pos->Size_;
+		shard.Entries_.erase (pos);
+		QFile::remove (GetEntryPath (key));
+	}
+
+	void NetworkDiskCache::clear ()
 	{
-		qint64 Collector (const QString& cacheDirectory, qint64 goal, QMutex *fileOpMutex)
+		for (auto& shard : Shards_)
 		{
-			if (cacheDirectory.isEmpty ())
-				return 0;
+			QList<QByteArray> keys;
+			{
+				QMutexLocker lock (&shard.Lock_);
+				for (auto i = shard.Entries_.begin (), end = shard.Entries_.end (); i != end; ++i)
+				{
+					keys << i.key ();
+					CurrentSize_ -= i->Size_;
+				}
+				shard.Entries_.clear ();
+			}
 
-			qDebug () << Q_FUNC_INFO << "running..." << cacheDirectory;
+			for (const auto& key : keys)
+				QFile::remove (GetEntryPath (key));
+		}
+	}
 
-			QDir::Filters filters = QDir::AllDirs | QDir:: Files | QDir::NoDotAndDotDot;
-			QDirIterator it (cacheDirectory, filters, QDirIterator::Subdirectories);
+	void NetworkDiskCache::RunCollector (qint64 goal)
+	{
+		if (CurrentSize_ > goal)
+		{
+			qDebug () << Q_FUNC_INFO << "running..." << CacheDir_;
 
-			QMultiMap<QDateTime, QString> cacheItems;
-			qint64 totalSize = 0;
-			while (it.hasNext ())
+			QList<QPair<qint64, QByteArray>> candidates;
+			for (const auto& shard : Shards_)
 			{
-				const auto& path = it.next ();
-				const auto& info = it.fileInfo ();
-				cacheItems.insert (info.created (), path);
-				totalSize += info.size ();
+				QMutexLocker lock (&shard.Lock_);
+				for (auto i = shard.Entries_.begin (), end = shard.Entries_.end (); i != end; ++i)
+					candidates.append (qMakePair (i->LastAccess_, i.key ()));
 			}
 
-			auto i = cacheItems.constBegin ();
-			while (i != cacheItems.constEnd ())
+			std::sort (candidates.begin (), candidates.end (),
+					[] (const QPair<qint64, QByteArray>& left, const QPair<qint64, QByteArray>& right)
+						{ return left.first < right.first; });
+
+			for (const auto& candidate : candidates)
 			{
-				if (totalSize < goal)
+				if (CurrentSize_ <= goal)
 					break;
 
-				QFile file (*i);
-				const auto size = file.size ();
-				totalSize -= size;
-				++i;
+				auto& shard = GetShard (candidate.second);
+				QMutexLocker lock (&shard.Lock_);
+				const auto pos = shard.Entries_.find (candidate.second);
+				if (pos == shard.Entries_.end () ||
+						pos->LastAccess_ != candidate.first)
+					continue;
 
-				QMutexLocker lock (fileOpMutex);
-				file.remove ();
+				CurrentSize_ -= pos->Size_;
+				shard.Entries_.erase (pos);
+				QFile::remove (GetEntryPath (candidate.second));
 			}
 
-			qDebug () << "collector finished" << totalSize;
+			qDebug () << "collector finished" << CurrentSize_;
+		}
 
-			return totalSize;
+		SaveIndex ();
+	}
+
+	bool NetworkDiskCache::LoadIndex ()
+	{
+		QFile file (DataDir_ + "/index");
+		if (!file.open (QIODevice::ReadOnly))
+			return false;
+
+		QDataStream in (&file);
+		in.setVersion (QDataStream::Qt_4_6);
+
+		quint8 version = 0;
+		quint32 count = 0;
+		in >> version >> count;
+		if (version != IndexVersion)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unknown index version"
+					<< version;
+			return false;
 		}
-	};
+
+		for (quint32 i = 0; i < count && in.status () == QDataStream::Ok; ++i)
+		{
+			QByteArray key;
+			IndexEntry entry;
+			in >> key >> entry.Size_ >> entry.LastAccess_;
+			if (key.isEmpty ())
+				continue;
+
+			GetShard (key).Entries_ [key] = entry;
+			CurrentSize_ += entry.Size_;
+		}
+
+		if (in.status () != QDataStream::Ok)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "corrupted index";
+			for (auto& shard : Shards_)
+				shard.Entries_.clear ();
+			CurrentSize_ = 0;
+			return false;
+		}
+
+		return true;
+	}
+
+	bool NetworkDiskCache::SaveIndex () const
+	{
+		QFile file (DataDir_ + "/index.new");
+		if (!file.open (QIODevice::WriteOnly | QIODevice::Truncate))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< file.fileName ()
+					<< file.errorString ();
+			return false;
+		}
+
+		QDataStream out (&file);
+		out.setVersion (QDataStream::Qt_4_6);
+
+		IndexEntries_t entries;
+		for (const auto& shard : Shards_)
+		{
+			QMutexLocker lock (&shard.Lock_);
+			for (auto i = shard.Entries_.begin (), end = shard.Entries_.end (); i != end; ++i)
+				entries.append (qMakePair (i.key (), *i));
+		}
+
+		out << IndexVersion << static_cast<quint32> (entries.size ());
+		for (const auto& pair : entries)
+			out << pair.first << pair.second.Size_ << pair.second.LastAccess_;
+		file.close ();
+
+		if (out.status () != QDataStream::Ok)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to write"
+					<< file.fileName ();
+			file.remove ();
+			return false;
+		}
+
+		const auto& indexPath = DataDir_ + "/index";
+		QFile::remove (indexPath);
+		if (!QFile::rename (file.fileName (), indexPath))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to move"
+					<< file.fileName ()
+					<< "to"
+					<< indexPath;
+			return false;
+		}
+
+		return true;
+	}
+
+	QString NetworkDiskCache::GetDirtyMarkerPath () const
+	{
+		return DataDir_ + "/dirty";
+	}
 
 	void NetworkDiskCache::collectGarbage ()
 	{
 		if (GarbageCollectorWatcher_)
 			return;
 
-		if (cacheDirectory ().isEmpty ())
-			return;
-
-		GarbageCollectorWatcher_ = new QFutureWatcher<qint64> (this);
+		GarbageCollectorWatcher_ = new QFutureWatcher<void> (this);
 		connect (GarbageCollectorWatcher_,
 				SIGNAL (finished ()),
 				this,
 				SLOT (handleCollectorFinished ()));
 
-		auto future = QtConcurrent::run (Collector,
-				cacheDirectory (), maximumCacheSize () * 9 / 10, &InsertRemoveMutex_);
+		auto future = QtConcurrent::run (this,
+				&NetworkDiskCache::RunCollector, MaxSize_ * 9 / 10);
 		GarbageCollectorWatcher_->setFuture (future);
 	}
 
 	void NetworkDiskCache::handleCollectorFinished ()
 	{
-		CurrentSize_ = GarbageCollectorWatcher_->result ();
 		GarbageCollectorWatcher_->deleteLater ();
 		GarbageCollectorWatcher_ = nullptr;
 	}
+
+	void NetworkDiskCache::handleIndexRebuilt ()
+	{
+		if (!IndexRebuildWatcher_)
+			return;
+
+		// The scanned files are the authority on what is in the cache,
+		// but the index has more precise access times.
+		QSet<QByteArray> scanned;
+		for (const auto& pair : IndexRebuildWatcher_->result ())
+		{
+			scanned << pair.first;
+
+			auto& shard = GetShard (pair.first);
+			QMutexLocker lock (&shard.Lock_);
+			const auto pos = shard.Entries_.find (pair.first);
+			if (pos == shard.Entries_.end ())
+			{
+				shard.Entries_ [pair.first] = pair.second;
+				CurrentSize_ += pair.second.Size_;
+			}
+			else
+			{
+				CurrentSize_ += pair.second.Size_ - pos->Size_;
+				pos->Size_ = pair.second.Size_;
+			}
+		}
+
+		// Entries inserted while the scan was running are missing from
+		// its results too, so check that their files are really gone.
+		for (auto& shard : Shards_)
+		{
+			QMutexLocker lock (&shard.Lock_);
+			for (auto i = shard.Entries_.begin (); i != shard.Entries_.end (); )
+				if (!scanned.contains (i.key ()) && !QFile::exists (GetEntryPath (i.key ())))
+				{
+					CurrentSize_ -= i->Size_;
+					i = shard.Entries_.erase (i);
+				}
+				else
+					++i;
+		}
+
+		IndexRebuildWatcher_->deleteLater ();
+		IndexRebuildWatcher_ = nullptr;
+
+		if (CurrentSize_ > MaxSize_)
+			collectGarbage ();
+	}
 }
 }
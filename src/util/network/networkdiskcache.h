@@ -29,9 +29,12 @@
 
 #pragma once
 
-#include <QNetworkDiskCache>
+#include <array>
+#include <atomic>
+#include <QAbstractNetworkCache>
 #include <QMutex>
 #include <QHash>
+#include <QPair>
 #include "networkconfig.h"
 
 template<typename T>
@@ -46,26 +49,64 @@ namespace Util
 	 * This class is thread-safe unlike the original QNetworkDiskCache,
 	 * thus it can be used from multiple threads simultaneously.
 	 *
-	 * Also, old cache data is automatically removed from the cache in a
-	 * background thread without blocking. The garbage collection can be
-	 * also triggered manually via the collectGarbage() slot.
+	 * The cache keeps an in-memory index of its entries with their sizes
+	 * and last access times. The index is split into several shards,
+	 * each guarded by its own lock, so that requests for different URLs
+	 * rarely contend with each other. The index is persisted on
+	 * destruction and after each garbage collection.
+	 *
+	 * A marker file is kept in the cache directory while the cache is
+	 * in use and is removed only after the index is saved on
+	 * destruction. If the marker is present on startup, the previous
+	 * session has crashed and the index may be stale, so the cache
+	 * directory is scanned in background and reconciled with the
+	 * index: orphaned files are indexed and entries whose files are
+	 * gone are dropped. The directory is also scanned if the index is
+	 * missing.
+	 *
+	 * Old cache data is automatically removed from the cache in a
+	 * background thread without blocking, least recently accessed
+	 * entries first. The garbage collection can be also triggered
+	 * manually via the collectGarbage() slot.
 	 *
 	 * The garbage is collected until cache takes 90% of its maximum size.
 	 *
 	 * @ingroup NetworkUtil
 	 */
-	class UTIL_NETWORK_API NetworkDiskCache : public QNetworkDiskCache
+	class UTIL_NETWORK_API NetworkDiskCache : public QAbstractNetworkCache
 	{
 		Q_OBJECT
+	public:
+		struct IndexEntry
+		{
+			qint64 Size_;
+			qint64 LastAccess_;
+		};
+
+		typedef QList<QPair<QByteArray, IndexEntry>> IndexEntries_t;
+	private:
+		struct Shard
+		{
+			mutable QMutex Lock_;
+			QHash<QByteArray, IndexEntry> Entries_;
+		};
+
+		static const int ShardsCount = 16;
+
+		const QString CacheDir_;
+		const QString DataDir_;
 
-		qint64 CurrentSize_;
+		std::array<Shard, ShardsCount> Shards_;
 
-		mutable QMutex InsertRemoveMutex_;
+		std::atomic<qint64> CurrentSize_;
+		std::atomic<qint64> MaxSize_;
 
-		QFutureWatcher<qint64> *GarbageCollectorWatcher_;
+		QMutex PendingMutex_;
+		QHash<QIODevice*, QByteArray> PendingDev2Key_;
+		QHash<QByteArray, QList<QIODevice*>> PendingKey2Devs_;
 
-		QHash<QIODevice*, QUrl> PendingDev2Url_;
-		QHash<QUrl, QList<QIODevice*>> PendingUrl2Devs_;
+		QFutureWatcher<void> *GarbageCollectorWatcher_;
+		QFutureWatcher<IndexEntries_t> *IndexRebuildWatcher_;
 	public:
 		/** @brief Constructs the new disk cache.
 		 *
@@ -82,46 +123,69 @@ namespace Util
 		/** @brief Destroys the cache.
 		 *
 		 * Destroys the cache object, possibly blocking until the garbage
-		 * collector finishes if it is running.
+		 * collector finishes if it is running, and saves the index.
 		 */
 		~NetworkDiskCache ();
 
-		/** @brief Reimplemented from QNetworkDiskCache.
+		/** @brief Returns the directory this cache is stored in.
+		 */
+		QString cacheDirectory () const;
+
+		/** @brief Returns the maximum size of the cache in bytes.
+		 */
+		qint64 maximumCacheSize () const;
+
+		/** @brief Sets the maximum size of the cache in bytes.
+		 *
+		 * Triggers the garbage collector if the cache is already larger.
+		 *
+		 * @param[in] size The new maximum size.
+		 */
+		void setMaximumCacheSize (qint64 size);
+
+		/** @brief Reimplemented from QAbstractNetworkCache.
 		 */
 		virtual qint64 cacheSize () const;
 
-		/** @brief Reimplemented from QNetworkDiskCache.
+		/** @brief Reimplemented from QAbstractNetworkCache.
 		 */
 		virtual QIODevice* data (const QUrl& url);
 
-		/** @brief Reimplemented from QNetworkDiskCache.
+		/** @brief Reimplemented from QAbstractNetworkCache.
 		 */
 		virtual void insert (QIODevice *device);
 
-		/** @brief Reimplemented from QNetworkDiskCache.
+		/** @brief Reimplemented from QAbstractNetworkCache.
 		 */
 		virtual QNetworkCacheMetaData metaData (const QUrl& url);
 
-		/** @brief Reimplemented from QNetworkDiskCache.
+		/** @brief Reimplemented from QAbstractNetworkCache.
 		 */
 		virtual QIODevice* prepare (const QNetworkCacheMetaData&);
 
-		/** @brief Reimplemented from QNetworkDiskCache.
+		/** @brief Reimplemented from QAbstractNetworkCache.
 		 */
 		virtual bool remove (const QUrl& url);
 
-		/** @brief Reimplemented from QNetworkDiskCache.
+		/** @brief Reimplemented from QAbstractNetworkCache.
 		 */
 		virtual void updateMetaData (const QNetworkCacheMetaData& metaData);
-	protected:
-		/** @brief Reimplemented from QNetworkDiskCache.
-		 *
-		 * Runs the garbage collector if required.
-		 *
-		 * @sa collectGarbage()
-		 */
-		virtual qint64 expire ();
+	private:
+		Shard& GetShard (const QByteArray& key);
+		QString GetEntryPath (const QByteArray& key) const;
+
+		void RemoveEntry (const QByteArray& key);
+		void RunCollector (qint64 goal);
+
+		bool LoadIndex ();
+		bool SaveIndex () const;
+
+		QString GetDirtyMarkerPath () const;
 	public slots:
+		/** @brief Reimplemented from QAbstractNetworkCache.
+		 */
+		virtual void clear ();
+
 		/** @brief Runs the garbage collector.
 		 *
 		 * This function initiates garbage collection in a background
@@ -132,7 +196,7 @@ namespace Util
 		void collectGarbage ();
 	private slots:
 		void handleCollectorFinished ();
+		void handleIndexRebuilt ();
 	};
 }
 }
-
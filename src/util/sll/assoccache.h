@@ -30,68 +30,70 @@
 #pragma once
 
 #include <algorithm>
+#include <list>
+#include <vector>
+#include <memory>
+#include <boost/optional.hpp>
 #include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
 
 namespace LeechCraft
 {
 namespace Util
 {
-	namespace CacheStrat
+	/** @brief Hit and miss counters of a cache.
+	 */
+	struct CacheStats
 	{
-		class LRU
-		{
-			size_t Current_ = 0;
-		public:
-			struct ValueAddon
-			{
-				size_t LastAccess_ = 0;
-
-				ValueAddon () = default;
-
-				ValueAddon (size_t la)
-				: LastAccess_ { la }
-				{
-				}
-			};
-
-			ValueAddon CreateInfo ()
-			{
-				return { ++Current_ };
-			}
-
-			void Clear ()
-			{
-				Current_ = 0;
-			}
+		/** @brief The number of lookups that found the key.
+		 */
+		quint64 Hits_ = 0;
 
-			void Touch (ValueAddon& add)
-			{
-				add.LastAccess_ = ++Current_;
-			}
-		};
+		/** @brief The number of lookups that didn't find the key.
+		 */
+		quint64 Misses_ = 0;
 
-		inline bool operator< (const LRU::ValueAddon& v1, const LRU::ValueAddon& v2)
-		{
-			return v1.LastAccess_ < v2.LastAccess_;
-		}
-	}
+		/** @brief The number of entries evicted due to the cost limit.
+		 */
+		quint64 Evictions_ = 0;
+	};
 
-	template<typename K, typename V, typename CS = CacheStrat::LRU>
+	/** @brief A cost-limited associative cache with LRU eviction.
+	 *
+	 * Each entry has a cost (1 by default), and the least recently used
+	 * entries are evicted once the total cost exceeds the maximum cost
+	 * passed to the constructor. All operations are O(1): entries are
+	 * kept in a list ordered by recency, and the hash maps keys to the
+	 * list nodes.
+	 *
+	 * The entry that has just been inserted is never evicted, even if
+	 * its cost alone exceeds the maximum cost.
+	 *
+	 * This class is not thread-safe, see ConcurrentAssocCache for a
+	 * thread-safe version.
+	 *
+	 * @tparam K The type of the keys, should be usable with QHash.
+	 * @tparam V The type of the values.
+	 */
+	template<typename K, typename V>
 	class AssocCache
 	{
-		struct ValueHolder
+		struct Node
 		{
+			K Key_;
 			V V_;
 			size_t Cost_;
-			typename CS::ValueAddon CacheInfo_;
 		};
 
-		QHash<K, ValueHolder> Hash_;
+		typedef std::list<Node> List_t;
+		List_t List_;
+		QHash<K, typename List_t::iterator> Hash_;
 
 		size_t CurrentCost_ = 0;
-		const size_t MaxCost_;
+		size_t MaxCost_;
 
-		CS CacheStratState_;
+		CacheStats Stats_;
 	public:
 		AssocCache (size_t maxCost)
 		: MaxCost_ { maxCost }
@@ -100,59 +102,291 @@ namespace Util
 
 		size_t size () const;
 		void clear ();
+
+		/** @brief Checks whether the key is in the cache.
+		 *
+		 * Neither the recency of the key nor the hit/miss statistics
+		 * are affected.
+		 */
 		bool contains (const K&) const;
 
+		/** @brief Returns the value for the key, inserting it if needed.
+		 *
+		 * The default-constructed value with the cost of 1 is inserted if
+		 * there is no such key in the cache. The key becomes the most
+		 * recently used one.
+		 */
 		V& operator[] (const K&);
+
+		/** @brief Returns the pointer to the value for the given key.
+		 *
+		 * The key becomes the most recently used one.
+		 *
+		 * @return The pointer to the value or nullptr if there is no such
+		 * key. The pointer is valid until the entry is evicted or removed.
+		 */
+		V* object (const K&);
+
+		/** @brief Inserts or replaces the value for the given key.
+		 */
+		void insert (const K&, const V&, size_t cost = 1);
+
+		/** @brief Removes the given key from the cache.
+		 *
+		 * @return Whether there was such key.
+		 */
+		bool remove (const K&);
+
+		size_t totalCost () const;
+		size_t maxCost () const;
+		void setMaxCost (size_t);
+
+		CacheStats stats () const;
+		void resetStats ();
 	private:
+		void Touch (typename List_t::iterator);
 		void CheckShrink ();
 	};
 
-	template<typename K, typename V, typename CS>
-	size_t AssocCache<K, V, CS>::size () const
+	template<typename K, typename V>
+	size_t AssocCache<K, V>::size () const
 	{
 		return Hash_.size ();
 	}
 
-	template<typename K, typename V, typename CS>
-	void AssocCache<K, V, CS>::clear ()
+	template<typename K, typename V>
+	void AssocCache<K, V>::clear ()
 	{
 		Hash_.clear ();
-		CacheStratState_.Clear ();
+		List_.clear ();
+		CurrentCost_ = 0;
 	}
 
-	template<typename K, typename V, typename CS>
-	bool AssocCache<K, V, CS>::contains (const K& k) const
+	template<typename K, typename V>
+	bool AssocCache<K, V>::contains (const K& k) const
 	{
 		return Hash_.contains (k);
 	}
 
-	template<typename K, typename V, typename CS>
-	V& AssocCache<K, V, CS>::operator[] (const K& key)
+	template<typename K, typename V>
+	V& AssocCache<K, V>::operator[] (const K& key)
+	{
+		if (const auto value = object (key))
+			return *value;
+
+		insert (key, V {});
+		return List_.front ().V_;
+	}
+
+	template<typename K, typename V>
+	V* AssocCache<K, V>::object (const K& key)
 	{
-		if (!Hash_.contains (key))
+		const auto pos = Hash_.find (key);
+		if (pos == Hash_.end ())
 		{
-			Hash_.insert (key, { {}, 1, CacheStratState_.CreateInfo () });
-			++CurrentCost_;
+			++Stats_.Misses_;
+			return nullptr;
+		}
+
+		++Stats_.Hits_;
+		Touch (*pos);
+		return &List_.front ().V_;
+	}
 
-			CheckShrink ();
+	template<typename K, typename V>
+	void AssocCache<K, V>::insert (const K& key, const V& value, size_t cost)
+	{
+		const auto pos = Hash_.find (key);
+		if (pos != Hash_.end ())
+		{
+			const auto node = *pos;
+			CurrentCost_ -= node->Cost_;
+			node->V_ = value;
+			node->Cost_ = cost;
+			Touch (node);
 		}
 		else
-			CacheStratState_.Touch (Hash_ [key].CacheInfo_);
+		{
+			List_.push_front ({ key, value, cost });
+			Hash_.insert (key, List_.begin ());
+		}
+
+		CurrentCost_ += cost;
+		CheckShrink ();
+	}
 
-		return Hash_ [key].V_;
+	template<typename K, typename V>
+	bool AssocCache<K, V>::remove (const K& key)
+	{
+		const auto pos = Hash_.find (key);
+		if (pos == Hash_.end ())
+			return false;
+
+		CurrentCost_ -= (*pos)->Cost_;
+		List_.erase (*pos);
+		Hash_.erase (pos);
+		return true;
+	}
+
+	template<typename K, typename V>
+	size_t AssocCache<K, V>::totalCost () const
+	{
+		return CurrentCost_;
+	}
+
+	template<typename K, typename V>
+	size_t AssocCache<K, V>::maxCost () const
+	{
+		return MaxCost_;
+	}
+
+	template<typename K, typename V>
+	void AssocCache<K, V>::setMaxCost (size_t cost)
+	{
+		MaxCost_ = cost;
+		CheckShrink ();
 	}
 
-	template<typename K, typename V, typename CS>
-	void AssocCache<K, V, CS>::CheckShrink ()
+	template<typename K, typename V>
+	CacheStats AssocCache<K, V>::stats () const
 	{
-		while (CurrentCost_ > MaxCost_)
+		return Stats_;
+	}
+
+	template<typename K, typename V>
+	void AssocCache<K, V>::resetStats ()
+	{
+		Stats_ = CacheStats {};
+	}
+
+	template<typename K, typename V>
+	void AssocCache<K, V>::Touch (typename List_t::iterator node)
+	{
+		if (node != List_.begin ())
+			List_.splice (List_.begin (), List_, node);
+	}
+
+	template<typename K, typename V>
+	void AssocCache<K, V>::CheckShrink ()
+	{
+		while (CurrentCost_ > MaxCost_ && List_.size () > 1)
 		{
-			const auto pos = std::min_element (Hash_.begin (), Hash_.end (),
-					[] (const ValueHolder& left, const ValueHolder& right)
-						{ return left.CacheInfo_ < right.CacheInfo_; });
-			CurrentCost_ -= pos->Cost_;
-			Hash_.erase (pos);
+			const auto& last = List_.back ();
+			CurrentCost_ -= last.Cost_;
+			Hash_.remove (last.Key_);
+			List_.pop_back ();
+			++Stats_.Evictions_;
 		}
 	}
+
+	/** @brief A thread-safe version of AssocCache.
+	 *
+	 * The keys are distributed between several independent AssocCache
+	 * shards by their hash, and each shard is guarded by its own mutex,
+	 * so that threads accessing different keys rarely contend. The
+	 * maximum cost is split evenly between the shards, thus the eviction
+	 * order is LRU per shard.
+	 *
+	 * Since an entry may be evicted by another thread at any time, this
+	 * class returns values by copy.
+	 *
+	 * @tparam K The type of the keys, should be usable with QHash.
+	 * @tparam V The type of the values.
+	 */
+	template<typename K, typename V>
+	class ConcurrentAssocCache
+	{
+		struct Shard
+		{
+			mutable QMutex Mutex_;
+			AssocCache<K, V> Cache_;
+
+			Shard (size_t maxCost)
+			: Cache_ { maxCost }
+			{
+			}
+		};
+
+		std::vector<std::unique_ptr<Shard>> Shards_;
+	public:
+		/** @brief Constructs the cache.
+		 *
+		 * @param[in] maxCost The maximum total cost of the cache.
+		 * @param[in] shards The number of independently locked shards.
+		 */
+		ConcurrentAssocCache (size_t maxCost, int shards = 16)
+		{
+			shards = std::max (shards, 1);
+			const size_t shardCost = std::max<size_t> (maxCost / shards, 1);
+			for (int i = 0; i < shards; ++i)
+				Shards_.emplace_back (new Shard { shardCost });
+		}
+
+		/** @brief Returns the value for the key, if any.
+		 *
+		 * The key becomes the most recently used one in its shard.
+		 */
+		boost::optional<V> value (const K& key)
+		{
+			auto& shard = GetShard (key);
+			QMutexLocker locker (&shard.Mutex_);
+			if (const auto ptr = shard.Cache_.object (key))
+				return *ptr;
+			return {};
+		}
+
+		void insert (const K& key, const V& value, size_t cost = 1)
+		{
+			auto& shard = GetShard (key);
+			QMutexLocker locker (&shard.Mutex_);
+			shard.Cache_.insert (key, value, cost);
+		}
+
+		bool remove (const K& key)
+		{
+			auto& shard = GetShard (key);
+			QMutexLocker locker (&shard.Mutex_);
+			return shard.Cache_.remove (key);
+		}
+
+		void clear ()
+		{
+			for (const auto& shard : Shards_)
+			{
+				QMutexLocker locker (&shard->Mutex_);
+				shard->Cache_.clear ();
+			}
+		}
+
+		size_t size () const
+		{
+			size_t result = 0;
+			for (const auto& shard : Shards_)
+			{
+				QMutexLocker locker (&shard->Mutex_);
+				result += shard->Cache_.size ();
+			}
+			return result;
+		}
+
+		CacheStats stats () const
+		{
+			CacheStats result;
+			for (const auto& shard : Shards_)
+			{
+				QMutexLocker locker (&shard->Mutex_);
+				const auto& stats = shard->Cache_.stats ();
+				result.Hits_ += stats.Hits_;
+				result.Misses_ += stats.Misses_;
+				result.Evictions_ += stats.Evictions_;
+			}
+			return result;
+		}
+	private:
+		Shard& GetShard (const K& key) const
+		{
+			return *Shards_ [qHash (key) % Shards_.size ()];
+		}
+	};
 }
 }
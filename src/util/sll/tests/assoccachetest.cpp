@@ -0,0 +1,249 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "assoccachetest.h"
+#include <QtTest>
+#include "../assoccache.h"
+
+QTEST_MAIN (LeechCraft::Util::AssocCacheTest)
+
+namespace LeechCraft
+{
+namespace Util
+{
+	namespace
+	{
+		/** The cache as it was before the linked list based LRU, evicting
+			* via a linear search for the least recently used entry.
+			*/
+		template<typename K, typename V>
+		class MinElementCache
+		{
+			struct ValueHolder
+			{
+				V V_;
+				size_t LastAccess_;
+			};
+
+			QHash<K, ValueHolder> Hash_;
+			size_t Current_ = 0;
+			const size_t MaxCost_;
+		public:
+			MinElementCache (size_t maxCost)
+			: MaxCost_ { maxCost }
+			{
+			}
+
+			V& operator[] (const K& key)
+			{
+				if (!Hash_.contains (key))
+				{
+					Hash_.insert (key, { {}, ++Current_ });
+					while (static_cast<size_t> (Hash_.size ()) > MaxCost_)
+					{
+						const auto pos = std::min_element (Hash_.begin (), Hash_.end (),
+								[] (const ValueHolder& left, const ValueHolder& right)
+									{ return left.LastAccess_ < right.LastAccess_; });
+						Hash_.erase (pos);
+					}
+				}
+				else
+					Hash_ [key].LastAccess_ = ++Current_;
+
+				return Hash_ [key].V_;
+			}
+		};
+
+		const int BenchCacheSize = 1000;
+		const int BenchKeysCount = 20000;
+	}
+
+	void AssocCacheTest::testLRUOrder ()
+	{
+		AssocCache<int, QString> cache { 3 };
+		cache.insert (1, "one");
+		cache.insert (2, "two");
+		cache.insert (3, "three");
+
+		QVERIFY (cache.object (1));
+		cache.insert (4, "four");
+
+		QCOMPARE (cache.size (), size_t { 3 });
+		QVERIFY (cache.contains (1));
+		QVERIFY (!cache.contains (2));
+		QVERIFY (cache.contains (3));
+		QVERIFY (cache.contains (4));
+
+		cache [3];
+		cache [5];
+		QVERIFY (!cache.contains (1));
+		QVERIFY (cache.contains (3));
+	}
+
+	void AssocCacheTest::testCostEviction ()
+	{
+		AssocCache<int, int> cache { 10 };
+		cache.insert (1, 1, 4);
+		cache.insert (2, 2, 4);
+		QCOMPARE (cache.totalCost (), size_t { 8 });
+
+		cache.insert (3, 3, 4);
+		QVERIFY (!cache.contains (1));
+		QVERIFY (cache.contains (2));
+		QVERIFY (cache.contains (3));
+		QCOMPARE (cache.totalCost (), size_t { 8 });
+		QCOMPARE (cache.stats ().Evictions_, quint64 { 1 });
+	}
+
+	void AssocCacheTest::testJustInsertedKept ()
+	{
+		AssocCache<int, int> cache { 5 };
+		cache.insert (1, 1);
+		cache.insert (2, 2);
+		cache.insert (3, 3, 10);
+
+		QCOMPARE (cache.size (), size_t { 1 });
+		QVERIFY (cache.contains (3));
+		QCOMPARE (*cache.object (3), 3);
+		QCOMPARE (cache.totalCost (), size_t { 10 });
+	}
+
+	void AssocCacheTest::testReplaceUpdatesCost ()
+	{
+		AssocCache<int, int> cache { 10 };
+		cache.insert (1, 1, 3);
+		cache.insert (2, 2, 3);
+		cache.insert (1, 10, 5);
+
+		QCOMPARE (cache.totalCost (), size_t { 8 });
+		QCOMPARE (*cache.object (1), 10);
+
+		QVERIFY (cache.remove (1));
+		QVERIFY (!cache.remove (1));
+		QCOMPARE (cache.totalCost (), size_t { 3 });
+	}
+
+	void AssocCacheTest::testSetMaxCostShrinks ()
+	{
+		AssocCache<int, int> cache { 10 };
+		for (int i = 0; i < 10; ++i)
+			cache.insert (i, i);
+
+		cache.setMaxCost (4);
+		QCOMPARE (cache.size (), size_t { 4 });
+		for (int i = 6; i < 10; ++i)
+			QVERIFY (cache.contains (i));
+	}
+
+	void AssocCacheTest::testStats ()
+	{
+		AssocCache<int, int> cache { 2 };
+		cache.insert (1, 1);
+		QVERIFY (cache.object (1));
+		QVERIFY (!cache.object (2));
+		cache [3];
+
+		const auto& stats = cache.stats ();
+		QCOMPARE (stats.Hits_, quint64 { 1 });
+		QCOMPARE (stats.Misses_, quint64 { 2 });
+
+		cache.resetStats ();
+		QCOMPARE (cache.stats ().Hits_, quint64 { 0 });
+		QCOMPARE (cache.stats ().Misses_, quint64 { 0 });
+	}
+
+	void AssocCacheTest::testContainsKeepsStats ()
+	{
+		AssocCache<int, int> cache { 2 };
+		cache.insert (1, 1);
+		QVERIFY (cache.contains (1));
+		QVERIFY (!cache.contains (2));
+
+		QCOMPARE (cache.stats ().Hits_, quint64 { 0 });
+		QCOMPARE (cache.stats ().Misses_, quint64 { 0 });
+	}
+
+	void AssocCacheTest::testConcurrentBasic ()
+	{
+		ConcurrentAssocCache<QString, int> cache { 64, 4 };
+		cache.insert ("a", 1);
+		cache.insert ("b", 2);
+
+		QCOMPARE (*cache.value ("a"), 1);
+		QCOMPARE (*cache.value ("b"), 2);
+		QVERIFY (!cache.value ("c"));
+
+		QVERIFY (cache.remove ("a"));
+		QVERIFY (!cache.value ("a"));
+		QCOMPARE (cache.size (), size_t { 1 });
+
+		const auto& stats = cache.stats ();
+		QCOMPARE (stats.Hits_, quint64 { 2 });
+		QCOMPARE (stats.Misses_, quint64 { 2 });
+
+		cache.clear ();
+		QCOMPARE (cache.size (), size_t { 0 });
+	}
+
+	void AssocCacheTest::testConcurrentEviction ()
+	{
+		const size_t maxCost = 64;
+		ConcurrentAssocCache<int, int> cache { maxCost, 4 };
+		for (int i = 0; i < 1000; ++i)
+			cache.insert (i, i);
+
+		QVERIFY (cache.size () <= maxCost);
+		QVERIFY (cache.size () > 0);
+		QCOMPARE (cache.stats ().Evictions_, quint64 { 1000 - cache.size () });
+
+		// The most recent key always survives in its shard.
+		QCOMPARE (*cache.value (999), 999);
+	}
+
+	void AssocCacheTest::benchEvictionLinked ()
+	{
+		QBENCHMARK
+		{
+			AssocCache<int, int> cache { BenchCacheSize };
+			for (int i = 0; i < BenchKeysCount; ++i)
+				cache [i] = i;
+		}
+	}
+
+	void AssocCacheTest::benchEvictionMinElement ()
+	{
+		QBENCHMARK
+		{
+			MinElementCache<int, int> cache { BenchCacheSize };
+			for (int i = 0; i < BenchKeysCount; ++i)
+				cache [i] = i;
+		}
+	}
+}
+}
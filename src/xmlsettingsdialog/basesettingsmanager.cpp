@@ -88,6 +88,16 @@ namespace Util
 			RegisterObject (*i, object, funcName, flags);
 	}
 
+	void BaseSettingsManager::RegisterSetting (const QByteArray& propName,
+			const std::function<void (const QVariant&)>& handler)
+	{
+		SettingHandlers_.insert (propName, handler);
+
+		const auto& value = property (propName.constData ());
+		if (value.isValid ())
+			handler (value);
+	}
+
 	QVariant BaseSettingsManager::Property (const QString& propName, const QVariant& def)
 	{
 		QVariant result = property (PROP2CHAR (propName));
@@ -163,6 +173,10 @@ namespace Util
 
 		PropertyChanged (propName, propValue);
 
+		for (auto i = SettingHandlers_.find (name), end = SettingHandlers_.end ();
+				i != end && i.key () == name; ++i)
+			(*i) (propValue);
+
 		if (ApplyProps_.contains (name))
 		{
 			const auto& objects = ApplyProps_.values (name);
@@ -30,7 +30,9 @@
 #pragma once
 
 #include <memory>
+#include <functional>
 #include <QMap>
+#include <QMultiHash>
 #include <QPair>
 #include <QObject>
 #include <QSettings>
@@ -63,6 +65,9 @@ namespace Util
 		Properties2Object_t ApplyProps_;
 		Properties2Object_t SelectProps_;
 
+		typedef std::function<void (const QVariant&)> SettingHandler_f;
+		QMultiHash<QByteArray, SettingHandler_f> SettingHandlers_;
+
 		bool IsInitializing_;
 		bool CleanupScheduled_;
 
@@ -128,6 +133,25 @@ namespace Util
 		void RegisterObject (const QList<QByteArray>& propNames,
 				QObject* object, const QByteArray& funcName, EventFlags flags = EventFlag::Apply);
 
+		/** @brief Subscribes a handler to the value of a property.
+		 *
+		 * Unlike RegisterObject(), the handler gets the new value of the
+		 * property directly. It is invoked immediately if the property
+		 * already has a valid value, and then after each change of the
+		 * property. This is mainly intended for the accessors generated
+		 * by the GenerateSettingsAccessors() CMake function, which cache
+		 * the values of the settings so that reading them doesn't go
+		 * through QObject::property().
+		 *
+		 * The handler is never unregistered, so it should not outlive
+		 * the objects it captures.
+		 *
+		 * @param[in] propName The name of the property.
+		 * @param[in] handler The handler to call with the new value.
+		 */
+		void RegisterSetting (const QByteArray& propName,
+				const std::function<void (const QVariant&)>& handler);
+
 		/** @brief Gets a property with default value.
 		 *
 		 * This is a wrapper around standard QObject::property() function.
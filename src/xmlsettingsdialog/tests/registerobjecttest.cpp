@@ -0,0 +1,178 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "registerobjecttest.h"
+#include <QtTest>
+#include <QDir>
+#include <QFile>
+#include <QSettings>
+#include <QTextStream>
+#include "../xmlsettingsdialog.h"
+#include "../basesettingsmanager.h"
+
+QTEST_MAIN (LeechCraft::Util::RegisterObjectTest)
+
+namespace LeechCraft
+{
+namespace Util
+{
+	namespace
+	{
+		const int PagesCount = 40;
+		const int ItemsPerPage = 50;
+
+		class TestSettingsManager : public BaseSettingsManager
+		{
+		public:
+			TestSettingsManager (QObject *parent)
+			: BaseSettingsManager { false, parent }
+			{
+			}
+		protected:
+			QSettings* BeginSettings () const
+			{
+				return new QSettings (QDir::temp ().filePath ("lc_xsd_registerobjecttest.ini"),
+						QSettings::IniFormat);
+			}
+
+			void EndSettings (QSettings*) const
+			{
+			}
+		};
+
+		QString GetPropName (int page, int item)
+		{
+			return QString ("Prop_%1_%2").arg (page).arg (item);
+		}
+
+		QByteArray GenerateSettingsXml ()
+		{
+			QByteArray result;
+			QTextStream str (&result);
+			str << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<settings>\n";
+			for (int page = 0; page < PagesCount; ++page)
+			{
+				str << "<page><label value=\"Page " << page << "\" />\n";
+				for (int item = 0; item < ItemsPerPage; ++item)
+				{
+					const auto& prop = GetPropName (page, item);
+					switch (item % 4)
+					{
+					case 0:
+						str << "<item type=\"checkbox\" property=\"" << prop << "\" default=\"true\">";
+						break;
+					case 1:
+						str << "<item type=\"spinbox\" property=\"" << prop
+								<< "\" default=\"" << item << "\" minimum=\"0\" maximum=\"1000\">";
+						break;
+					case 2:
+						str << "<item type=\"lineedit\" property=\"" << prop << "\" default=\"text\">";
+						break;
+					case 3:
+						str << "<item type=\"combobox\" property=\"" << prop << "\">"
+								<< "<option name=\"first\" default=\"true\"><label value=\"First\" /></option>"
+								<< "<option name=\"second\"><label value=\"Second\" /></option>";
+						break;
+					}
+					str << "<label value=\"Item " << item << "\" /></item>\n";
+				}
+				str << "</page>\n";
+			}
+			str << "</settings>\n";
+			str.flush ();
+			return result;
+		}
+	}
+
+	void RegisterObjectTest::initTestCase ()
+	{
+		SettingsPath_ = QDir::temp ().filePath ("lc_xsd_registerobjecttest.xml");
+
+		QFile file (SettingsPath_);
+		QVERIFY (file.open (QIODevice::WriteOnly));
+		file.write (GenerateSettingsXml ());
+
+		// The settings thread keeps pointers to the managers whose
+		// properties have changed, so the manager outlives all the tests.
+		Manager_ = new TestSettingsManager (this);
+	}
+
+	void RegisterObjectTest::cleanupTestCase ()
+	{
+		QFile::remove (SettingsPath_);
+		QFile::remove (QDir::temp ().filePath ("lc_xsd_registerobjecttest.ini"));
+	}
+
+	void RegisterObjectTest::testPropertiesInitialized ()
+	{
+		XmlSettingsDialog dia;
+		dia.RegisterObject (Manager_, SettingsPath_);
+
+		QCOMPARE (dia.GetPages ().size (), PagesCount);
+
+		const auto& lastPageProp = GetPropName (PagesCount - 1, 1);
+		QCOMPARE (Manager_->property (lastPageProp.toLatin1 ().constData ()).toInt (), 1);
+
+		const auto& checkProp = GetPropName (PagesCount - 1, 0);
+		QCOMPARE (Manager_->property (checkProp.toLatin1 ().constData ()).toBool (), true);
+	}
+
+	void RegisterObjectTest::testPagesBuiltOnDemand ()
+	{
+		XmlSettingsDialog dia;
+		dia.RegisterObject (Manager_, SettingsPath_);
+
+		const auto& prop = GetPropName (PagesCount - 1, 0);
+		QVERIFY (!dia.findChild<QWidget*> (prop));
+
+		dia.SetPage (PagesCount - 1);
+		QVERIFY (dia.findChild<QWidget*> (prop));
+	}
+
+	void RegisterObjectTest::benchRegisterLazy ()
+	{
+		QBENCHMARK
+		{
+			XmlSettingsDialog dia;
+			dia.RegisterObject (Manager_, SettingsPath_);
+		}
+	}
+
+	void RegisterObjectTest::benchRegisterAllPages ()
+	{
+		QBENCHMARK
+		{
+			XmlSettingsDialog dia;
+			dia.RegisterObject (Manager_, SettingsPath_);
+			for (int i = 0; i < PagesCount; ++i)
+				dia.SetPage (i);
+		}
+	}
+}
+}
@@ -0,0 +1,131 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "settingsaccessorstest.h"
+#include <type_traits>
+#include <QtTest>
+#include <QDir>
+#include <QSettings>
+#include "xmlsettingsaccessors.h"
+
+QTEST_MAIN (LeechCraft::Util::SettingsAccessorsTest)
+
+namespace LeechCraft
+{
+namespace Util
+{
+	namespace
+	{
+		class TestSettingsManager : public BaseSettingsManager
+		{
+		public:
+			TestSettingsManager (QObject *parent)
+			: BaseSettingsManager { false, parent }
+			{
+			}
+		protected:
+			QSettings* BeginSettings () const
+			{
+				return new QSettings (QDir::temp ().filePath ("lc_xsd_settingsaccessorstest.ini"),
+						QSettings::IniFormat);
+			}
+
+			void EndSettings (QSettings*) const
+			{
+			}
+		};
+	}
+
+	// The settings thread keeps pointers to the managers whose properties
+	// have changed, so the managers are parented to the test object.
+
+	void SettingsAccessorsTest::testCheckboxDefaults ()
+	{
+		Test::XmlSettingsAccessors acc { new TestSettingsManager (this) };
+
+		static_assert (std::is_same<decltype (acc.EnabledOption ()), bool>::value,
+				"checkbox accessors should be bool");
+		QCOMPARE (acc.EnabledOption (), true);
+		QCOMPARE (acc.DisabledOption (), false);
+	}
+
+	void SettingsAccessorsTest::testSpinboxDefaults ()
+	{
+		Test::XmlSettingsAccessors acc { new TestSettingsManager (this) };
+
+		static_assert (std::is_same<decltype (acc.Count ()), int>::value,
+				"spinbox accessors should be int");
+		QCOMPARE (acc.Count (), 42);
+		QCOMPARE (acc.NegativeCount (), -3);
+		QCOMPARE (acc.NoDefaultCount (), 0);
+	}
+
+	void SettingsAccessorsTest::testDuplicateProperty ()
+	{
+		// The second, lineedit, declaration of Count is skipped, otherwise
+		// the generated class wouldn't even compile, and the first one
+		// defines both the type and the default.
+		const auto mgr = new TestSettingsManager (this);
+		Test::XmlSettingsAccessors acc { mgr };
+
+		static_assert (std::is_same<decltype (acc.Count ()), int>::value,
+				"the first declaration should define the type");
+		QCOMPARE (acc.Count (), 42);
+
+		mgr->setProperty ("Count", "7");
+		QCOMPARE (acc.Count (), 7);
+	}
+
+	void SettingsAccessorsTest::testStoredValuesOverrideDefaults ()
+	{
+		const auto mgr = new TestSettingsManager (this);
+		mgr->setProperty ("EnabledOption", false);
+		mgr->setProperty ("Count", 13);
+
+		Test::XmlSettingsAccessors acc { mgr };
+		QCOMPARE (acc.EnabledOption (), false);
+		QCOMPARE (acc.Count (), 13);
+		QCOMPARE (acc.NegativeCount (), -3);
+	}
+
+	void SettingsAccessorsTest::testUpdates ()
+	{
+		const auto mgr = new TestSettingsManager (this);
+		Test::XmlSettingsAccessors acc { mgr };
+
+		mgr->setProperty ("DisabledOption", true);
+		mgr->setProperty ("NoDefaultCount", 99);
+		QCOMPARE (acc.DisabledOption (), true);
+		QCOMPARE (acc.NoDefaultCount (), 99);
+
+		mgr->setProperty ("DisabledOption", false);
+		QCOMPARE (acc.DisabledOption (), false);
+	}
+}
+}
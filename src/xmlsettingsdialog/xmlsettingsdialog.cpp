@@ -64,6 +64,11 @@ namespace Util
 		mainLay->addWidget (Pages_);
 		setLayout (mainLay);
 
+		connect (Pages_,
+				SIGNAL (currentChanged (int)),
+				this,
+				SLOT (handlePageChanged (int)));
+
 		DefaultLang_ = "en";
 	}
 
@@ -194,9 +199,10 @@ namespace Util
 			QWidget *object = findChild<QWidget*> (propName);
 			if (!object)
 			{
-				qWarning () << Q_FUNC_INFO
-					<< "could not find object for property"
-					<< propName;
+				if (PageBuilt_.value (Name2Page_.value (propName, -1)))
+					qWarning () << Q_FUNC_INFO
+						<< "could not find object for property"
+						<< propName;
 				continue;
 			}
 			HandlersManager_->SetValue (object, value);
@@ -286,6 +292,9 @@ namespace Util
 
 	QList<int> XmlSettingsDialog::HighlightMatches (const QString& query)
 	{
+		if (!query.isEmpty ())
+			BuildAllPages ();
+
 		QList<int> result;
 		if (query.isEmpty ())
 		{
@@ -315,15 +324,40 @@ namespace Util
 
 	void XmlSettingsDialog::SetCustomWidget (const QString& name, QWidget *widget)
 	{
-		QList<QWidget*> widgets = findChildren<QWidget*> (name);
-		if (!widgets.size ())
-			throw std::runtime_error (qPrintable (QString ("Widget %1 not "
-							"found").arg (name)));
-		if (widgets.size () > 1)
-			throw std::runtime_error (qPrintable (QString ("Widget %1 "
-							"appears to exist more than once").arg (name)));
+		const auto page = Name2Page_.value (name, -1);
+		if (page >= 0 && !PageBuilt_.at (page))
+		{
+			int count = 0;
+			const auto& items = PageElements_.at (page).elementsByTagName ("item");
+			for (int i = 0; i < items.size (); ++i)
+			{
+				const auto& item = items.at (i).toElement ();
+				if (item.attribute ("type") == "customwidget" &&
+						item.attribute ("name") == name)
+					++count;
+			}
+			if (count > 1)
+				throw std::runtime_error (qPrintable (QString ("Widget %1 "
+								"appears to exist more than once").arg (name)));
+
+			// The placeholder will be created when the page is shown.
+			widget->setParent (this);
+			widget->hide ();
+			PendingCustoms_.append (qMakePair (name, widget));
+		}
+		else
+		{
+			QList<QWidget*> widgets = findChildren<QWidget*> (name);
+			if (!widgets.size ())
+				throw std::runtime_error (qPrintable (QString ("Widget %1 not "
+								"found").arg (name)));
+			if (widgets.size () > 1)
+				throw std::runtime_error (qPrintable (QString ("Widget %1 "
+								"appears to exist more than once").arg (name)));
+
+			widgets.at (0)->layout ()->addWidget (widget);
+		}
 
-		widgets.at (0)->layout ()->addWidget (widget);
 		Customs_ << widget;
 		connect (widget,
 				SIGNAL (destroyed (QObject*)),
@@ -334,11 +368,16 @@ namespace Util
 	void XmlSettingsDialog::SetDataSource (const QString& property,
 			QAbstractItemModel *dataSource)
 	{
-		HandlersManager_->SetDataSource (property, dataSource, this);
+		const auto page = Name2Page_.value (property, -1);
+		if (page >= 0 && !PageBuilt_.at (page))
+			PendingDataSources_ [property] = dataSource;
+		else
+			HandlersManager_->SetDataSource (property, dataSource, this);
 	}
 
 	void XmlSettingsDialog::SetPage (int page)
 	{
+		BuildPage (page);
 		Pages_->setCurrentIndex (page);
 	}
 
@@ -358,12 +397,54 @@ namespace Util
 		const QString& sectionTitle = GetLabel (page);
 		Titles_ << sectionTitle;
 
+		const auto index = PageElements_.size ();
+		PageElements_ << page;
+		PageBuilt_ << false;
+
+		// The widgets are built only when the page is shown for the first
+		// time, see BuildPage().
 		QWidget *baseWidget = new QWidget;
 		Pages_->addWidget (baseWidget);
 		QGridLayout *lay = new QGridLayout;
 		lay->setContentsMargins (0, 0, 0, 0);
 		baseWidget->setLayout (lay);
 
+		InitPageValues (page, index);
+	}
+
+	void XmlSettingsDialog::InitPageValues (const QDomElement& page, int index)
+	{
+		const auto& items = page.elementsByTagName ("item");
+		for (int i = 0; i < items.size (); ++i)
+		{
+			const auto& item = items.at (i).toElement ();
+			const auto& type = item.attribute ("type");
+			if (type.isEmpty ())
+				continue;
+
+			if (type == "customwidget")
+				Name2Page_ [item.attribute ("name")] = index;
+
+			const auto& property = item.attribute ("property");
+			if (property.isEmpty ())
+				continue;
+
+			Name2Page_ [property] = index;
+			WorkingObject_->setProperty (property.toLatin1 ().constData (), GetValue (item));
+		}
+	}
+
+	void XmlSettingsDialog::BuildPage (int index)
+	{
+		if (index < 0 || index >= PageBuilt_.size () || PageBuilt_.at (index))
+			return;
+
+		PageBuilt_ [index] = true;
+
+		const auto& page = PageElements_.at (index);
+		const auto baseWidget = Pages_->widget (index);
+		const auto lay = qobject_cast<QGridLayout*> (baseWidget->layout ());
+
 		ParseEntity (page, baseWidget);
 
 		bool foundExpanding = false;
@@ -380,6 +461,47 @@ namespace Util
 			QSpacerItem *verticalSpacer = new QSpacerItem (0, 0, QSizePolicy::Minimum, QSizePolicy::Expanding);
 			lay->addItem (verticalSpacer, lay->rowCount (), 0, 1, 2);
 		}
+
+		for (auto i = PendingCustoms_.begin (); i != PendingCustoms_.end (); )
+		{
+			if (Name2Page_.value (i->first, -1) != index)
+			{
+				++i;
+				continue;
+			}
+
+			const auto placeholder = findChild<QWidget*> (i->first);
+			if (placeholder && placeholder->layout ())
+			{
+				placeholder->layout ()->addWidget (i->second);
+				i->second->show ();
+			}
+			else
+				qWarning () << Q_FUNC_INFO
+						<< "no placeholder for"
+						<< i->first;
+
+			i = PendingCustoms_.erase (i);
+		}
+
+		for (auto i = PendingDataSources_.begin (); i != PendingDataSources_.end (); )
+		{
+			if (Name2Page_.value (i.key (), -1) != index)
+			{
+				++i;
+				continue;
+			}
+
+			if (*i)
+				HandlersManager_->SetDataSource (i.key (), *i, this);
+			i = PendingDataSources_.erase (i);
+		}
+	}
+
+	void XmlSettingsDialog::BuildAllPages ()
+	{
+		for (int i = 0; i < PageBuilt_.size (); ++i)
+			BuildPage (i);
 	}
 
 	void XmlSettingsDialog::ParseEntity (const QDomElement& entity, QWidget *baseWidget)
@@ -474,15 +596,11 @@ namespace Util
 	{
 		const QString& type = item.attribute ("type");
 
-		const QString& property = item.attribute ("property");
-
 		if (type.isEmpty () || type.isNull ())
 			return;
 
 		if (!HandlersManager_->Handle (item, baseWidget))
 			qWarning () << Q_FUNC_INFO << "unhandled type" << type;
-
-		WorkingObject_->setProperty (property.toLatin1 ().constData (), GetValue (item));
 	}
 
 #if defined (Q_OS_WIN32)
@@ -710,6 +828,12 @@ namespace Util
 			return QWidget::eventFilter (obj, event);
 	}
 
+	void XmlSettingsDialog::showEvent (QShowEvent *event)
+	{
+		BuildPage (Pages_->currentIndex ());
+		QWidget::showEvent (event);
+	}
+
 	void XmlSettingsDialog::accept ()
 	{
 		const auto& props = HandlersManager_->GetNewValues ();
@@ -749,10 +873,20 @@ namespace Util
 			QMetaObject::invokeMethod (widget, "reject");
 	}
 
+	void XmlSettingsDialog::handlePageChanged (int page)
+	{
+		BuildPage (page);
+	}
+
 	void XmlSettingsDialog::handleCustomDestroyed ()
 	{
-		QWidget *widget = qobject_cast<QWidget*> (sender ());
+		QWidget *widget = static_cast<QWidget*> (sender ());
 		Customs_.removeAll (widget);
+		for (auto i = PendingCustoms_.begin (); i != PendingCustoms_.end (); )
+			if (i->second == widget)
+				i = PendingCustoms_.erase (i);
+			else
+				++i;
 	}
 
 	void XmlSettingsDialog::handleMoreThisStuffRequested ()
@@ -772,6 +906,11 @@ namespace Util
 		if (name.isEmpty ())
 			return;
 
+		if (Name2Page_.contains (name))
+			BuildPage (Name2Page_ [name]);
+		else
+			BuildAllPages ();
+
 		auto child = findChild<QWidget*> (name);
 		if (!child)
 		{
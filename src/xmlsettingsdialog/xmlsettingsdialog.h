@@ -33,13 +33,15 @@
 #include <QWidget>
 #include <QString>
 #include <QMap>
+#include <QHash>
+#include <QPointer>
 #include <QVariant>
+#include <QDomElement>
 #include "xsdconfig.h"
 
 class QStackedWidget;
 class QListWidget;
 class QPushButton;
-class QDomElement;
 class QGridLayout;
 class QDomDocument;
 class QAbstractItemModel;
@@ -64,6 +66,12 @@ namespace Util
 		QList<QWidget*> Customs_;
 		ItemHandlerFactory *HandlersManager_;
 		QString Basename_;
+
+		QList<QDomElement> PageElements_;
+		QList<bool> PageBuilt_;
+		QHash<QString, int> Name2Page_;
+		QList<QPair<QString, QWidget*>> PendingCustoms_;
+		QHash<QString, QPointer<QAbstractItemModel>> PendingDataSources_;
 	public:
 		struct LangElements
 		{
@@ -246,16 +254,21 @@ namespace Util
 	private:
 		void HandleDeclaration (const QDomElement&);
 		void ParsePage (const QDomElement&);
+		void InitPageValues (const QDomElement&, int);
+		void BuildPage (int);
+		void BuildAllPages ();
 		void ParseItem (const QDomElement&, QWidget*);
 		void UpdateXml (bool = false);
 		void UpdateSingle (const QString&, const QVariant&, QDomElement&);
 		void SetValue (QWidget*, const QVariant&);
 	protected:
 		bool eventFilter (QObject*, QEvent*);
+		void showEvent (QShowEvent*);
 	public Q_SLOTS:
 		virtual void accept ();
 		virtual void reject ();
 	private Q_SLOTS:
+		void handlePageChanged (int);
 		void handleCustomDestroyed ();
 		void handleMoreThisStuffRequested ();
 		void handlePushButtonReleased ();